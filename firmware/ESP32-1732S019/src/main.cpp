@@ -15,7 +15,6 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WiFiUdp.h>
 #include <WebServer.h>
 #include <DNSServer.h>
 #include <ArduinoJson.h>
@@ -23,6 +22,10 @@
 #include <TFT_eSPI.h>
 #include <WiFiManager.h>
 #include <qrcode.h>
+#include <lwip/sockets.h>
+#include <atomic>
+#include "TallyProtocol.h"
+#include "NetJsonArena.h"
 
 // Firmware version
 #define FIRMWARE_VERSION "1.0.1"
@@ -56,11 +59,162 @@
 
 // Global objects
 TFT_eSPI tft = TFT_eSPI();
+
+// Frames are composed off-screen and pushed by displayTask() with DMA, so drawing never waits on
+// the 40 MHz SPI bus. Two full-frame sprites live in PSRAM: loop() draws into the back one (gDraw)
+// while the task pushes the front one in DISPLAY_BAND_ROWS bands, copying each band into one of two
+// internal DMA buffers while the previous band is on the wire. A frame submitted while a push is
+// running waits for it; a newer one replaces it. Build with -DDISPLAY_DIRECT to draw straight to
+// the panel as before (blocking), e.g. to compare the timings on /status.
+#define DISPLAY_BAND_ROWS 17            // 10 bands of 320x17 pixels, 10.9 KB per band buffer
+#define DISPLAY_TASK_STACK 3072
+#define DISPLAY_TASK_PRIORITY 2         // above loopTask (1) so the next band is queued promptly, below netRx (3)
+#define DISPLAY_TASK_CORE 1             // the UI core; netRx keeps core 0
+static TFT_eSprite gFrames[2] = { TFT_eSprite(&tft), TFT_eSprite(&tft) };
+static TFT_eSPI *gDraw = &tft;          // back frame between frameBegin() and frameSubmit(); the panel without DMA
+static uint8_t gBackFrame = 0;          // gFrames index loop() draws into, swapped by displayTask()
+static bool gFrameSubmitted = false;    // back frame complete and not yet taken by displayTask()
+static portMUX_TYPE gFrameMux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t *gBandBuf[2] = {};
+static TaskHandle_t gDisplayTaskHandle = nullptr; // null: drawing goes straight to the panel
+static unsigned long gComposeStartUs = 0;
+struct DisplayStats {
+  uint32_t frames;           // frames composed by loop()
+  uint32_t pushes;           // frames pushed to the panel (fewer when a waiting frame was replaced)
+  uint32_t lastBlockedUs;    // loop() time for the last frame: drawing, plus the SPI transfer without DMA
+  uint32_t maxBlockedUs;
+  uint32_t lastPushUs;       // displayTask(): first band copied to last band on the panel
+  uint32_t lastCopyUs;       // CPU time within that push (band copies); the rest is DMA
+};
+static DisplayStats gDisplayStats = {};
 WebServer server(80);
-WiFiUDP udp;
 Preferences preferences;
 WiFiManager wifiManager;
 
+// Hub traffic uses a raw lwIP UDP socket owned by a dedicated receive task (netRxTask).
+// The task blocks on the socket, drains every pending datagram, decodes it into a
+// fixed-size NetEvent and hands it to loop() through a lock-free single-producer /
+// single-consumer ring, so a burst from the hub no longer costs one loop() period per packet.
+#define UDP_LOCAL_PORT 7411             // same port as hub for both sending and receiving
+#ifndef NET_EVENT_QUEUE_LEN
+#define NET_EVENT_QUEUE_LEN 16          // must be a power of two
+#endif
+#define NET_RX_TASK_STACK 6144
+#define NET_RX_TASK_PRIORITY 3          // above loopTask (1), well below the Wi-Fi/lwIP tasks
+#define NET_RX_TASK_CORE 0              // keep socket work off the UI core
+#define NET_RX_TIMEOUT_MS 250           // recv timeout so reopen requests are noticed promptly
+#define NET_MCAST_TIMEOUT_MS 10000      // no multicast snapshot for this long -> back to unicast (hub refreshes every 2 s)
+#define NET_MCAST_RETRY_MS 300000       // how long to stay on unicast before offering multicast again
+
+enum NetEventType : uint8_t {
+  NET_EV_REGISTERED,
+  NET_EV_HEARTBEAT_ACK,
+  NET_EV_REGISTER_REQUIRED,
+  NET_EV_TALLY,
+  NET_EV_ADMIN_MESSAGE,
+  NET_EV_ASSIGNMENT,
+  NET_EV_SNAPSHOT,
+  NET_EV_SYNC_DONE
+};
+
+// Decoded hub message. Which fields are meaningful depends on type; strings are always NUL-terminated.
+struct NetEvent {
+  NetEventType type;
+  unsigned long receivedAt;  // millis() when the datagram was read off the socket
+  bool legacy;               // tally/assignment sent without the nested "data" object
+  bool program;              // tally
+  bool preview;              // tally
+  bool recording;            // tally
+  bool streaming;            // tally
+  bool assigned;             // assignment: mode == "assigned"
+  bool slotValid;            // snapshot: tally bits belong to our assigned slot / assignment, registered: slot supplied
+  bool resumed;              // registered: reply to a session resume, nothing to reset
+  bool fromStandby;          // sent by the standby hub (handled by handleStandbyEvent)
+  bool hasColor;             // admin_message: valid #RRGGBB supplied
+  uint16_t color;            // admin_message: background as RGB565
+  uint32_t duration;         // admin_message: ms (0 = default), register_required: retryAfter ms (0 = none), registered: sessionTtl ms,
+                             // sync_done: pages replayed
+  uint32_t seq;              // tally/snapshot: state version from the hub (0 = unsequenced), sync_done: snapshot seq
+  uint64_t sourceHash;       // tally: tallyHashSource() of the source id, filled for both encodings,
+                             // assignment: of the whole sourceId, which id may hold only in part
+  uint16_t slot;             // assignment, registered: snapshot slot of the assigned source
+  uint16_t slotEpoch;        // assignment, registered: slot table epoch the slot belongs to
+  uint32_t mcastGroup;       // registered: multicast group to join (network order, 0 = unicast only)
+  uint32_t echoT;            // heartbeat_ack: the heartbeat's "t" (device millis()), 0 = not echoed
+  uint32_t epoch;            // registered, heartbeat_ack: the hub's leadership epoch (0 = not stamped)
+  uint32_t features;         // registered: negotiated TALLY_CAP_* set (0 = hub predates negotiation)
+  char id[64];               // assignment sourceId / admin message id / registered session token
+  char name[96];             // assignment sourceName / admin message text
+};
+
+// Receive path counters. Most fields have a single writer, the net task or loop(), and are plain; a 64-bit
+// sum read by /status mid-update only skews a displayed average. sendErrors is bumped by udpSendTo() from
+// both tasks (loop sends, the net task acks duplicates), so it is atomic.
+struct NetRxStats {
+  uint32_t received;         // datagrams read from the socket
+  uint32_t dropped;          // decoded events discarded because the queue was full
+  uint32_t parseErrors;      // datagrams that were not a recognised hub message
+  uint32_t oversize;         // datagrams longer than TALLY_MAX_DATAGRAM, rejected without parsing
+  uint32_t socketErrors;     // recvfrom failures (socket gets reopened)
+  std::atomic<uint32_t> sendErrors; // sendto failures or unresolved hub address
+  uint32_t queueHighWater;   // deepest queue occupancy seen
+  unsigned long maxApplyLatencyMs; // worst receive -> state-applied delay seen by loop()
+  uint32_t binaryFrames;     // datagrams decoded via the binary tally frame path
+  uint32_t jsonFrames;       // datagrams decoded via deserializeJson
+  uint64_t binaryDecodeUs;   // cumulative decode time per path, for the averages on /status
+  uint64_t jsonDecodeUs;
+  uint32_t earlyRejects;     // JSON tally datagrams for other sources dropped by the raw pre-scan
+  uint64_t earlyRejectCycles; // CPU cycles spent on those, vs. jsonDecodeCycles for the full parse
+  uint64_t jsonDecodeCycles;
+  uint32_t seqStale;         // tally/snapshot versions older than the one already applied (reordered)
+  uint32_t seqDuplicates;    // same version received again
+  uint32_t seqGaps;          // versions skipped between two applied ones (lost datagrams)
+  uint32_t seqResyncs;       // large backwards jumps taken as a hub restart
+  uint32_t mcastFrames;      // snapshots received through the multicast group
+  uint32_t mcastFallbacks;   // times the group went quiet and the device fell back to unicast
+  uint32_t probeTimeouts;    // heartbeats not acknowledged within the RTO
+  uint32_t standbyDropped;   // standby hub datagrams other than heartbeat_ack / registered / register_required
+  uint32_t unnegotiated;     // tally in a format the hub did not negotiate, dropped unparsed
+  uint32_t deduplicated;     // tally datagrams identical to the last one for their source, dropped before decoding
+  uint32_t tallyApplied;     // tally/snapshot versions that passed the sequence check and were applied
+};
+static NetRxStats gNetStats = {};
+
+static NetEvent gNetQueue[NET_EVENT_QUEUE_LEN];
+static std::atomic<uint32_t> gNetQueueHead(0); // next slot written by the net task
+static std::atomic<uint32_t> gNetQueueTail(0); // next slot read by loop()
+
+static int gUdpSock = -1;                      // only the net task opens/closes it
+static uint32_t gMcastJoined = 0;              // group the socket is a member of (net task only)
+static std::atomic<uint32_t> gMcastGroup(0);   // group the hub handed out, 0 = unicast (written by the net task)
+static std::atomic<uint32_t> gMcastLastRx(0);  // millis() of the last multicast snapshot or of the join
+static std::atomic<uint32_t> gNetDupRxAt(0);   // millis() of the latest deduplicated tally datagram, 0 = taken by loop()
+static TallyDedupCache gNetDedup = {};         // net task only
+static std::atomic<uint32_t> gHubFeatures(0);    // TALLY_CAP_* set the hub negotiated in "registered" (0 = none, accept all)
+static std::atomic<uint32_t> gStandbyHubAddr(0); // standby hub IPv4, network order (0 = none; see publishStandbyHub)
+static std::atomic<uint32_t> gStandbyHubPort(0); // and its UDP port, network order
+static SemaphoreHandle_t gUdpSockMutex = nullptr; // guards gUdpSock against sends during a reopen
+static volatile bool gNetReopenRequested = false;
+
+// Snapshot slot of the assigned source as (epoch << 16 | slot). Written by the net task as assignment
+// messages are decoded, so every later snapshot in the same stream is read with the right slot.
+#define NET_NO_SLOT_KEY 0xFFFFFFFFUL
+static std::atomic<uint32_t> gAssignedSlotKey(NET_NO_SLOT_KEY);
+
+// assignedSourceHash, published by internAssignedSource() and by the net task as it
+// decodes assignments. Tally updates for any other source are dropped on the net task.
+static std::atomic<uint64_t> gAssignedHash(0);
+static TaskHandle_t gNetRxTaskHandle = nullptr;
+static TaskHandle_t gLoopTaskHandle = nullptr; // woken whenever an event is queued or the BOOT button changes
+
+// loop() sleeps on its task notification until the earliest deadline registered during the pass
+// (loopWakeAt), capped at LOOP_IDLE_MAX_MS so the web portal's handleClient() stays responsive.
+// The net task notifies on every queued hub message and the BOOT button ISR on every edge.
+#define LOOP_IDLE_MAX_MS 250
+#define LOOP_UI_TICK_MS 50        // overlays and a held button keep the old loop period
+static uint32_t gLoopSleepMs = LOOP_IDLE_MAX_MS;
+static uint32_t gLoopPasses = 0;
+
 // Configuration variables
 String deviceName = "ESP32 Tally Light";
 String deviceID = "tally-";
@@ -72,6 +226,12 @@ String assignedSource = "";
 String assignedSourceName = ""; // The human-readable name of the assigned source
 String currentSource = ""; // Current source display name (cleaned)
 String customDisplayName = ""; // Custom display name set via web portal
+uint64_t assignedSourceHash = 0; // tallyHashSource(assignedSource), interned once per assignment change
+String assignedDisplayName = ""; // cleaned assignedSourceName (or id), computed once per assignment change
+uint32_t lastTallySeq = 0;    // last applied state version of the assigned source (0 = none since assignment)
+uint32_t lastSnapshotSeq = 0; // last applied snapshot version (0 = none since registration)
+bool multicastSuspended = false;       // multicast went quiet; registering with mcast:false until the retry
+unsigned long multicastSuspendedAt = 0;
 String currentStatus = "INIT";
 bool isConnected = false;
 bool isRegisteredWithHub = false;
@@ -89,17 +249,123 @@ unsigned long lastDisplayUpdate = 0;
 unsigned long bootTime = 0;
 unsigned long lastHubResponse = 0;
 unsigned long hubConnectionAttempts = 0;
-unsigned long lastReconnectionAttempt = 0;
-unsigned long lastWiFiCheck = 0;
+String hubSession = "";                 // resume token from the last full registration ("" = none)
+unsigned long hubSessionTtl = 0;        // the hub keeps the session this long after it last heard from us
+unsigned long hubSessionSeenAt = 0;     // last hub message (lastHubResponse is also reset on Wi-Fi joins)
+uint32_t sessionResumes = 0;
+
+// Optional standby hub. It holds a passive registration of its own (`standby: true`: the hub sends it only
+// registered and heartbeat_ack), kept alive by a heartbeat every STANDBY_HEARTBEAT_MS, so failing over is a
+// swap of endpoints and a resume rather than a register round trip. Anything else it sends is dropped on the
+// net task. Hubs stamp a leadership "epoch" on their JSON messages and the device follows the live hub with
+// the higher one (see standbyStep).
+struct StandbyHub {
+  String ip;                // "" = none configured (an IP address; this path does no DNS)
+  int port;
+  bool registered;          // it has confirmed our registration and answers heartbeats
+  uint32_t epoch;           // leadership epoch from its last registered / heartbeat_ack
+  unsigned long lastRx;     // millis() of its last message
+  unsigned long nextTxAt;   // next heartbeat or registration attempt
+  uint32_t attempts;        // unanswered registrations, for tallyBackoffMs()
+  String session;           // resume token it handed out
+  uint32_t slotKey;         // its snapshot slot key for our source (NET_NO_SLOT_KEY = none)
+  uint32_t features;        // TALLY_CAP_* set it negotiated in its "registered"
+};
+StandbyHub standbyHub = { "", 7411, false, 0, 0, 0, 0, "", NET_NO_SLOT_KEY, 0 };
+uint32_t hubEpoch = 0;                  // leadership epoch of the active hub (0 = not stamped)
+uint32_t hubFailovers = 0;              // switches to the standby hub
+const unsigned long STANDBY_HEARTBEAT_MS = 10000;
+const unsigned long STANDBY_ALIVE_MS = 3 * STANDBY_HEARTBEAT_MS + 5000;
 unsigned long lastUDPRestart = 0;
-const unsigned long HEARTBEAT_INTERVAL = 30000;
-const unsigned long WIFI_CHECK_INTERVAL = 5000; // Check WiFi every 5 seconds (improved from 30s)
+const unsigned long HEARTBEAT_INTERVAL = 30000; // starting heartbeat interval (see heartbeatIntervalMs)
 const unsigned long UDP_RESTART_INTERVAL = 600000; // Restart UDP every 10 minutes (reduced frequency)
 // Removed DISPLAY_UPDATE_INTERVAL; display updates are now event-driven like M5Stick
 const unsigned long HUB_TIMEOUT = 60000; // 60 seconds timeout (increased from 15s)
-const unsigned long MAX_HUB_RECONNECT_ATTEMPTS = 5;
-const unsigned long MIN_RECONNECTION_INTERVAL = 15000; // 15 seconds between attempts
+const unsigned long MAX_HUB_RECONNECT_ATTEMPTS = 5; // unanswered attempts before the display says "Hub Lost"
+uint32_t gBackoffRng = 1;                           // per-device jitter generator, seeded from the MAC in setup()
 const unsigned long CONNECTION_CHECK_INTERVAL = 2000; // Check connection every 2 seconds
+
+// Where the last successful join landed. A directed rejoin (WiFi.begin with BSSID and channel) skips the
+// scan, and the DHCP lease is reused as static config so no DHCP exchange is needed either. valid = 0 until
+// a join succeeds, and again after a directed join fails.
+struct WiFiFastJoin {
+  uint8_t valid;
+  uint8_t channel;
+  uint8_t bssid[6];
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+WiFiFastJoin wifiFastJoin = {};
+String wifiFastJoinSsid = "";
+
+// Timing of the most recent Wi-Fi join attempt, from the STA events (shown on /status)
+struct WiFiJoinTiming {
+  unsigned long beganAt;   // WiFi.begin() (or boot, for the WiFiManager join)
+  unsigned long assocMs;   // begin -> associated
+  unsigned long ipMs;      // associated -> got IP (about 0 with a cached lease)
+  bool directed;           // BSSID and channel from the fast-join cache, no scan
+  bool cachedLease;        // static config from the cached DHCP lease
+};
+WiFiJoinTiming lastJoin = {};
+
+// Connection manager. connStep() runs once per loop() pass and only ever checks a timestamp or a status,
+// so Wi-Fi rejoins and hub retries happen in the background while the display and portal keep running.
+// (No discovery state: this board is configured with the hub address.)
+enum ConnState : uint8_t {
+  CONN_WIFI_JOINING,  // WiFi.begin() with the stored credentials, waiting to associate
+  CONN_REGISTERING,   // register sent, waiting for "registered"
+  CONN_REGISTERED,    // normal operation; checkHubLiveness() watches the hub from here
+  CONN_BACKOFF,       // waiting before the next Wi-Fi attempt or hub attempt
+};
+static const char *const CONN_STATE_NAMES[] = { "WiFi Joining", "Registering", "Registered", "Backoff" };
+ConnState connState = CONN_WIFI_JOINING;
+unsigned long connStateSince = 0;
+unsigned long connDeadline = 0;          // millis() at which the current state gives up or moves on
+bool wifiEverConnected = false;          // network services are set up on the first join
+int wifiReconnectAttempts = 0;
+unsigned long bootToRegisteredMs = 0;    // power-on to first "registered" (what a tally needs to show)
+const unsigned long CONN_WIFI_JOIN_TIMEOUT_MS = 15000;
+const unsigned long CONN_WIFI_DIRECT_TIMEOUT_MS = 4000; // directed rejoin from the fast-join cache, then a normal join
+const unsigned long CONN_WIFI_RETRY_MS = 30000;        // between Wi-Fi attempts
+const int CONN_WIFI_MAX_ATTEMPTS = 10;                 // then restart the device
+const unsigned long CONN_REGISTER_TIMEOUT_MS = 3000;   // wait for "registered" before backing off
+const unsigned long CONN_HUB_LOST_HOLD_MS = 2000;      // show "Hub Lost" at least this long before reconnecting
+
+// Hub liveness. Heartbeats double as probes: each ack is an RTT sample and an unacked probe is retried after
+// the RTO; LIVENESS_MAX_MISSES in a row declare the hub lost. While this display is in PROGRAM or PREVIEW a
+// probe goes out after LIVENESS_ACTIVE_PROBE_MS without hub traffic; HUB_TIMEOUT stays as the backstop.
+#define LIVENESS_ACTIVE_PROBE_MS 300
+#define LIVENESS_MAX_MISSES 3
+static TallyRtt gHubRtt = {};
+static uint32_t gProbeOutstanding = 0;  // "t" of the unacknowledged heartbeat, 0 = none
+static unsigned long gProbeSentAt = 0;
+static uint8_t gProbeMisses = 0;
+static bool gProbeRetried = false;      // the outstanding probe is a retry after a timeout
+bool hubLinkLost = false;               // probes went unanswered; show HUB LOST until the hub answers again
+
+// The regular heartbeat adapts to the link. Each probe acknowledged first time stretches the interval by
+// HEARTBEAT_STEP_MS up to HEARTBEAT_MAX_MS. A timeout halves it, but not below HEARTBEAT_MIN_MS. The maximum
+// plus three RTO retries stays inside HUB_TIMEOUT. Any other exchange that carries a probe (an
+// admin_message_ack, a registration) counts as the interval's heartbeat, so a busy device sends none.
+const unsigned long HEARTBEAT_MIN_MS = 15000;
+const unsigned long HEARTBEAT_MAX_MS = 45000;
+const unsigned long HEARTBEAT_STEP_MS = 5000;
+unsigned long heartbeatIntervalMs = HEARTBEAT_INTERVAL;
+uint32_t heartbeatsSent = 0;            // regular heartbeats (probes and retries not counted)
+uint32_t heartbeatsPiggybacked = 0;     // intervals covered by a probe riding on another message
+std::atomic<uint32_t> tallyAcksSent(0); // tally_ack replies; the net task acks retransmitted duplicates again
+
+// Tally sync after registering (TALLY_CAP_SYNC): the "Connecting..." overlay stays up until sync_done
+const char *const SYNC_SCOPE = "assigned";  // no live source line on this board
+const uint8_t SYNC_MAX_ATTEMPTS = 2;    // each waits one RTO for sync_done
+bool syncPending = false;
+bool syncAfterResume = false;           // the overlay simply ends afterwards, no "Connected"
+uint8_t syncAttempts = 0;
+unsigned long syncRequestedAt = 0;
+unsigned long lastSyncMs = 0;           // first request to sync_done, for /status
+uint32_t syncsCompleted = 0;
 const unsigned long DISCONNECTED_DISPLAY_DELAY = 1000; // Show disconnected after 1 second
 
 // Registration status display
@@ -123,18 +389,46 @@ bool confirmationIsAssigned = false;
 
 // Function declarations
 void setupDisplay();
+void loopWakeAt(unsigned long deadline);
+void loopWakeIn(unsigned long ms);
+void attachButtonWakeups();
 void setupWiFi();
 void setupWebServer();
 void loadConfiguration();
 void saveConfiguration();
-void registerDevice();
-void sendHeartbeat();
+void registerDevice(bool standby = false);
+void sendHeartbeat(bool probeOnly = false);
+void attachLivenessProbe(JsonDocument &doc);
+void sendTallyAck(bool snapshot, uint32_t seq);
+bool requestTallySync(bool resumed);
+void syncStep();
+void finishTallySync(bool answered);
+void checkHubLiveness();
+void declareHubLost(const char *reason);
+static bool standbyAlive();
+static void switchToStandby(const char *reason, bool oldRegistered, uint32_t retryMs);
+void checkMulticastDelivery();
 void handleUDPMessages();
+void applyHubEvent(const NetEvent &ev);
+bool acceptTallySeq(uint32_t &lastSeq, uint32_t seq);
+void startNetRxTask();
+static bool netQueuePop(NetEvent &ev);
+static uint32_t netQueueDepth();
+bool udpSendTo(IPAddress ip, uint16_t port, const String &message);
+bool sendToHub(const String &message);
+bool sendToStandbyHub(const String &message);
+void publishStandbyHub();
+void standbyStep();
 void updateDisplay();
 void displayWiFiQRCode(const String& apName);
 void updateStatus(const String& status);
 void showStatus(const String& status, uint16_t bgColor, uint16_t textColor = COLOR_WHITE);
+void composeDisplay();
 void showBootScreen();
+void startDisplayPipeline();
+void displayTask(void *);
+void frameBegin();
+void frameSubmit();
 void handleRoot();
 void handleConfig();
 void handleSave();
@@ -148,10 +442,15 @@ void handleRestart();
 void handleNotFound();
 String formatUptime();
 String cleanSourceName(String sourceName);
+void internAssignedSource(uint64_t sourceHash = 0);
 void checkButtonForWiFiReset();
-void reconnectWiFi();
+void connBegin();
+void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+void connStep();
+void connEnter(ConnState state, unsigned long timeoutMs);
+void connStartRegistering();
+bool resumeHubSession();
 void restartUDP();
-void checkWiFiConnection();
 void ensureUDPConnection();
 
 // --- Button press tracking for WiFi reset ---
@@ -168,6 +467,7 @@ void setup() {
   bootTime = millis();
   // Initialize display first
   setupDisplay();
+  attachButtonWakeups(); // BOOT button edges wake loop() out of its sleep
   showBootScreen();
   // Generate device ID from MAC address
   macAddress = WiFi.macAddress();
@@ -176,165 +476,302 @@ void setup() {
   deviceID.toLowerCase();
   Serial.println("Device ID: " + deviceID);
   Serial.println("MAC Address: " + macAddress);
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  gBackoffRng = tallyBackoffSeed(mac); // hub retry jitter differs per device
   // Load saved configuration
   loadConfiguration();
   // Setup WiFi connection
   setupWiFi();
-  // Setup network services
-  if (WiFi.status() == WL_CONNECTED) {
-    ipAddress = WiFi.localIP().toString();
-    Serial.println("IP Address: " + ipAddress);
+  // Network services and registration start from connStep() once Wi-Fi is up (straight away if it already is)
+  connBegin();
+  delay(1000);
+}
+
+// ---------------------------------------------------------------
+// Connection manager
+// ---------------------------------------------------------------
+
+static bool gConnWiFiBackoff = false;  // CONN_BACKOFF is waiting for the next Wi-Fi attempt, not a hub retry
+static bool gConnReconnecting = false; // lost a hub we were registered with (display says "Reconnecting...")
+static bool gConnDirected = false;     // the current join is the directed one
+static bool gStaticLeaseActive = false; // WiFi.config() holds a cached lease; undo before DHCP joins
+static unsigned long gLeaseJoinedAt = 0; // join on a cached lease came up, waiting for the hub (0 = not)
+static bool gLeaseRenewing = false;     // DHCP took over from the cached lease, waiting for its address
+const unsigned long LEASE_VERIFY_MS = 5000; // the hub must answer on a cached lease within this
+static volatile unsigned long gWifiAssocAt = 0; // set from the WiFi event task
+static volatile unsigned long gWifiGotIpAt = 0;
+
+void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+    gWifiAssocAt = millis();
+  } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    gWifiGotIpAt = millis();
+  }
+}
+
+static void saveFastJoin(const WiFiFastJoin &fast, const String &ssid) {
+  if (memcmp(&fast, &wifiFastJoin, sizeof(fast)) == 0 && ssid == wifiFastJoinSsid) return;
+  wifiFastJoin = fast;
+  wifiFastJoinSsid = ssid;
+  preferences.begin("tally", false);
+  preferences.putBytes("wifiFj", &wifiFastJoin, sizeof(wifiFastJoin));
+  preferences.putString("wifiFjSsid", wifiFastJoinSsid);
+  preferences.end();
+}
+
+void connEnter(ConnState state, unsigned long timeoutMs) {
+  if (state != connState) {
+    Serial.printf("Connection: %s -> %s\n", CONN_STATE_NAMES[connState], CONN_STATE_NAMES[state]);
+  }
+  connState = state;
+  gConnWiFiBackoff = false;
+  connStateSince = millis();
+  connDeadline = connStateSince + timeoutMs;
+}
+
+// Cache where this join landed so the next rejoin can be directed
+static void saveCurrentFastJoin() {
+  WiFiFastJoin fast = {};
+  fast.valid = 1;
+  fast.channel = (uint8_t)WiFi.channel();
+  const uint8_t *bssid = WiFi.BSSID();
+  if (bssid != nullptr) memcpy(fast.bssid, bssid, sizeof(fast.bssid));
+  fast.ip = (uint32_t)WiFi.localIP();
+  fast.gateway = (uint32_t)WiFi.gatewayIP();
+  fast.subnet = (uint32_t)WiFi.subnetMask();
+  fast.dns = (uint32_t)WiFi.dnsIP(0);
+  saveFastJoin(fast, WiFi.SSID());
+}
+
+static void connUseDhcp() {
+  if (!gStaticLeaseActive) return;
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0)); // back to DHCP
+  gStaticLeaseActive = false;
+}
+
+static void connOnWiFiUp() {
+  ipAddress = WiFi.localIP().toString();
+  unsigned long assocAt = gWifiAssocAt != 0 ? gWifiAssocAt : millis();
+  unsigned long gotIpAt = gWifiGotIpAt != 0 ? gWifiGotIpAt : millis();
+  lastJoin.assocMs = assocAt - lastJoin.beganAt;
+  lastJoin.ipMs = gotIpAt > assocAt ? gotIpAt - assocAt : 0;
+  Serial.printf("WiFi connected, IP Address: %s (%s join: assoc %lu ms, IP %lu ms%s)\n", ipAddress.c_str(),
+                lastJoin.directed ? "directed" : "full", lastJoin.assocMs, lastJoin.ipMs,
+                lastJoin.cachedLease ? " cached lease" : "");
+
+  saveCurrentFastJoin();
+  if (lastJoin.cachedLease) gLeaseJoinedAt = millis() | 1;
+  wifiReconnectAttempts = 0;
+  hubConnectionAttempts = 0;
+  // Don't set isConnected here - wait for hub registration confirmation
+  // Initialize lastHubResponse to current time for initial connection attempts
+  lastHubResponse = millis();
+
+  if (!wifiEverConnected) {
     setupWebServer();
-    // Start UDP - use same port as hub for both sending and receiving
-    if (udp.begin(7411)) {
-      Serial.println("UDP started on port 7411");
-    } else {
-      Serial.println("Failed to start UDP");
-    }
-    // Don't set isConnected here - wait for hub registration confirmation
-    // Initialize lastHubResponse to current time for initial connection attempts
-    lastHubResponse = millis();
-    registerDevice();
-    updateStatus("READY");
+    wifiEverConnected = true;
+  }
+  // Start (or rebind) the UDP receive task - same port as hub for both sending and receiving
+  restartUDP();
+  updateStatus("READY");
+  connStartRegistering();
+}
+
+// One timed join. directed: straight to the cached BSSID/channel with the cached lease; otherwise a normal
+// join (scan + DHCP) with the credentials WiFiManager stored
+static void connWiFiBegin(bool directed) {
+  bool useLease = false;
+#ifndef WIFI_NO_CACHED_LEASE
+  useLease = directed && wifiFastJoin.ip != 0;
+#endif
+  WiFi.disconnect();
+  WiFi.mode(WIFI_STA);
+  if (useLease) {
+    WiFi.config(IPAddress(wifiFastJoin.ip), IPAddress(wifiFastJoin.gateway), IPAddress(wifiFastJoin.subnet), IPAddress(wifiFastJoin.dns));
+    gStaticLeaseActive = true;
+  } else {
+    connUseDhcp();
+  }
+  gLeaseJoinedAt = 0;
+  gLeaseRenewing = false;
+
+  lastJoin = {};
+  lastJoin.beganAt = millis();
+  lastJoin.directed = directed;
+  lastJoin.cachedLease = useLease;
+  gWifiAssocAt = 0;
+  gWifiGotIpAt = 0;
+  gConnDirected = directed;
+  if (directed) {
+    Serial.printf("Directed join: %s on channel %u\n", wifiFastJoinSsid.c_str(), wifiFastJoin.channel);
+    WiFi.begin(wifiFastJoinSsid.c_str(), WiFi.psk().c_str(), wifiFastJoin.channel, wifiFastJoin.bssid);
+    connEnter(CONN_WIFI_JOINING, CONN_WIFI_DIRECT_TIMEOUT_MS);
+  } else {
+    WiFi.begin();
+    connEnter(CONN_WIFI_JOINING, CONN_WIFI_JOIN_TIMEOUT_MS);
+  }
+}
+
+static void connStartWiFiJoin() {
+  wifiReconnectAttempts++;
+  Serial.printf("WiFi reconnection attempt %d/%d\n", wifiReconnectAttempts, CONN_WIFI_MAX_ATTEMPTS);
+  connWiFiBegin(wifiFastJoin.valid && wifiFastJoinSsid.length() > 0);
+}
+
+void connBegin() {
+  WiFi.setAutoReconnect(false); // every rejoin goes through the connection manager
+  if (WiFi.status() == WL_CONNECTED) {
+    connOnWiFiUp();
   } else {
+    // setupWiFi() already tried (and ran the portal); leave the stack's auto-reconnect one window first
     updateStatus("NO_WIFI");
+    connEnter(CONN_WIFI_JOINING, CONN_WIFI_JOIN_TIMEOUT_MS);
   }
-  delay(1000);
 }
 
-void checkHubConnection() {
-  // Only check if we're connected to WiFi
-  if (WiFi.status() != WL_CONNECTED) {
-    if (isConnected || isRegisteredWithHub) {
-      Serial.println("WiFi lost - marking as disconnected");
-      isConnected = false;
-      isRegisteredWithHub = false;
-      updateStatus("NO_WIFI");
-    }
+static void connStartHubAttempt() {
+  hubConnectionAttempts++;
+  Serial.printf("Attempting hub connection/reconnection (attempt %lu)\n", hubConnectionAttempts);
+
+  showingRegistrationStatus = true;
+  registrationStatusStart = millis();
+  registrationStatusMessage = gConnReconnecting ? "Reconnecting..." : "Connecting...";
+  registrationStatusColor = COLOR_YELLOW;
+
+  connStartRegistering();
+}
+
+void connStartRegistering() {
+  if (!resumeHubSession()) registerDevice();
+  // Don't reset lastHubResponse here - only reset when we get an actual response
+  connEnter(CONN_REGISTERING, CONN_REGISTER_TIMEOUT_MS);
+}
+
+static void showHubLost() {
+  showingRegistrationStatus = true;
+  registrationStatusStart = millis();
+  registrationStatusMessage = "Hub Lost";
+  registrationStatusColor = COLOR_RED;
+}
+
+// Registration went unanswered: wait a jittered, exponentially growing time (tallyBackoffMs) before the next
+// attempt, so devices that lost the hub together do not all come back in the same instant
+static void connHubBackoff() {
+  uint32_t wait = tallyBackoffMs(hubConnectionAttempts, gBackoffRng);
+  Serial.printf("Hub retry in %lu ms\n", (unsigned long)wait);
+  if (hubConnectionAttempts >= MAX_HUB_RECONNECT_ATTEMPTS) showHubLost();
+  connEnter(CONN_BACKOFF, wait);
+}
+
+// register_required: the hub has forgotten us (it restarted, or pruned us as stale). Honour its retryAfter,
+// plus up to a quarter of it again as jitter, then register; a hub that sends none gets a first backoff step.
+static void connDeferRegistration(uint32_t retryAfterMs) {
+  isRegisteredWithHub = false;
+  gConnReconnecting = true;
+  if (retryAfterMs > TALLY_RETRY_AFTER_MAX_MS) retryAfterMs = TALLY_RETRY_AFTER_MAX_MS;
+  uint32_t wait = retryAfterMs > 0 ? retryAfterMs + tallyBackoffNext(gBackoffRng) % (retryAfterMs / 4 + 1)
+                                   : tallyBackoffMs(0, gBackoffRng);
+  Serial.printf("Re-registering in %lu ms\n", (unsigned long)wait);
+  connEnter(CONN_BACKOFF, wait);
+}
+
+// A cached lease installed as static config is never renewed and may not fit the network any more (a new
+// subnet, gateway or DHCP pool). Once a join on one is up, the hub has LEASE_VERIFY_MS to confirm our
+// registration; then DHCP takes the address over and renews it from there, normally handing the same address
+// back. A lease the hub did not answer on is forgotten, so the next directed join waits for DHCP instead.
+static void connLeaseStep(unsigned long now) {
+  if (gLeaseRenewing) {
+    if (gWifiGotIpAt == 0) return;
+    gLeaseRenewing = false;
+    ipAddress = WiFi.localIP().toString();
+    Serial.printf("DHCP took over the cached lease: IP %s\n", ipAddress.c_str());
+    saveCurrentFastJoin();
+    return;
+  }
+  if (gLeaseJoinedAt == 0) return;
+  if (!isRegisteredWithHub && now - gLeaseJoinedAt < LEASE_VERIFY_MS) {
+    loopWakeAt(gLeaseJoinedAt + LEASE_VERIFY_MS);
     return;
   }
-  
-  // If we're not registered with hub, try to connect/reconnect
   if (!isRegisteredWithHub) {
-    // Don't attempt reconnection too frequently
-    unsigned long timeSinceLastAttempt = millis() - lastReconnectionAttempt;
-    if (timeSinceLastAttempt < MIN_RECONNECTION_INTERVAL) {
-      return; // Not enough time passed, skip this attempt
-    }
-    
-    // Don't attempt reconnection too frequently or indefinitely
-    if (hubConnectionAttempts < MAX_HUB_RECONNECT_ATTEMPTS) {
-      hubConnectionAttempts++;
-      lastReconnectionAttempt = millis();
-      Serial.printf("Attempting hub connection/reconnection (attempt %lu/%lu)\n", hubConnectionAttempts, MAX_HUB_RECONNECT_ATTEMPTS);
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Connecting...";
-      registrationStatusColor = COLOR_YELLOW;
-      
-      // Attempt to register with the hub
-      delay(1000); // Brief delay before attempting connection
-      registerDevice();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
-    } else {
-      Serial.println("Max quick reconnection attempts reached, switching to slow retry mode");
-      
-      // Reset attempt counter every 5 minutes to keep trying
-      static unsigned long lastAttemptReset = 0;
-      if (millis() - lastAttemptReset > 300000) { // 5 minutes
-        Serial.println("Resetting reconnection attempts - continuing to try...");
-        hubConnectionAttempts = 0;
-        lastAttemptReset = millis();
-        return; // Let the next call handle the reconnection
-      }
-      
-      lastReconnectionAttempt = millis();
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Hub Lost";
-      registrationStatusColor = COLOR_RED;
-      
-      isConnected = false;
-      isRegisteredWithHub = false;
-      
-      // Continue trying with longer delays
-      delay(10000); // Wait 10 seconds before next attempt
-      Serial.println("Attempting slow reconnection...");
-      registerDevice();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
-    }
+    Serial.println("No hub answer on the cached lease, dropping it");
+    WiFiFastJoin fast = wifiFastJoin;
+    fast.ip = 0;
+    saveFastJoin(fast, wifiFastJoinSsid);
+  }
+  gLeaseJoinedAt = 0;
+  gWifiGotIpAt = 0;
+  gLeaseRenewing = true;
+  connUseDhcp();
+}
+
+void connStep() {
+  unsigned long now = millis();
+  bool wifiUp = WiFi.status() == WL_CONNECTED;
+  if (wifiUp) connLeaseStep(now);
+
+  if (!wifiUp && connState != CONN_WIFI_JOINING && !gConnWiFiBackoff) {
+    Serial.println("WiFi lost - marking as disconnected");
+    isConnected = false;
+    isRegisteredWithHub = false;
+    updateStatus("NO_WIFI");
+    connStartWiFiJoin();
     return;
   }
-  
-  // If we're registered, check for timeout
-  unsigned long timeSinceLastResponse = millis() - lastHubResponse;
-  if (timeSinceLastResponse > HUB_TIMEOUT) {
-    // Don't attempt reconnection too frequently
-    unsigned long timeSinceLastAttempt = millis() - lastReconnectionAttempt;
-    if (timeSinceLastAttempt < MIN_RECONNECTION_INTERVAL) {
-      return; // Not enough time passed, skip this attempt
+
+  switch (connState) {
+  case CONN_WIFI_JOINING:
+    if (wifiUp) {
+      connOnWiFiUp();
+    } else if ((long)(now - connDeadline) >= 0 && gConnDirected) {
+      // The AP moved, changed channel or is gone: forget it and do a normal join in the same attempt
+      Serial.println("Directed join failed, falling back to a full join");
+      WiFiFastJoin none = {};
+      saveFastJoin(none, "");
+      connWiFiBegin(false);
+    } else if ((long)(now - connDeadline) >= 0) {
+      Serial.println("WiFi reconnection failed");
+      if (wifiReconnectAttempts >= CONN_WIFI_MAX_ATTEMPTS) {
+        Serial.println("Max reconnection attempts reached, restarting device...");
+        ESP.restart();
+      }
+      connEnter(CONN_BACKOFF, CONN_WIFI_RETRY_MS - CONN_WIFI_JOIN_TIMEOUT_MS);
+      gConnWiFiBackoff = true;
     }
-    
-    Serial.printf("Hub connection timeout (%lu ms since last response)\n", timeSinceLastResponse);
-    
-    // Immediately mark as not registered to show HUB LOST
-    isRegisteredWithHub = false;
-    
-    // Don't attempt reconnection too frequently or indefinitely
-    if (hubConnectionAttempts < MAX_HUB_RECONNECT_ATTEMPTS) {
-      hubConnectionAttempts++;
-      lastReconnectionAttempt = millis();
-      Serial.printf("Attempting hub reconnection (attempt %lu/%lu)\n", hubConnectionAttempts, MAX_HUB_RECONNECT_ATTEMPTS);
-      
-      // Show HUB LOST status for a moment before attempting reconnection
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Hub Lost";
-      registrationStatusColor = COLOR_RED;
-      
-      // Wait 2 seconds to show HUB LOST status, then attempt reconnection
-      delay(2000);
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Reconnecting...";
-      registrationStatusColor = COLOR_YELLOW;
-      
-      // Attempt to re-register with the hub (don't restart UDP unnecessarily)
-      delay(1000); // Brief delay before attempting reconnection
-      
-      registerDevice();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
-    } else {
-      Serial.println("Max quick reconnection attempts reached, switching to slow retry mode");
-      
-      // Reset attempt counter every 5 minutes to keep trying
-      static unsigned long lastAttemptReset = 0;
-      if (millis() - lastAttemptReset > 300000) { // 5 minutes
-        Serial.println("Resetting reconnection attempts - continuing to try...");
-        hubConnectionAttempts = 0;
-        lastAttemptReset = millis();
-        return; // Let the next call handle the reconnection
+    break;
+
+  case CONN_REGISTERING:
+    if (isRegisteredWithHub) {
+      gConnReconnecting = false;
+      connEnter(CONN_REGISTERED, 0);
+    } else if ((long)(now - connDeadline) >= 0) {
+      connHubBackoff();
+    }
+    break;
+
+  case CONN_REGISTERED:
+    if (!isRegisteredWithHub) {
+      // Liveness declared the hub lost: show it, then reconnect. Every device sees a hub restart at about
+      // the same moment, so the hold is followed by a jittered first backoff step.
+      Serial.println("Hub connection lost - will trigger reconnection attempts");
+      showHubLost();
+      gConnReconnecting = true;
+      connEnter(CONN_BACKOFF, CONN_HUB_LOST_HOLD_MS + tallyBackoffMs(0, gBackoffRng));
+    }
+    break;
+
+  case CONN_BACKOFF:
+    if (isRegisteredWithHub) {
+      connEnter(CONN_REGISTERED, 0); // a late "registered" got through
+    } else if ((long)(now - connDeadline) >= 0) {
+      if (!wifiUp) {
+        connStartWiFiJoin();
+      } else {
+        connStartHubAttempt();
       }
-      
-      lastReconnectionAttempt = millis();
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Hub Lost";
-      registrationStatusColor = COLOR_RED;
-      
-      isConnected = false;
-      isRegisteredWithHub = false;
-      
-      // Continue trying with longer delays
-      delay(10000); // Wait 10 seconds before next attempt
-      Serial.println("Attempting slow reconnection...");
-      registerDevice();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
     }
+    break;
   }
 }
 
@@ -358,11 +795,7 @@ void monitorConnectionStatus() {
     if (WiFi.status() == WL_CONNECTED && (isConnected || isRegisteredWithHub)) {
       unsigned long timeSinceLastResponse = millis() - lastHubResponse;
       if (timeSinceLastResponse > HUB_TIMEOUT) {
-        Serial.println("Hub timeout detected in monitor - immediate response!");
-        isConnected = false;
-        isRegisteredWithHub = false;
-        updateStatus("HUB_LOST");
-        updateDisplay(); // Force immediate display update
+        declareHubLost("no hub traffic within HUB_TIMEOUT");
       }
     }
     
@@ -370,28 +803,45 @@ void monitorConnectionStatus() {
   }
 }
 
+// Ask the current loop() pass to run again no later than deadline (a millis() value)
+void loopWakeAt(unsigned long deadline) {
+  long remaining = (long)(deadline - millis());
+  uint32_t ms = remaining > 0 ? (uint32_t)remaining : 0;
+  if (ms < gLoopSleepMs) gLoopSleepMs = ms;
+}
+
+void loopWakeIn(unsigned long ms) {
+  loopWakeAt(millis() + ms);
+}
+
+static void IRAM_ATTR onButtonEdge() {
+  BaseType_t woken = pdFALSE;
+  if (gLoopTaskHandle != nullptr) vTaskNotifyGiveFromISR(gLoopTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void attachButtonWakeups() {
+  gLoopTaskHandle = xTaskGetCurrentTaskHandle();
+  attachInterrupt(digitalPinToInterrupt(BOOT_BUTTON_PIN), onButtonEdge, CHANGE);
+}
+
 void loop() {
+  gLoopSleepMs = LOOP_IDLE_MAX_MS;
+  gLoopPasses++;
+
   // --- Button handler for WiFi reset ---
   checkButtonForWiFiReset();
 
   // FAST connection monitoring - every 2 seconds
   monitorConnectionStatus();
 
-  // Check WiFi connection periodically and attempt reconnection
-  if (millis() - lastWiFiCheck > WIFI_CHECK_INTERVAL) {
-    checkWiFiConnection();
-    lastWiFiCheck = millis();
-  }
+  // Wi-Fi rejoin, hub registration and retries (never blocks)
+  connStep();
 
-  // Handle WiFi connection loss
+  // Nothing below needs the network; sleep until the connection manager's next deadline
   if (WiFi.status() != WL_CONNECTED) {
-    if (isConnected || isRegisteredWithHub) {
-      Serial.println("WiFi connection lost, resetting hub connection");
-      isConnected = false;
-      isRegisteredWithHub = false;
-    }
-    updateStatus("NO_WIFI");
-    delay(1000);
+    loopWakeAt(connDeadline);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(gLoopSleepMs));
     return;
   }
 
@@ -415,14 +865,13 @@ void loop() {
   // Handle UDP messages
   handleUDPMessages();
 
-  // Check hub connection and attempt reconnection if needed
-  checkHubConnection();
+  // Standby hub upkeep and failover
+  standbyStep();
+  syncStep();
+  checkMulticastDelivery();
 
-  // Send heartbeat only if we think we're connected
-  if (millis() - lastHeartbeat > HEARTBEAT_INTERVAL) {
-    sendHeartbeat();
-    lastHeartbeat = millis();
-  }
+  // Heartbeat / liveness probes (only while registered)
+  checkHubLiveness();
 
   // Update display only on meaningful state changes or every 30 seconds
   static bool lastProgram = false;
@@ -445,7 +894,8 @@ void loop() {
                      (assignedSource != lastAssignedSource) || (currentSource != lastCurrentSource) || 
                      (customDisplayName != lastCustomDisplayName) || (currentStatus != lastStatus) || 
                      (isAssigned != lastIsAssigned) || (isConnected != lastIsConnected) || 
-                     (isRegisteredWithHub != lastIsRegisteredWithHub);
+                     (isRegisteredWithHub != lastIsRegisteredWithHub) ||
+                     (adminMessageActive && millis() > adminMessageExpire); // updateDisplay() clears it
   
   // Only update display on meaningful state changes or after long interval
   if (stateChanged || (millis() - lastDisplayUpdate > displayInterval)) {
@@ -464,7 +914,15 @@ void loop() {
     lastIsRegisteredWithHub = isRegisteredWithHub;
   }
 
-  delay(50);
+  // Deadlines for the timers above; anything without one is picked up within LOOP_IDLE_MAX_MS
+  if (connState != CONN_REGISTERED) loopWakeAt(connDeadline);
+  loopWakeAt(lastDisplayUpdate + displayInterval + 1);
+  if (adminMessageActive) loopWakeAt(adminMessageExpire + 1);
+  if (buttonWasPressed) loopWakeAt(buttonPressStart + WIFI_RESET_HOLD_TIME + 1);
+  if (buttonWasPressed || showingAssignmentConfirmation || showingRegistrationStatus) loopWakeIn(LOOP_UI_TICK_MS);
+
+  // Sleep until the earliest deadline, a queued hub message or a button edge
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(gLoopSleepMs));
 }
 // --- Button handler for WiFi config reset (long press) ---
 void checkButtonForWiFiReset() {
@@ -475,14 +933,16 @@ void checkButtonForWiFiReset() {
       buttonWasPressed = true;
     } else if (millis() - buttonPressStart > WIFI_RESET_HOLD_TIME) {
       // Long press detected
-      tft.fillScreen(COLOR_RED);
-      tft.setTextColor(COLOR_WHITE);
-      tft.setTextSize(2);
-      tft.setCursor(30, SCREEN_HEIGHT / 2 - 20);
-      tft.print("WiFi RESET!");
-      tft.setTextSize(1);
-      tft.setCursor(30, SCREEN_HEIGHT / 2 + 10);
-      tft.print("Erasing WiFi config...");
+      frameBegin();
+      gDraw->fillScreen(COLOR_RED);
+      gDraw->setTextColor(COLOR_WHITE);
+      gDraw->setTextSize(2);
+      gDraw->setCursor(30, SCREEN_HEIGHT / 2 - 20);
+      gDraw->print("WiFi RESET!");
+      gDraw->setTextSize(1);
+      gDraw->setCursor(30, SCREEN_HEIGHT / 2 + 10);
+      gDraw->print("Erasing WiFi config...");
+      frameSubmit();
       delay(1000);
       wifiManager.resetSettings();
       preferences.begin("tally", false);
@@ -508,9 +968,9 @@ void checkButtonForWiFiReset() {
         ack["timestamp"] = millis();
         ack["textSnippet"] = snippet;
   if (adminMessageId.length() > 0) ack["id"] = adminMessageId;
+        attachLivenessProbe(ack);
         String payload; serializeJson(ack, payload);
-        int r = udp.beginPacket(hubIP.c_str(), hubPort);
-        if (r==1) { udp.print(payload); udp.endPacket(); }
+        sendToHub(payload);
         updateDisplay();
       }
     }
@@ -527,10 +987,104 @@ void setupDisplay() {
   digitalWrite(BACKLIGHT_PIN, HIGH);
   pinMode(BOOT_BUTTON_PIN, INPUT_PULLUP);
   
+#ifndef DISPLAY_DIRECT
+  startDisplayPipeline();
+#endif
   Serial.println("Display initialized");
 }
 
+// Allocate both frames and band buffers and start displayTask(); on any failure drawing stays direct
+void startDisplayPipeline() {
+  const size_t bandBytes = SCREEN_WIDTH * DISPLAY_BAND_ROWS * sizeof(uint16_t);
+  bool ok = true;
+  for (int i = 0; i < 2 && ok; ++i) {
+    gFrames[i].setColorDepth(16);
+    gFrames[i].setAttribute(PSRAM_ENABLE, true);
+    ok = gFrames[i].createSprite(SCREEN_WIDTH, SCREEN_HEIGHT) != nullptr;
+    gBandBuf[i] = ok ? (uint16_t*)heap_caps_malloc(bandBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL) : nullptr;
+    ok = ok && gBandBuf[i] != nullptr;
+  }
+  ok = ok && tft.initDMA();
+  if (ok) ok = xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, nullptr,
+                                       DISPLAY_TASK_PRIORITY, &gDisplayTaskHandle, DISPLAY_TASK_CORE) == pdPASS;
+  if (!ok) {
+    for (int i = 0; i < 2; ++i) {
+      gFrames[i].deleteSprite();
+      heap_caps_free(gBandBuf[i]);
+      gBandBuf[i] = nullptr;
+    }
+    gDisplayTaskHandle = nullptr;
+    Serial.println("Display: no PSRAM frames or DMA, drawing to the panel directly");
+    return;
+  }
+  for (int i = 0; i < 2; ++i) gFrames[i].fillSprite(COLOR_BLACK);
+  Serial.printf("Display: DMA pipeline, 2 x %dx%d frames in PSRAM, %d-row bands\n", SCREEN_WIDTH, SCREEN_HEIGHT, DISPLAY_BAND_ROWS);
+}
+
+// Start composing a frame: everything until frameSubmit() draws through gDraw
+void frameBegin() {
+  gComposeStartUs = micros();
+  if (gDisplayTaskHandle == nullptr) return;
+  portENTER_CRITICAL(&gFrameMux);
+  gFrameSubmitted = false; // a frame still waiting for the task is about to be redrawn
+  gDraw = &gFrames[gBackFrame];
+  portEXIT_CRITICAL(&gFrameMux);
+}
+
+// Hand the composed frame to displayTask(); returns without waiting for the panel
+void frameSubmit() {
+  uint32_t blocked = micros() - gComposeStartUs;
+  gDisplayStats.frames++;
+  gDisplayStats.lastBlockedUs = blocked;
+  if (blocked > gDisplayStats.maxBlockedUs) gDisplayStats.maxBlockedUs = blocked;
+  if (gDisplayTaskHandle == nullptr) { gDisplayStats.pushes++; return; } // already on the panel
+  portENTER_CRITICAL(&gFrameMux);
+  gFrameSubmitted = true;
+  portEXIT_CRITICAL(&gFrameMux);
+  xTaskNotifyGive(gDisplayTaskHandle);
+}
+
+static void pushFrameDMA(TFT_eSprite &frame) {
+  const uint16_t *img = (const uint16_t*)frame.getPointer();
+  unsigned long start = micros();
+  uint32_t copyUs = 0;
+  tft.startWrite();
+  for (int y = 0, band = 0; y < SCREEN_HEIGHT; y += DISPLAY_BAND_ROWS, band ^= 1) {
+    int rows = min(DISPLAY_BAND_ROWS, SCREEN_HEIGHT - y);
+    // pushImageDMA() waits for the previous band before queuing the next, so by now the last
+    // transfer out of this buffer (two bands back) is finished
+    unsigned long t = micros();
+    memcpy(gBandBuf[band], img + y * SCREEN_WIDTH, rows * SCREEN_WIDTH * sizeof(uint16_t));
+    copyUs += micros() - t;
+    tft.pushImageDMA(0, y, SCREEN_WIDTH, rows, gBandBuf[band]);
+  }
+  tft.dmaWait();
+  tft.endWrite();
+  gDisplayStats.pushes++;
+  gDisplayStats.lastPushUs = micros() - start;
+  gDisplayStats.lastCopyUs = copyUs;
+}
+
+// Owns the panel: takes each submitted frame as the new front frame and pushes it
+void displayTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (;;) {
+      portENTER_CRITICAL(&gFrameMux);
+      bool take = gFrameSubmitted;
+      if (take) {
+        gFrameSubmitted = false;
+        gBackFrame ^= 1; // loop() composes the next frame into the one just pushed
+      }
+      portEXIT_CRITICAL(&gFrameMux);
+      if (!take) break;
+      pushFrameDMA(gFrames[gBackFrame ^ 1]);
+    }
+  }
+}
+
 void setupWiFi() {
+  WiFi.onEvent(onWiFiEvent); // times the boot join as well (lastJoin.beganAt = 0, i.e. from power-on)
   // Configure WiFi for better stability
   WiFi.mode(WIFI_STA);
   WiFi.setAutoConnect(true);
@@ -548,11 +1102,13 @@ void setupWiFi() {
 
   wifiManager.setSaveConfigCallback([]() {
     Serial.println("[WiFiManager] Config saved");
-    tft.fillScreen(COLOR_GREEN);
-    tft.setTextColor(COLOR_WHITE);
-    tft.setTextSize(2);
-    tft.setCursor(20, SCREEN_HEIGHT / 2 - 20);
-    tft.print("WiFi Saved");
+    frameBegin();
+    gDraw->fillScreen(COLOR_GREEN);
+    gDraw->setTextColor(COLOR_WHITE);
+    gDraw->setTextSize(2);
+    gDraw->setCursor(20, SCREEN_HEIGHT / 2 - 20);
+    gDraw->print("WiFi Saved");
+    frameSubmit();
     delay(1000);
   });
 
@@ -568,14 +1124,16 @@ void setupWiFi() {
   bool connected = wifiManager.autoConnect(apName.c_str());
   if (!connected) {
     Serial.println("[WiFiManager] Failed to connect or no credentials. Starting AP mode.");
-    tft.fillScreen(COLOR_RED);
-    tft.setTextColor(COLOR_WHITE);
-    tft.setTextSize(2);
-    tft.setCursor(20, SCREEN_HEIGHT / 2 - 20);
-    tft.print("WiFi Failed");
-    tft.setTextSize(1);
-    tft.setCursor(20, SCREEN_HEIGHT / 2 + 10);
-    tft.print("AP Mode for setup");
+    frameBegin();
+    gDraw->fillScreen(COLOR_RED);
+    gDraw->setTextColor(COLOR_WHITE);
+    gDraw->setTextSize(2);
+    gDraw->setCursor(20, SCREEN_HEIGHT / 2 - 20);
+    gDraw->print("WiFi Failed");
+    gDraw->setTextSize(1);
+    gDraw->setCursor(20, SCREEN_HEIGHT / 2 + 10);
+    gDraw->print("AP Mode for setup");
+    frameSubmit();
     delay(2000);
     // Stay in AP mode for config
     // Optionally, could restart or loop forever here
@@ -609,18 +1167,27 @@ void loadConfiguration() {
   deviceName = preferences.getString("deviceName", "ESP32 Tally Light");
   hubIP = preferences.getString("hubIP", "192.168.0.216");
   hubPort = preferences.getInt("hubPort", 7411);
+  standbyHub.ip = preferences.getString("hub2IP", "");
+  standbyHub.port = preferences.getInt("hub2Port", 7411);
   assignedSource = preferences.getString("assignedSource", "");
   assignedSourceName = preferences.getString("assignedSourceName", "");
   customDisplayName = preferences.getString("customDisplayName", "");
+  wifiFastJoinSsid = preferences.getString("wifiFjSsid", "");
+  if (preferences.getBytesLength("wifiFj") == sizeof(WiFiFastJoin)) {
+    preferences.getBytes("wifiFj", &wifiFastJoin, sizeof(WiFiFastJoin));
+  }
   preferences.end();
   
   // Set assignment status based on loaded configuration
   isAssigned = (assignedSource.length() > 0);
+  internAssignedSource();
   
   Serial.println("Configuration loaded:");
   Serial.println("  Device Name: " + deviceName);
   Serial.println("  Hub IP: " + hubIP);
   Serial.println("  Hub Port: " + String(hubPort));
+  Serial.println("  Standby Hub: " + (standbyHub.ip.length() > 0 ? standbyHub.ip + ":" + String(standbyHub.port) : String("None")));
+  publishStandbyHub();
   Serial.println("  Assigned Source: " + (assignedSource.length() > 0 ? assignedSource : "None"));
   Serial.println("  Assigned Source Name: " + (assignedSourceName.length() > 0 ? assignedSourceName : "None"));
   Serial.println("  Custom Display Name: " + (customDisplayName.length() > 0 ? customDisplayName : "None"));
@@ -632,6 +1199,8 @@ void saveConfiguration() {
   preferences.putString("deviceName", deviceName);
   preferences.putString("hubIP", hubIP);
   preferences.putInt("hubPort", hubPort);
+  preferences.putString("hub2IP", standbyHub.ip);
+  preferences.putInt("hub2Port", standbyHub.port);
   preferences.putString("assignedSource", assignedSource);
   preferences.putString("assignedSourceName", assignedSourceName);
   preferences.putString("customDisplayName", customDisplayName);
@@ -639,7 +1208,8 @@ void saveConfiguration() {
   Serial.println("Configuration saved");
 }
 
-void registerDevice() {
+// standby: register passively with the standby hub instead, quietly and for unicast delivery
+void registerDevice(bool standby) {
   // Check WiFi connection instead of isConnected
   if (WiFi.status() != WL_CONNECTED) return;
   
@@ -651,6 +1221,13 @@ void registerDevice() {
   doc["deviceId"] = deviceID;
   doc["deviceName"] = deviceName;
   doc["deviceType"] = "esp32-1732s019";
+  doc["proto"] = TALLY_PROTO_LEVEL; // hub may send binary tally frames and snapshots instead of JSON
+  doc["caps"] = TALLY_DEVICE_CAPS; // the hub answers with the subset it will use ("features")
+  doc["maxDatagram"] = TALLY_MAX_DATAGRAM;
+  doc["display"]["w"] = tft.width();
+  doc["display"]["h"] = tft.height();
+  doc["mcast"] = !standby && !multicastSuspended; // snapshots through the hub's multicast group, unless it went quiet on us
+  if (standby) doc["standby"] = true; // no tally or snapshots until we resume the session there
   doc["model"] = DEVICE_MODEL;
   doc["firmware"] = FIRMWARE_VERSION;
   doc["ip"] = ipAddress;
@@ -662,7 +1239,7 @@ void registerDevice() {
   if (isAssigned && assignedSource.length() > 0) {
     doc["assignedSource"] = assignedSource;
     doc["isAssigned"] = true;
-    Serial.println("Registration includes assignment: " + assignedSource);
+    if (!standby) Serial.println("Registration includes assignment: " + assignedSource);
   } else {
     doc["isAssigned"] = false;
   }
@@ -670,103 +1247,429 @@ void registerDevice() {
   String message;
   serializeJson(doc, message);
   
-  int result = udp.beginPacket(hubIP.c_str(), hubPort);
-  if (result == 1) {
-    udp.print(message);
-    int endResult = udp.endPacket();
-    if (endResult == 1) {
-      Serial.println("Device registration sent successfully");
-    } else {
-      Serial.println("Registration failed on endPacket, restarting UDP...");
-      restartUDP();
-    }
+  if (standby) {
+    sendToStandbyHub(message);
+    return;
+  }
+  if (sendToHub(message)) {
+    Serial.println("Device registration sent successfully");
   } else {
-    Serial.println("Registration failed on beginPacket, restarting UDP...");
+    Serial.println("Registration send failed, restarting UDP...");
     restartUDP();
   }
   // Don't set isRegistered here - wait for hub confirmation
 }
 
-void sendHeartbeat() {
+// After a short outage, reconnect with the token from the last "registered" instead of a full register.
+// The hub answers "registered" with resumed set and sends no assignment unless it changed meanwhile, so
+// recovery takes one round trip. An unknown or expired token gets register_required instead.
+bool resumeHubSession() {
+  if (hubSession.length() == 0 || millis() - hubSessionSeenAt >= hubSessionTtl) return false;
+  if (WiFi.status() != WL_CONNECTED) return false;
+  ensureUDPConnection();
+
+  JsonDocument doc;
+  doc["type"] = "resume";
+  doc["deviceId"] = deviceID;
+  doc["session"] = hubSession;
+  doc["mcast"] = !multicastSuspended;
+  if (isAssigned && assignedSource.length() > 0) doc["assignedSource"] = assignedSource;
+
+  String message;
+  serializeJson(doc, message);
+  sendToHub(message);
+  Serial.println("Resuming hub session");
+  return true;
+}
+
+// The hub re-sends the multicast snapshot every 2 s; if none arrives (IGMP snooping, AP filtering, a failed
+// join) re-register without multicast so the hub goes back to unicast, and offer it again later.
+void checkMulticastDelivery() {
+  if (multicastSuspended) {
+    if (millis() - multicastSuspendedAt > NET_MCAST_RETRY_MS) {
+      multicastSuspended = false;
+      if (isRegisteredWithHub) registerDevice();
+    }
+    return;
+  }
+  if (gMcastGroup.load() == 0) return;
+  uint32_t lastRx = gMcastLastRx.load(); // read before millis() so the difference cannot underflow
+  if ((uint32_t)millis() - lastRx > NET_MCAST_TIMEOUT_MS) {
+    Serial.println("No multicast tally received, falling back to unicast");
+    gNetStats.mcastFallbacks++;
+    multicastSuspended = true;
+    multicastSuspendedAt = millis();
+    registerDevice();
+  }
+}
+
+// probeOnly: an on-air liveness probe or a retry - just the echo stamp, no status fields or log line
+void sendHeartbeat(bool probeOnly) {
   // Only send heartbeat if we're connected to WiFi and registered with hub
   if (!isRegisteredWithHub) return;
   
   // Ensure UDP is working before sending heartbeat
-  ensureUDPConnection();
+  if (!probeOnly) ensureUDPConnection();
   
   JsonDocument doc;
   doc["type"] = "heartbeat";
   doc["deviceId"] = deviceID;
-  doc["uptime"] = millis() - bootTime;
-  doc["status"] = currentStatus;
-  doc["assignedSource"] = assignedSource;
-  doc["wifiRSSI"] = WiFi.RSSI();
-  doc["freeHeap"] = ESP.getFreeHeap();
+  uint32_t t = millis() | 1; // echoed by the hub in heartbeat_ack; never 0, which means "none"
+  doc["t"] = t;
+  if (!probeOnly) {
+    doc["uptime"] = millis() - bootTime;
+    doc["status"] = currentStatus;
+    doc["assignedSource"] = assignedSource;
+    doc["wifiRSSI"] = WiFi.RSSI();
+    doc["freeHeap"] = ESP.getFreeHeap();
+  }
   
   String message;
   serializeJson(doc, message);
   
-  int result = udp.beginPacket(hubIP.c_str(), hubPort);
-  if (result == 1) {
-    udp.print(message);
-    int endResult = udp.endPacket();
-    if (endResult == 1) {
-      Serial.println("Heartbeat sent successfully");
-    } else {
-      Serial.println("Heartbeat failed on endPacket, restarting UDP...");
-      restartUDP();
-    }
+  gProbeOutstanding = t;
+  gProbeSentAt = millis();
+  gProbeRetried = false;
+  lastHeartbeat = gProbeSentAt;
+  if (sendToHub(message)) {
+    if (probeOnly) return;
+    heartbeatsSent++;
+    Serial.printf("Heartbeat sent successfully (interval=%lums rx=%lu drop=%lu parseErr=%lu qmax=%lu worst=%lums srtt=%lums rto=%lums)\n",
+                  heartbeatIntervalMs, (unsigned long)gNetStats.received, (unsigned long)gNetStats.dropped,
+                  (unsigned long)gNetStats.parseErrors, (unsigned long)gNetStats.queueHighWater,
+                  gNetStats.maxApplyLatencyMs, (unsigned long)gHubRtt.srtt, (unsigned long)tallyRto(gHubRtt));
   } else {
-    Serial.println("Heartbeat failed on beginPacket, restarting UDP...");
+    Serial.println("Heartbeat send failed, restarting UDP...");
     restartUDP();
   }
 }
 
-void handleUDPMessages() {
-  int packetSize = udp.parsePacket();
-  if (packetSize == 0) return;
+void checkHubLiveness() {
+  if (!isRegisteredWithHub) {
+    gProbeOutstanding = 0;
+    gProbeMisses = 0;
+    return;
+  }
+
+  unsigned long now = millis();
+  if (gProbeOutstanding != 0 && now - gProbeSentAt >= tallyRto(gHubRtt)) {
+    gNetStats.probeTimeouts++;
+    heartbeatIntervalMs = std::max(HEARTBEAT_MIN_MS, heartbeatIntervalMs / 2); // loss: check more often for a while
+    if (++gProbeMisses >= LIVENESS_MAX_MISSES) {
+      declareHubLost("heartbeats unacknowledged");
+      return;
+    }
+    sendHeartbeat(true); // retry straight away rather than waiting for the next interval
+    gProbeRetried = true;
+  } else if (gProbeOutstanding == 0) {
+    bool onAir = isProgram || isPreview;
+    if (now - lastHeartbeat >= heartbeatIntervalMs) {
+      sendHeartbeat();
+    } else if (onAir && now - lastHubResponse >= LIVENESS_ACTIVE_PROBE_MS && now - lastHeartbeat >= LIVENESS_ACTIVE_PROBE_MS) {
+      sendHeartbeat(true);
+    }
+  }
 
-  char incomingPacket[512];
-  int len = udp.read(incomingPacket, 511);
-  if (len > 0) {
-    incomingPacket[len] = 0;
+  if (gProbeOutstanding != 0) {
+    loopWakeAt(gProbeSentAt + tallyRto(gHubRtt));
+  } else {
+    loopWakeAt(lastHeartbeat + heartbeatIntervalMs);
+    if (isProgram || isPreview) loopWakeAt(std::max(lastHubResponse, lastHeartbeat) + LIVENESS_ACTIVE_PROBE_MS);
   }
+}
 
-  Serial.printf("Received UDP packet: %s\n", incomingPacket);
+// Piggyback a liveness probe on a message the device sends anyway. The hub answers any "t" with heartbeat_ack,
+// so the exchange stands in for this interval's heartbeat. Only hubs that negotiate features echo it.
+void attachLivenessProbe(JsonDocument &doc) {
+  if (!isRegisteredWithHub || gProbeOutstanding != 0 || gHubFeatures.load() == 0) return;
+  uint32_t t = millis() | 1;
+  doc["t"] = t;
+  gProbeOutstanding = t;
+  gProbeSentAt = millis();
+  gProbeRetried = false;
+  lastHeartbeat = gProbeSentAt;
+  heartbeatsPiggybacked++;
+}
 
-  // Any message from hub resets lastHubResponse and connection attempts
-  lastHubResponse = millis();
+// Tell the hub which tally version is on screen so it stops retransmitting. Called for duplicates and stale
+// versions too: the retransmit that arrives after a lost ack is answered the same way, with no redraw.
+void sendTallyAck(bool snapshot, uint32_t seq) {
+  if (seq == 0 || !(gHubFeatures.load() & TALLY_CAP_TALLY_ACK)) return;
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"tally_ack\",\"%s\":%lu}", snapshot ? "snap" : "seq", (unsigned long)seq);
+  if (n > 0) sendToHub(String(out));
+  tallyAcksSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Ask the hub to replay the current tally state after registering or resuming, so a device that comes back
+// mid-show lights up right away instead of showing IDLE until the next cut. The replay arrives as ordinary
+// tally/snapshot datagrams, applied in order before sync_done, so the first frame drawn after the overlay
+// is already the hub's state. Returns false when the hub did not negotiate TALLY_CAP_SYNC.
+bool requestTallySync(bool resumed) {
+  if (!(gHubFeatures.load() & TALLY_CAP_SYNC)) return false;
+  if (!syncPending) {
+    syncPending = true;
+    syncAfterResume = resumed;
+    syncAttempts = 0;
+    lastSyncMs = millis();
+    showingRegistrationStatus = true;
+    registrationStatusStart = millis();
+    registrationStatusMessage = "Connecting...";
+    registrationStatusColor = COLOR_YELLOW;
+  }
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"sync\",\"scope\":\"%s\"}", SYNC_SCOPE);
+  if (n > 0) sendToHub(String(out));
+  syncAttempts++;
+  syncRequestedAt = millis();
+  loopWakeAt(syncRequestedAt + tallyRto(gHubRtt));
+  return true;
+}
+
+void syncStep() {
+  if (!syncPending || millis() - syncRequestedAt < tallyRto(gHubRtt)) return;
+  if (!isRegisteredWithHub) {
+    syncPending = false; // registration is starting over and will ask again
+    return;
+  }
+  if (syncAttempts < SYNC_MAX_ATTEMPTS) {
+    Serial.println("Tally sync unanswered - asking again");
+    requestTallySync(syncAfterResume);
+    return;
+  }
+  Serial.println("Tally sync unanswered - showing the state received so far");
+  finishTallySync(false);
+}
+
+void finishTallySync(bool answered) {
+  if (!syncPending) return;
+  syncPending = false;
+  if (answered) {
+    lastSyncMs = millis() - lastSyncMs;
+    syncsCompleted++;
+  } else {
+    lastSyncMs = 0;
+  }
+  showingRegistrationStatus = true;
+  registrationStatusStart = syncAfterResume ? 0 : millis();
+  registrationStatusMessage = "Connected";
+  registrationStatusColor = COLOR_GREEN;
+}
+
+void declareHubLost(const char *reason) {
+  Serial.printf("Hub lost: %s\n", reason);
+  if (standbyAlive()) {
+    switchToStandby(reason, false, 0); // tally carries on from the standby, no HUB LOST
+    return;
+  }
+  hubLinkLost = true;
+  isConnected = false;
+  isRegisteredWithHub = false;
+  updateStatus("HUB_LOST");
+  updateDisplay(); // Force immediate display update
+}
+
+// ---------------------------------------------------------------
+// Standby hub
+// ---------------------------------------------------------------
+
+// Publish the standby endpoint to the net task, which filters its datagrams by source address
+void publishStandbyHub() {
+  IPAddress ip;
+  bool valid = standbyHub.ip.length() > 0 && ip.fromString(standbyHub.ip);
+  if (standbyHub.ip.length() > 0 && !valid) Serial.printf("Standby hub \"%s\" is not an IP address, ignoring it\n", standbyHub.ip.c_str());
+  gStandbyHubPort.store(valid ? htons((uint16_t)standbyHub.port) : 0);
+  gStandbyHubAddr.store(valid ? (uint32_t)ip : 0);
+}
+
+static bool standbyAlive() {
+  return standbyHub.ip.length() > 0 && standbyHub.registered && millis() - standbyHub.lastRx < STANDBY_ALIVE_MS;
+}
+
+// Make the standby the active hub. It already has us registered passively, so resuming that session starts
+// its tally (the resumed reply also asks for a sync) and the display carries on; only per-hub state (sequence
+// numbers, RTT, snapshot slot, negotiated features) is swapped or starts over. The hub we leave is registered
+// again as the passive standby, at once when oldRegistered (it still has us and just leads with a lower
+// epoch), otherwise after retryMs (0 = one backoff step).
+static void switchToStandby(const char *reason, bool oldRegistered, uint32_t retryMs) {
+  Serial.printf("Switching to standby hub %s:%d, epoch %lu (%s)\n", standbyHub.ip.c_str(), standbyHub.port,
+                (unsigned long)standbyHub.epoch, reason);
+  unsigned long now = millis();
+  std::swap(hubIP, standbyHub.ip);
+  std::swap(hubPort, standbyHub.port);
+  std::swap(hubSession, standbyHub.session);
+  std::swap(hubEpoch, standbyHub.epoch);
+  standbyHub.slotKey = gAssignedSlotKey.exchange(standbyHub.slotKey);
+  standbyHub.features = gHubFeatures.exchange(standbyHub.features);
+  publishStandbyHub();
+  standbyHub.registered = false; // until it confirms the passive registration; until then it keeps sending tally
+  standbyHub.lastRx = oldRegistered ? lastHubResponse : 0;
+  standbyHub.attempts = 0;
+  if (retryMs > TALLY_RETRY_AFTER_MAX_MS) retryMs = TALLY_RETRY_AFTER_MAX_MS;
+  standbyHub.nextTxAt = now + (oldRegistered ? 0 : retryMs > 0 ? retryMs : tallyBackoffMs(0, gBackoffRng));
+
+  isRegisteredWithHub = true;
+  isConnected = true;
+  hubLinkLost = false;
   hubConnectionAttempts = 0;
+  lastHubResponse = now;
+  hubSessionSeenAt = now;
+  gProbeOutstanding = 0;
+  gProbeMisses = 0;
+  gHubRtt = {};
+  lastTallySeq = 0;     // each hub numbers its own state versions
+  lastSnapshotSeq = 0;
+  gMcastGroup.store(0); // the standby registration asked for unicast
+  hubFailovers++;
+  connEnter(CONN_REGISTERED, 0);
+  if (!resumeHubSession()) registerDevice(); // a refused resume gets register_required and the usual path
+  sendHeartbeat(true);  // first RTT sample from the new hub
+}
 
-  JsonDocument doc;
-  if (deserializeJson(doc, incomingPacket) != DeserializationError::Ok) {
-    Serial.println("Failed to parse JSON");
+// Messages from the standby hub only keep its registration and epoch current
+static void handleStandbyEvent(const NetEvent &ev) {
+  standbyHub.lastRx = millis();
+  switch (ev.type) {
+  case NET_EV_REGISTERED:
+    if (!standbyHub.registered) Serial.printf("Registered with standby hub %s:%d\n", standbyHub.ip.c_str(), standbyHub.port);
+    standbyHub.registered = true;
+    standbyHub.attempts = 0;
+    standbyHub.epoch = ev.epoch;
+    if (ev.id[0] != '\0') standbyHub.session = ev.id;
+    standbyHub.slotKey = ev.slotValid ? ((uint32_t)ev.slotEpoch << 16 | ev.slot) : NET_NO_SLOT_KEY;
+    standbyHub.features = ev.features;
+    standbyHub.nextTxAt = standbyHub.lastRx + STANDBY_HEARTBEAT_MS;
+    break;
+  case NET_EV_HEARTBEAT_ACK:
+    standbyHub.epoch = ev.epoch;
+    break;
+  case NET_EV_REGISTER_REQUIRED: {
+    // The standby restarted: register again when it says (its epoch may now be the higher one)
+    uint32_t wait = ev.duration > TALLY_RETRY_AFTER_MAX_MS ? TALLY_RETRY_AFTER_MAX_MS : ev.duration;
+    standbyHub.registered = false;
+    standbyHub.nextTxAt = standbyHub.lastRx + (wait > 0 ? wait : tallyBackoffMs(0, gBackoffRng));
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+// Once per loop() pass: heartbeat the standby every STANDBY_HEARTBEAT_MS while it has us registered,
+// (re)register it at the backoff pace otherwise, and hand over to it when it is alive and either the active
+// hub is unavailable or the standby leads with a higher epoch.
+void standbyStep() {
+  if (standbyHub.ip.length() == 0 || WiFi.status() != WL_CONNECTED) return;
+  unsigned long now = millis();
+  if (standbyHub.registered && now - standbyHub.lastRx >= STANDBY_ALIVE_MS) {
+    Serial.printf("Standby hub %s:%d stopped answering\n", standbyHub.ip.c_str(), standbyHub.port);
+    standbyHub.registered = false;
+    standbyHub.attempts = 0;
+  }
+  if (standbyAlive() && hubIP.length() > 0 && (!isRegisteredWithHub || standbyHub.epoch > hubEpoch)) {
+    if (isRegisteredWithHub) {
+      switchToStandby("it leads with a higher epoch", true, 0);
+    } else {
+      switchToStandby("active hub unavailable", false, 0);
+    }
     return;
   }
 
-  String type = doc["type"];
+  if ((long)(now - standbyHub.nextTxAt) >= 0) {
+    if (standbyHub.registered) {
+      JsonDocument doc;
+      doc["type"] = "heartbeat";
+      doc["deviceId"] = deviceID;
+      String message;
+      serializeJson(doc, message);
+      sendToStandbyHub(message);
+      standbyHub.nextTxAt = now + STANDBY_HEARTBEAT_MS;
+    } else {
+      registerDevice(true);
+      standbyHub.nextTxAt = now + CONN_REGISTER_TIMEOUT_MS + tallyBackoffMs(standbyHub.attempts++, gBackoffRng);
+    }
+  }
+  loopWakeAt(standbyHub.nextTxAt);
+}
 
-  if (type == "tally") {
+void handleUDPMessages() {
+  // Deduplicated tally never reaches the queue, but it is still hub traffic
+  uint32_t dupAt = gNetDupRxAt.exchange(0);
+  if (dupAt != 0 && (long)(dupAt - lastHubResponse) > 0) {
+    lastHubResponse = dupAt;
+    hubSessionSeenAt = dupAt;
+    gProbeMisses = 0;
+    hubLinkLost = false;
+  }
+
+  // Drain everything the net task has decoded since the last pass
+  NetEvent ev;
+  while (netQueuePop(ev)) {
+    unsigned long latency = millis() - ev.receivedAt;
+    if (latency > gNetStats.maxApplyLatencyMs) gNetStats.maxApplyLatencyMs = latency;
+    if (ev.fromStandby) {
+      handleStandbyEvent(ev);
+    } else {
+      applyHubEvent(ev);
+    }
+  }
+}
+
+// Drop tally state older than (or equal to) what is already shown; UDP may duplicate or reorder datagrams
+bool acceptTallySeq(uint32_t &lastSeq, uint32_t seq) {
+  uint32_t gap;
+  switch (tallyCheckSeq(lastSeq, seq, gap)) {
+  case TALLY_SEQ_DUPLICATE:
+    gNetStats.seqDuplicates++;
+    return false;
+  case TALLY_SEQ_STALE:
+    gNetStats.seqStale++;
+    Serial.printf("Dropping stale tally seq=%lu (applied %lu)\n", (unsigned long)seq, (unsigned long)lastSeq);
+    return false;
+  case TALLY_SEQ_RESYNC:
+    gNetStats.seqResyncs++;
+    break;
+  case TALLY_SEQ_APPLY:
+    gNetStats.seqGaps += gap;
+    break;
+  }
+  if (seq != 0) lastSeq = seq;
+  gNetStats.tallyApplied++;
+  return true;
+}
+
+void applyHubEvent(const NetEvent &ev) {
+  // Any message from hub resets lastHubResponse and connection attempts
+  lastHubResponse = millis();
+  hubSessionSeenAt = lastHubResponse;
+  hubConnectionAttempts = 0;
+  gProbeMisses = 0; // any hub traffic proves it is alive
+  hubLinkLost = false;
+
+  if (ev.type == NET_EV_TALLY) {
     // Check if message has a data object like the M5Stick expects
-    if (doc["data"].is<JsonObject>()) {
-      JsonObject data = doc["data"];
-      String sourceId = data["id"];
-      String sourceName = data["name"];
-      bool program = data["program"];
-      bool preview = data["preview"];
-      bool recording = data["recording"] | false;
-      bool streaming = data["streaming"] | false;
+    // Binary frames only carry the id hash, so match on the interned hash for both encodings
+    bool forAssignedSource = ev.sourceHash == assignedSourceHash;
+    if (forAssignedSource && !acceptTallySeq(lastTallySeq, ev.seq)) {
+      sendTallyAck(false, lastTallySeq);
+      return;
+    }
+    if (!ev.legacy) {
+      bool program = ev.program;
+      bool preview = ev.preview;
+      bool recording = ev.recording;
+      bool streaming = ev.streaming;
 
       // Only update if this is for our assigned source and we're actually assigned
-      if (isAssigned && assignedSource.length() > 0 && sourceId == assignedSource) {
+      if (isAssigned && assignedSource.length() > 0 && forAssignedSource) {
         isProgram = program;
         isPreview = preview;
         isRecording = recording;
         isStreaming = streaming;
         
         // Only update currentSource if no custom display name is set
-        if (customDisplayName.length() == 0) {
-          currentSource = cleanSourceName(sourceName); // Clean the source name for display
+        if (customDisplayName.length() == 0 && currentSource != assignedDisplayName) {
+          currentSource = assignedDisplayName;
         }
         
         if (program) {
@@ -783,14 +1686,13 @@ void handleUDPMessages() {
       }
     } else {
       // Legacy format without data object
-      String sourceId = doc["sourceId"];
-      bool program = doc["program"];
-      bool preview = doc["preview"];
-      bool recording = doc["recording"] | false;
-      bool streaming = doc["streaming"] | false;
+      bool program = ev.program;
+      bool preview = ev.preview;
+      bool recording = ev.recording;
+      bool streaming = ev.streaming;
 
       // Only update if this is for our assigned source and we're actually assigned
-      if (isAssigned && assignedSource.length() > 0 && sourceId == assignedSource) {
+      if (isAssigned && assignedSource.length() > 0 && forAssignedSource) {
         isProgram = program;
         isPreview = preview;
         isRecording = recording;
@@ -809,20 +1711,46 @@ void handleUDPMessages() {
                       recording ? "YES" : "NO", streaming ? "YES" : "NO");
       }
     }
-  } else if (type == "assignment") {
-    if (doc["data"].is<JsonObject>()) {
+    if (forAssignedSource) sendTallyAck(false, lastTallySeq);
+  } else if (ev.type == NET_EV_SNAPSHOT) {
+    // Whole-switcher snapshot: the net task already picked out our slot's bits
+    if (!acceptTallySeq(lastSnapshotSeq, ev.seq)) {
+      sendTallyAck(true, lastSnapshotSeq);
+      return;
+    }
+    if (!ev.slotValid || !isAssigned || assignedSource.length() == 0) return;
+    if (ev.program == isProgram && ev.preview == isPreview && ev.recording == isRecording && ev.streaming == isStreaming) return;
+
+    isProgram = ev.program;
+    isPreview = ev.preview;
+    isRecording = ev.recording;
+    isStreaming = ev.streaming;
+
+    if (ev.program) {
+      updateStatus("PROGRAM");
+    } else if (ev.preview) {
+      updateStatus("PREVIEW");
+    } else {
+      updateStatus("IDLE");
+    }
+
+    Serial.printf("Tally update (snapshot seq=%lu): Program=%s, Preview=%s, Recording=%s, Streaming=%s\n",
+                  (unsigned long)ev.seq, ev.program ? "YES" : "NO", ev.preview ? "YES" : "NO",
+                  ev.recording ? "YES" : "NO", ev.streaming ? "YES" : "NO");
+    sendTallyAck(true, lastSnapshotSeq); // only a change to our slot is a transition the hub waits on
+  } else if (ev.type == NET_EV_ASSIGNMENT) {
+    if (!ev.legacy) {
       // M5Stick format with nested data
-      JsonObject data = doc["data"];
-      String newSource = data["sourceId"];
-      String sourceName = data["sourceName"];
-      String mode = data["mode"];
+      String newSource = String(ev.id);
+      String sourceName = String(ev.name);
       
-      Serial.printf("Assignment update - Mode: %s, Source: %s\n", mode.c_str(), sourceName.c_str());
+      Serial.printf("Assignment update - Mode: %s, Source: %s\n", ev.assigned ? "assigned" : "unassigned", sourceName.c_str());
 
-      if (mode == "assigned") {
+      if (ev.assigned) {
         assignedSource = newSource;
         assignedSourceName = sourceName;
         isAssigned = true;
+        internAssignedSource(ev.sourceHash);
         
         // Only override custom display name if we don't have one set locally
         // This preserves user-set display names from the web portal
@@ -855,6 +1783,7 @@ void handleUDPMessages() {
         currentSource = ""; // Clear current source display name
         customDisplayName = ""; // Clear custom display name on unassignment
         isAssigned = false;
+        internAssignedSource();
         saveConfiguration();
         
         showingAssignmentConfirmation = true;
@@ -872,11 +1801,13 @@ void handleUDPMessages() {
       }
     } else {
       // Legacy format without data
-      String newSource = doc["sourceId"];
+      String newSource = String(ev.id);
       if (newSource != assignedSource) {
         if (newSource.length() > 0) {
           assignedSource = newSource;
+          assignedSourceName = "";
           isAssigned = true;
+          internAssignedSource(ev.sourceHash);
           saveConfiguration();
           
           showingAssignmentConfirmation = true;
@@ -888,6 +1819,7 @@ void handleUDPMessages() {
         } else {
           assignedSource = "";
           isAssigned = false;
+          internAssignedSource();
           saveConfiguration();
           
           showingAssignmentConfirmation = true;
@@ -905,48 +1837,72 @@ void handleUDPMessages() {
         isStreaming = false;
       }
     }
-  } else if (type == "register_required") {
+  } else if (ev.type == NET_EV_REGISTER_REQUIRED) {
     Serial.println("Hub requested registration, re-sending registration...");
     showingRegistrationStatus = true;
     registrationStatusStart = millis();
     registrationStatusMessage = "Re-register";
     registrationStatusColor = COLOR_YELLOW;
-    registerDevice();
-  } else if (type == "registered") {
+    syncPending = false;
+    hubSession = ""; // the hub has forgotten the session too
+    if (standbyAlive()) {
+      // The active hub restarted: keep tally going from the standby and register with it again later
+      switchToStandby("active hub asked us to register again", false, ev.duration);
+    } else {
+      connDeferRegistration(ev.duration);
+    }
+  } else if (ev.type == NET_EV_REGISTERED && ev.resumed) {
+    // Same hub, same session: assignment, snapshot sequence and display carry on as they were
+    Serial.println("Hub session resumed");
+    isRegisteredWithHub = true;
+    lastHeartbeat = ev.receivedAt; // the hub has just heard from us
+    hubEpoch = ev.epoch;
+    sessionResumes++;
+    // Tally changes made while we were away are replayed; without sync the overlay just ends
+    if (!requestTallySync(true)) registrationStatusStart = 0;
+  } else if (ev.type == NET_EV_REGISTERED) {
     Serial.println("Registration confirmed by hub");
     isRegisteredWithHub = true;
+    lastHeartbeat = ev.receivedAt; // the hub has just heard from us
+    hubEpoch = ev.epoch;
+    if (ev.id[0] != '\0') {
+      hubSession = ev.id;
+      hubSessionTtl = ev.duration;
+    }
+    if (bootToRegisteredMs == 0) bootToRegisteredMs = millis();
+    lastTallySeq = 0;    // the hub may have restarted and begun counting again,
+    lastSnapshotSeq = 0; // even for an assignment it does not resend
     hubConnectionAttempts = 0; // Reset reconnection attempts
     // Don't set READY status if device is already assigned - maintain current tally status
     if (!isAssigned || assignedSource.length() == 0) {
       updateStatus("READY");
     }
-    showingRegistrationStatus = true;
-    registrationStatusStart = millis();
-    registrationStatusMessage = "Connected";
-    registrationStatusColor = COLOR_GREEN;
-  } else if (type == "heartbeat_ack") {
-    Serial.println("Heartbeat acknowledged");
+    if (!requestTallySync(false)) { // otherwise "Connected" once the current state is in
+      showingRegistrationStatus = true;
+      registrationStatusStart = millis();
+      registrationStatusMessage = "Connected";
+      registrationStatusColor = COLOR_GREEN;
+    }
+  } else if (ev.type == NET_EV_SYNC_DONE) {
+    Serial.printf("Tally sync done: %lu page(s), snapshot seq %lu\n", (unsigned long)ev.duration, (unsigned long)ev.seq);
+    finishTallySync(true);
+  } else if (ev.type == NET_EV_HEARTBEAT_ACK) {
+    // Acks from hubs that do not echo "t" still clear the probe, they just give no RTT sample
+    if (ev.echoT != 0) tallyRttSample(gHubRtt, ev.receivedAt - ev.echoT);
+    if (gProbeOutstanding != 0 && !gProbeRetried) heartbeatIntervalMs = std::min(HEARTBEAT_MAX_MS, heartbeatIntervalMs + HEARTBEAT_STEP_MS);
+    gProbeOutstanding = 0;
+    hubEpoch = ev.epoch;
     hubConnectionAttempts = 0; // Reset reconnection attempts on successful communication
     // No display update needed - heartbeat ack should not change display state
-  } else if (type == "admin_message") {
-    const char* txt = doc["text"] | "";
-    if (strlen(txt) > 0) {
-      adminMessageText = String(txt);
-      adminMessageId = doc["id"].isNull() ? String("") : String((const char*)doc["id"].as<const char*>());
-      unsigned long dur = doc["duration"].isNull() ? 8000UL : (unsigned long)doc["duration"].as<unsigned long>();
+  } else if (ev.type == NET_EV_ADMIN_MESSAGE) {
+    if (ev.name[0] != '\0') {
+      adminMessageText = String(ev.name);
+      adminMessageId = String(ev.id);
+      unsigned long dur = ev.duration == 0 ? 8000UL : (unsigned long)ev.duration;
       if (dur < 1000UL) dur = 1000UL; if (dur > 30000UL) dur = 30000UL;
       adminMessageExpire = millis() + dur;
-      adminMessageBg = COLOR_BLUE;
-      if (!doc["color"].isNull()) {
-        String c = doc["color"].as<String>();
-        if (c.startsWith("#")) c.remove(0,1);
-        if (c.length() == 6) {
-          char rHex[3]={c[0],c[1],'\0'}; char gHex[3]={c[2],c[3],'\0'}; char bHex[3]={c[4],c[5],'\0'};
-          int r = strtol(rHex,nullptr,16); int g = strtol(gHex,nullptr,16); int b = strtol(bHex,nullptr,16);
-          uint16_t rr = (r & 0xF8) << 8; uint16_t gg = (g & 0xFC) << 3; uint16_t bb = (b >> 3);
-          adminMessageBg = rr | gg | bb;
-        }
-      }
+      // Background color already converted to RGB565 by the net task
+      adminMessageBg = ev.hasColor ? ev.color : COLOR_BLUE;
       adminMessageActive = true;
       Serial.printf("Admin message received (%lu ms): %s\n", dur, adminMessageText.c_str());
       updateDisplay(); // immediate refresh
@@ -955,6 +1911,13 @@ void handleUDPMessages() {
 }
 
 void updateDisplay() {
+  frameBegin();
+  composeDisplay();
+  frameSubmit();
+}
+
+// Draw the current screen (admin message, confirmation, registration or tally status) through gDraw
+void composeDisplay() {
   // Expire admin message if needed
   if (adminMessageActive && millis() > adminMessageExpire) {
     adminMessageActive = false;
@@ -963,7 +1926,7 @@ void updateDisplay() {
 
   // Show admin message overlay priority below assignment/registration screens
   if (adminMessageActive && !showingAssignmentConfirmation && !showingRegistrationStatus) {
-    tft.fillScreen(adminMessageBg);
+    gDraw->fillScreen(adminMessageBg);
     // Text wrapping with much larger size (size 4 for maximum visibility)
     String msg = adminMessageText;
     const int maxCharsPerLine = 12; // adjusted for even larger text size 4
@@ -979,17 +1942,17 @@ void updateDisplay() {
     }
     int totalH = lines.size() * 36; // textSize 4 => ~32px height + spacing
     int y = (SCREEN_HEIGHT - totalH)/2; if (y < 10) y = 10;
-    tft.setTextColor(COLOR_WHITE);
-    tft.setTextSize(4); // Increased from 3 to 4 for maximum message visibility
+    gDraw->setTextColor(COLOR_WHITE);
+    gDraw->setTextSize(4); // Increased from 3 to 4 for maximum message visibility
     for (size_t i=0;i<lines.size();++i) {
       int w = lines[i].length()*24; // adjusted for size 4
       int x = (SCREEN_WIDTH - w)/2; if (x<4) x=4;
-      tft.setCursor(x, y + i*36);
-      tft.print(lines[i]);
+      gDraw->setCursor(x, y + i*36);
+      gDraw->print(lines[i]);
     }
-    tft.setTextSize(1);
-    tft.setCursor(6, SCREEN_HEIGHT - 12);
-    tft.print("Msg from Admin");
+    gDraw->setTextSize(1);
+    gDraw->setCursor(6, SCREEN_HEIGHT - 12);
+    gDraw->print("Msg from Admin");
     return; // don't fall through
   }
   // Show assignment confirmation if needed
@@ -998,12 +1961,12 @@ void updateDisplay() {
       if (confirmationIsAssigned) {
         showStatus("ASSIGNED", COLOR_GREEN);
         // Show source name below
-        tft.setTextColor(COLOR_WHITE);
-        tft.setTextSize(2);
+        gDraw->setTextColor(COLOR_WHITE);
+        gDraw->setTextSize(2);
         int16_t x = (SCREEN_WIDTH - (confirmationSourceName.length() * 12)) / 2;
         int16_t y = SCREEN_HEIGHT / 2 + 10;
-        tft.setCursor(x, y);
-        tft.print(confirmationSourceName);
+        gDraw->setCursor(x, y);
+        gDraw->print(confirmationSourceName);
       } else {
         showStatus("UNASSIGNED", COLOR_RED);
       }
@@ -1016,7 +1979,7 @@ void updateDisplay() {
   // Show registration/reconnection status if needed
   if (showingRegistrationStatus) {
     unsigned long displayDuration = (registrationStatusMessage == "Re-register") ? 500 : 1000;
-    if (millis() - registrationStatusStart < displayDuration) {
+    if (syncPending || millis() - registrationStatusStart < displayDuration) { // held while the sync is out
       showStatus(registrationStatusMessage, registrationStatusColor);
       return;
     } else {
@@ -1035,7 +1998,7 @@ void updateDisplay() {
   } else if (!isRegisteredWithHub) {
     // Check if we've been trying to connect for a while
     unsigned long timeSinceLastResponse = millis() - lastHubResponse;
-    if ((timeSinceLastResponse > HUB_TIMEOUT && lastHubResponse > 0) || 
+    if (hubLinkLost || (timeSinceLastResponse > HUB_TIMEOUT && lastHubResponse > 0) || 
         (lastHubResponse == 0 && millis() > 30000)) { // Show HUB LOST after 30 seconds if never connected
       bgColor = COLOR_RED;
       textColor = COLOR_WHITE;
@@ -1088,7 +2051,8 @@ void updateDisplay() {
 
 // Generate and display actual scannable QR Code for WiFi credentials
 void displayWiFiQRCode(const String& apName) {
-  tft.fillScreen(COLOR_BLACK);
+  frameBegin();
+  gDraw->fillScreen(COLOR_BLACK);
   
   // QR code data for WiFi: WIFI:T:WPA;S:SSID;P:PASSWORD;;
   String qrData = "WIFI:T:WPA;S:" + apName + ";P:;;";
@@ -1112,13 +2076,14 @@ void displayWiFiQRCode(const String& apName) {
       uint16_t color = qrcode_getModule(&qrcode, x, y) ? COLOR_WHITE : COLOR_BLACK;
       
       if (scale == 1) {
-        tft.drawPixel(startX + x, startY + y, color);
+        gDraw->drawPixel(startX + x, startY + y, color);
       } else {
         // Draw scaled modules
-        tft.fillRect(startX + x * scale, startY + y * scale, scale, scale, color);
+        gDraw->fillRect(startX + x * scale, startY + y * scale, scale, scale, color);
       }
     }
   }
+  frameSubmit();
 }
 
 void updateStatus(const String& status) {
@@ -1127,27 +2092,27 @@ void updateStatus(const String& status) {
 }
 
 void showStatus(const String& status, uint16_t bgColor, uint16_t textColor) {
-  tft.fillScreen(bgColor);
+  gDraw->fillScreen(bgColor);
   
   // Show main status
-  tft.setTextColor(textColor);
-  tft.setTextSize(4);
+  gDraw->setTextColor(textColor);
+  gDraw->setTextSize(4);
   int16_t x = (SCREEN_WIDTH - (status.length() * 24)) / 2;
   int16_t y = SCREEN_HEIGHT / 2 - 40;
-  tft.setCursor(x, y);
-  tft.print(status);
+  gDraw->setCursor(x, y);
+  gDraw->print(status);
   
   // Show assigned source if available and not in error states
   String displaySource = "";
   
   // For HUB_LOST and RECONNECT states, show IP address prominently
   if (status == "HUB LOST" || status == "RECONNECT") {
-    tft.setTextSize(2);
+    gDraw->setTextSize(2);
     String ipText = "IP: " + ipAddress;
     x = (SCREEN_WIDTH - (ipText.length() * 12)) / 2;
     y = SCREEN_HEIGHT / 2 + 10;
-    tft.setCursor(x, y);
-    tft.print(ipText);
+    gDraw->setCursor(x, y);
+    gDraw->print(ipText);
   } else {
     // Normal operation - show assigned source if available
     if (customDisplayName.length() > 0) {
@@ -1161,73 +2126,75 @@ void showStatus(const String& status, uint16_t bgColor, uint16_t textColor) {
     }
     
     if (displaySource.length() > 0) {
-      tft.setTextSize(2);
+      gDraw->setTextSize(2);
       x = (SCREEN_WIDTH - (displaySource.length() * 12)) / 2;
       y = SCREEN_HEIGHT / 2 + 10;
-      tft.setCursor(x, y);
-      tft.print(displaySource);
+      gDraw->setCursor(x, y);
+      gDraw->print(displaySource);
     }
   }
   
   // Show recording/streaming status
   if (isRecording || isStreaming) {
-    tft.setTextSize(1);
-    tft.setCursor(5, SCREEN_HEIGHT - 20);
+    gDraw->setTextSize(1);
+    gDraw->setCursor(5, SCREEN_HEIGHT - 20);
     if (isRecording && isStreaming) {
-      tft.print("REC + STREAM");
+      gDraw->print("REC + STREAM");
     } else if (isRecording) {
-      tft.print("RECORDING");
+      gDraw->print("RECORDING");
     } else if (isStreaming) {
-      tft.print("STREAMING");
+      gDraw->print("STREAMING");
     }
   }
   
   // Show device info at bottom
-  tft.setTextSize(1);
-  tft.setCursor(5, SCREEN_HEIGHT - 40);
-  tft.print("Device: " + deviceName);
+  gDraw->setTextSize(1);
+  gDraw->setCursor(5, SCREEN_HEIGHT - 40);
+  gDraw->print("Device: " + deviceName);
   
-  tft.setCursor(5, SCREEN_HEIGHT - 30);
-  tft.print("IP: " + ipAddress);
+  gDraw->setCursor(5, SCREEN_HEIGHT - 30);
+  gDraw->print("IP: " + ipAddress);
   
-  tft.setCursor(5, SCREEN_HEIGHT - 10);
-  tft.print("FW: " + String(FIRMWARE_VERSION));
+  gDraw->setCursor(5, SCREEN_HEIGHT - 10);
+  gDraw->print("FW: " + String(FIRMWARE_VERSION));
 }
 
 void showBootScreen() {
-  tft.fillScreen(COLOR_BLACK);
+  frameBegin();
+  gDraw->fillScreen(COLOR_BLACK);
   
   // Show logo/title
-  tft.setTextColor(COLOR_CYAN);
-  tft.setTextSize(3);
+  gDraw->setTextColor(COLOR_CYAN);
+  gDraw->setTextSize(3);
   int16_t x = (SCREEN_WIDTH - (String("TALLY LIGHT").length() * 18)) / 2;
-  tft.setCursor(x, 30);
-  tft.print("TALLY LIGHT");
+  gDraw->setCursor(x, 30);
+  gDraw->print("TALLY LIGHT");
   
-  tft.setTextColor(COLOR_WHITE);
-  tft.setTextSize(2);
+  gDraw->setTextColor(COLOR_WHITE);
+  gDraw->setTextSize(2);
   x = (SCREEN_WIDTH - (String("ESP32-1732S019").length() * 12)) / 2;
-  tft.setCursor(x, 60);
-  tft.print("ESP32-1732S019");
+  gDraw->setCursor(x, 60);
+  gDraw->print("ESP32-1732S019");
   
   // Show version
-  tft.setTextSize(1);
+  gDraw->setTextSize(1);
   x = (SCREEN_WIDTH - (String("v" + String(FIRMWARE_VERSION)).length() * 6)) / 2;
-  tft.setCursor(x, 85);
-  tft.print("v" + String(FIRMWARE_VERSION));
+  gDraw->setCursor(x, 85);
+  gDraw->print("v" + String(FIRMWARE_VERSION));
   
   // Show device info
-  tft.setCursor(5, SCREEN_HEIGHT - 40);
-  tft.print("Device: " + deviceName);
+  gDraw->setCursor(5, SCREEN_HEIGHT - 40);
+  gDraw->print("Device: " + deviceName);
   
-  tft.setCursor(5, SCREEN_HEIGHT - 30);
-  tft.print("Model: " + String(DEVICE_MODEL));
+  gDraw->setCursor(5, SCREEN_HEIGHT - 30);
+  gDraw->print("Model: " + String(DEVICE_MODEL));
   
-  tft.setCursor(5, SCREEN_HEIGHT - 20);
-  tft.print("MAC: " + macAddress);
+  gDraw->setCursor(5, SCREEN_HEIGHT - 20);
+  gDraw->print("MAC: " + macAddress);
   
-  tft.setCursor(5, SCREEN_HEIGHT - 10);
-  tft.print("Starting...");
+  gDraw->setCursor(5, SCREEN_HEIGHT - 10);
+  gDraw->print("Starting...");
+  frameSubmit();
   
   delay(2000);
 }
@@ -1313,6 +2280,10 @@ void handleRoot() {
   html += "<input type='text' name='hub_ip' class='form-input' placeholder='192.168.1.100' value='" + hubIP + "' required></div>";
   html += "<div class='form-group'><label class='form-label'>Hub Server Port</label>";
   html += "<input type='number' name='hub_port' class='form-input' placeholder='7411' value='" + String(hubPort) + "' min='1' max='65535' required></div>";
+  html += "<div class='form-group'><label class='form-label'>Standby Hub IP (optional)</label>";
+  html += "<input type='text' name='hub2_ip' class='form-input' placeholder='Second hub for failover' value='" + standbyHub.ip + "'></div>";
+  html += "<div class='form-group'><label class='form-label'>Standby Hub Port</label>";
+  html += "<input type='number' name='hub2_port' class='form-input' placeholder='7411' value='" + String(standbyHub.port) + "' min='1' max='65535'></div>";
   html += "<div class='form-group'><label class='form-label'>Device ID</label>";
   html += "<input type='text' name='device_id' class='form-input' placeholder='esp32-tally-01' value='" + deviceID + "' required></div>";
   html += "<button type='submit' class='btn btn-primary'>Save Configuration</button></form></div>";
@@ -1340,6 +2311,13 @@ void handleSave() {
   deviceName = server.arg("device_name");
   hubIP = server.arg("hub_ip");
   hubPort = server.arg("hub_port").toInt();
+  if (server.arg("hub2_ip") != standbyHub.ip || server.arg("hub2_port").toInt() != standbyHub.port) {
+    standbyHub.ip = server.arg("hub2_ip");
+    standbyHub.port = server.hasArg("hub2_port") && server.arg("hub2_port").toInt() > 0 ? server.arg("hub2_port").toInt() : 7411;
+    standbyHub.registered = false;
+    standbyHub.nextTxAt = millis();
+    publishStandbyHub();
+  }
   deviceID = server.arg("device_id");
   
   saveConfiguration();
@@ -1433,6 +2411,17 @@ String formatUptime() {
   return result;
 }
 
+// Resolve the assignment to a hash and a display name once, so tally packets compare integers and copy nothing
+// sourceHash: the id's hash as the hub sent it, for ids too long to keep whole (see decodeAssignment)
+void internAssignedSource(uint64_t sourceHash) {
+  bool hasAssignment = isAssigned && assignedSource.length() > 0;
+  if (hasAssignment && sourceHash == 0) sourceHash = tallyHashSource(assignedSource.c_str());
+  assignedSourceHash = hasAssignment ? sourceHash : 0;
+  assignedDisplayName = hasAssignment ? cleanSourceName(assignedSourceName.length() > 0 ? assignedSourceName : assignedSource) : "";
+  gAssignedHash.store(assignedSourceHash);
+  lastTallySeq = 0; // versions are per source; start over with the new one
+}
+
 String cleanSourceName(String sourceName) {
   // Clean up source name for display (similar to M5Stick firmware)
   String cleaned = sourceName;
@@ -1458,111 +2447,567 @@ String cleanSourceName(String sourceName) {
 
 // WiFi and UDP Connection Management Functions
 
-void checkWiFiConnection() {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi connection lost, attempting reconnection...");
-    reconnectWiFi();
+void restartUDP() {
+  Serial.println("Restarting UDP connection...");
+  if (gNetRxTaskHandle == nullptr) {
+    startNetRxTask();
+  } else {
+    gNetReopenRequested = true; // net task closes and rebinds on its next wakeup
   }
 }
 
-void reconnectWiFi() {
-  static unsigned long lastReconnectAttempt = 0;
-  static int reconnectAttempts = 0;
-  const unsigned long RECONNECT_INTERVAL = 30000; // 30 seconds between attempts
-  const int MAX_RECONNECT_ATTEMPTS = 10;
-  
-  if (millis() - lastReconnectAttempt < RECONNECT_INTERVAL) {
-    return; // Too soon to try again
+// Close the current socket (if any) and bind a fresh one. Runs on the net task (or before it starts).
+static bool openUdpSocket(uint16_t port) {
+  xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+  if (gUdpSock >= 0) {
+    close(gUdpSock);
+    gUdpSock = -1;
   }
-  
-  lastReconnectAttempt = millis();
-  reconnectAttempts++;
-  
-  Serial.printf("WiFi reconnection attempt %d/%d\n", reconnectAttempts, MAX_RECONNECT_ATTEMPTS);
-  
-  // Reset WiFi and try to reconnect
-  WiFi.disconnect();
-  delay(1000);
-  
-  // Use stored credentials if available
-  WiFi.mode(WIFI_STA);
-  WiFi.begin();
-  
-  // Wait up to 15 seconds for connection
-  unsigned long connectStart = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - connectStart < 15000) {
-    delay(500);
-    Serial.print(".");
+  xSemaphoreGive(gUdpSockMutex);
+
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) return false;
+  int yes = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  struct timeval tv = { 0, NET_RX_TIMEOUT_MS * 1000 };
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(s);
+    return false;
   }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWiFi reconnected successfully!");
-    Serial.println("IP address: " + WiFi.localIP().toString());
-    ipAddress = WiFi.localIP().toString();
-    reconnectAttempts = 0;
-    
-    // Restart UDP and re-register with hub
-    restartUDP();
-    isConnected = false;
-    isRegisteredWithHub = false;
-    lastHubResponse = 0;
-    hubConnectionAttempts = 0;
+
+  xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+  gUdpSock = s;
+  xSemaphoreGive(gUdpSockMutex);
+  return true;
+}
+
+static bool netQueuePush(const NetEvent &ev) {
+  uint32_t head = gNetQueueHead.load(std::memory_order_relaxed);
+  uint32_t tail = gNetQueueTail.load(std::memory_order_acquire);
+  if (head - tail >= NET_EVENT_QUEUE_LEN) return false;
+  gNetQueue[head & (NET_EVENT_QUEUE_LEN - 1)] = ev;
+  gNetQueueHead.store(head + 1, std::memory_order_release);
+  if (head + 1 - tail > gNetStats.queueHighWater) gNetStats.queueHighWater = head + 1 - tail;
+  return true;
+}
+
+static bool netQueuePop(NetEvent &ev) {
+  uint32_t tail = gNetQueueTail.load(std::memory_order_relaxed);
+  uint32_t head = gNetQueueHead.load(std::memory_order_acquire);
+  if (tail == head) return false;
+  ev = gNetQueue[tail & (NET_EVENT_QUEUE_LEN - 1)];
+  gNetQueueTail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+static uint32_t netQueueDepth() {
+  return gNetQueueHead.load(std::memory_order_acquire) - gNetQueueTail.load(std::memory_order_acquire);
+}
+
+template <size_t N>
+static void copyField(char (&dst)[N], const char *src) {
+  strncpy(dst, src ? src : "", N - 1);
+  dst[N - 1] = '\0';
+}
+
+// Parse a "#RRGGBB" string into RGB565. Returns false if malformed.
+static bool parseHexColor565(const char *hex, uint16_t &out) {
+  if (hex == nullptr) return false;
+  if (*hex == '#') hex++;
+  if (strlen(hex) != 6) return false;
+  char *end = nullptr;
+  unsigned long rgb = strtoul(hex, &end, 16);
+  if (end == nullptr || *end != '\0') return false;
+  uint8_t r = (rgb >> 16) & 0xFF, g = (rgb >> 8) & 0xFF, b = rgb & 0xFF;
+  out = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  return true;
+}
+
+static bool decodeJsonMessage(const char *buffer, size_t len, HubMsgType type, NetEvent &ev);
+
+// Tally updates the loop will act on: only our assigned source (this board has no live-source view)
+static bool wantTally(bool program, uint64_t sourceHash) {
+  return sourceHash == gAssignedHash.load(std::memory_order_relaxed);
+}
+
+// Binary frames (see TallyProtocol.h): fixed header, no heap, name copied straight out of the datagram.
+// A snapshot carries every source; only the four bits of our assigned slot are kept.
+static bool decodeBinaryTally(const uint8_t *buffer, size_t len, NetEvent &ev) {
+  TallyFrame frame;
+  if (!tallyDecodeFrame(buffer, len, frame)) return false;
+  memset(&ev, 0, sizeof(ev));
+  ev.seq = frame.seq;
+  if (frame.kind == TALLY_KIND_SNAPSHOT) {
+    ev.type = NET_EV_SNAPSHOT;
+    uint32_t key = gAssignedSlotKey.load(std::memory_order_relaxed);
+    uint16_t slot = key & 0xFFFF;
+    ev.slotValid = key != NET_NO_SLOT_KEY && (key >> 16) == frame.tableEpoch && slot < frame.slotCount;
+    if (ev.slotValid) {
+      ev.program = tallySnapshotBit(frame, TALLY_PLANE_PROGRAM, slot);
+      ev.preview = tallySnapshotBit(frame, TALLY_PLANE_PREVIEW, slot);
+      ev.recording = tallySnapshotBit(frame, TALLY_PLANE_RECORDING, slot);
+      ev.streaming = tallySnapshotBit(frame, TALLY_PLANE_STREAMING, slot);
+    }
   } else {
-    Serial.println("\nWiFi reconnection failed");
-    
-    if (reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-      Serial.println("Max reconnection attempts reached, restarting device...");
-      ESP.restart();
+    ev.type = NET_EV_TALLY;
+    ev.sourceHash = frame.sourceHash;
+    ev.program = frame.flags & TALLY_FLAG_PROGRAM;
+    ev.preview = frame.flags & TALLY_FLAG_PREVIEW;
+    ev.recording = frame.flags & TALLY_FLAG_RECORDING;
+    ev.streaming = frame.flags & TALLY_FLAG_STREAMING;
+  }
+  // Names are not copied: this board shows the display name interned at assignment and has no live-source view
+  return true;
+}
+
+enum NetDecodeResult : uint8_t {
+  NET_DECODE_ERROR,     // junk or unknown type
+  NET_DECODE_OK,
+  NET_DECODE_FILTERED,  // valid, but a tally update the loop would ignore
+  NET_DECODE_DUPLICATE  // tally identical to the last datagram for its source (see tallyPayloadHash)
+};
+
+// Dedup key for a source: re-assigning changes the key, so the new source's first resend is applied
+static uint64_t netDedupKey(uint64_t sourceKey) {
+  uint32_t slotKey = gAssignedSlotKey.load(std::memory_order_relaxed);
+  return sourceKey ^ gAssignedHash.load(std::memory_order_relaxed) ^ ((uint64_t)slotKey << 32 | slotKey);
+}
+
+// Decode one hub datagram into a NetEvent. Runs on the net task. Tally updates for other sources never
+// reach the queue: binary frames are filtered after the fixed header, JSON by a raw pre-scan of the
+// buffer (tallyScanJson) before any document is built.
+static NetDecodeResult decodeHubMessage(const char *buffer, size_t len, NetEvent &ev) {
+  int64_t start = esp_timer_get_time();
+  if (tallyIsBinaryFrame((const uint8_t *)buffer, len)) {
+    if (!tallyFrameNegotiated((const uint8_t *)buffer, len, gHubFeatures.load())) {
+      gNetStats.unnegotiated++;
+      return NET_DECODE_FILTERED;
+    }
+    const uint8_t *raw = (const uint8_t *)buffer;
+    uint64_t key = len >= TALLY_FRAME_HEADER_LEN && (raw[1] & 0x0F) == TALLY_KIND_TALLY
+                   ? netDedupKey(tallyReadU64(raw + 8)) : netDedupKey(tallyDedupSnapshotKey(raw[2]));
+    uint32_t hash = tallyPayloadHash(raw, len);
+    if (tallyDedupHit(gNetDedup, key, hash, len)) {
+      gNetStats.deduplicated++;
+      return NET_DECODE_DUPLICATE;
+    }
+    bool ok = decodeBinaryTally((const uint8_t *)buffer, len, ev);
+    gNetStats.binaryFrames++;
+    gNetStats.binaryDecodeUs += esp_timer_get_time() - start;
+    if (!ok) return NET_DECODE_ERROR;
+    if (ev.type == NET_EV_TALLY && !wantTally(ev.program, ev.sourceHash)) return NET_DECODE_FILTERED;
+    tallyDedupStore(gNetDedup, key, hash, len);
+    return NET_DECODE_OK;
+  }
+
+  uint32_t cycles = ESP.getCycleCount();
+  TallyJsonScan scan;
+  HubMsgType type = HUB_MSG_UNKNOWN;
+  bool dedupable = false; // a tally whose id the pre-scan read: key and hash below are set
+  uint64_t key = 0;
+  uint32_t hash = 0;
+  if (tallyScanJson(buffer, len, scan)) {
+    type = hubMessageType(scan.type, scan.typeLen);
+    uint32_t features = gHubFeatures.load();
+    if (type == HUB_MSG_TALLY && features != 0 && (features & TALLY_CAP_JSON_TALLY) == 0) {
+      gNetStats.unnegotiated++;
+      return NET_DECODE_FILTERED;
+    }
+    if (type == HUB_MSG_TALLY && scan.id != nullptr) {
+      uint64_t sourceHash = tallyHashSource(scan.id, scan.idLen);
+      if (!wantTally(scan.program, sourceHash)) {
+        gNetStats.earlyRejects++;
+        gNetStats.earlyRejectCycles += ESP.getCycleCount() - cycles;
+        return NET_DECODE_FILTERED;
+      }
+      key = netDedupKey(sourceHash);
+      hash = tallyPayloadHash((const uint8_t *)buffer, len);
+      if (tallyDedupHit(gNetDedup, key, hash, len)) {
+        gNetStats.deduplicated++;
+        return NET_DECODE_DUPLICATE;
+      }
+      dedupable = true;
     }
   }
+
+  bool ok = decodeJsonMessage(buffer, len, type, ev);
+  gNetStats.jsonFrames++;
+  gNetStats.jsonDecodeUs += esp_timer_get_time() - start;
+  gNetStats.jsonDecodeCycles += ESP.getCycleCount() - cycles;
+  if (!ok) return NET_DECODE_ERROR;
+  if (ev.type == NET_EV_TALLY && ev.legacy && gHubFeatures.load() != 0) {
+    // Negotiating hubs only send the nested form; the top-level one is for hubs that predate it
+    gNetStats.unnegotiated++;
+    return NET_DECODE_FILTERED;
+  }
+  // Ids the pre-scan could not read (escapes, unusual layout) are filtered after the full parse instead
+  if (ev.type == NET_EV_TALLY && !wantTally(ev.program, ev.sourceHash)) return NET_DECODE_FILTERED;
+  if (dedupable) tallyDedupStore(gNetDedup, key, hash, len);
+  return NET_DECODE_OK;
 }
 
-void restartUDP() {
-  Serial.println("Restarting UDP connection...");
-  udp.stop();
-  delay(100);
-  
-  if (udp.begin(7411)) {
-    Serial.println("UDP restarted successfully");
+// ---- JSON hub messages ----
+// The type string is interned to a HubMsgType (TallyProtocol.h) and looked up in kHubHandlers. Each
+// handler declares the fields it reads as an ArduinoJson filter, built once at startup, so everything
+// else in the datagram (timestamps, device ids, ...) is skipped by the parser and never stored.
+// Documents live in a bump arena that is reset per datagram, so steady-state decoding does no heap
+// allocation (NetJsonArena.h).
+
+static NetJsonArena gNetJsonArena;
+
+struct HubMessageHandler {
+  HubMsgType type;
+  NetEventType event;
+  void (*declareFields)(JsonDocument &filter);
+  void (*decode)(JsonObjectConst msg, NetEvent &ev);
+};
+
+static void registerRequiredFields(JsonDocument &f) { f["retryAfter"] = true; }
+static void decodeRegisterRequired(JsonObjectConst msg, NetEvent &ev) {
+  ev.duration = msg["retryAfter"] | 0UL;
+}
+
+static void heartbeatAckFields(JsonDocument &f) { f["t"] = true; f["epoch"] = true; }
+static void decodeHeartbeatAck(JsonObjectConst msg, NetEvent &ev) {
+  ev.echoT = msg["t"] | 0UL;
+  ev.epoch = msg["epoch"] | 0UL;
+}
+
+static void registeredFields(JsonDocument &f) {
+  f["slot"] = true;
+  f["slotEpoch"] = true;
+  f["mcastGroup"] = true;
+  f["session"] = true;
+  f["sessionTtl"] = true;
+  f["resumed"] = true;
+  f["epoch"] = true;
+  f["features"] = true;
+}
+static void decodeRegistered(JsonObjectConst msg, NetEvent &ev) {
+  copyField(ev.id, msg["session"] | "");
+  ev.duration = msg["sessionTtl"] | 0UL;
+  ev.resumed = msg["resumed"] | false;
+  ev.epoch = msg["epoch"] | 0UL;
+  ev.features = msg["features"] | 0UL;
+  ev.slotValid = !msg["slot"].isNull();
+  ev.slot = msg["slot"] | TALLY_NO_SLOT;
+  ev.slotEpoch = msg["slotEpoch"] | 0;
+  IPAddress group;
+  bool isMulticast = group.fromString(msg["mcastGroup"] | "") && group[0] >= 224 && group[0] <= 239;
+  ev.mcastGroup = isMulticast ? (uint32_t)group : 0;
+}
+
+// Tally state fields, either nested under "data" or (legacy) at the top level
+static void tallyStateFields(JsonObject obj) {
+  obj["program"] = true;
+  obj["preview"] = true;
+  obj["recording"] = true;
+  obj["streaming"] = true;
+  obj["seq"] = true;
+}
+static void tallyFields(JsonDocument &f) {
+  JsonObject data = f["data"].to<JsonObject>();
+  data["id"] = true;
+  tallyStateFields(data);
+  f["sourceId"] = true;
+  tallyStateFields(f.as<JsonObject>());
+}
+static void decodeTally(JsonObjectConst msg, NetEvent &ev) {
+  // Check if message has a data object like the M5Stick expects
+  ev.legacy = !msg["data"].is<JsonObjectConst>();
+  JsonObjectConst data = ev.legacy ? msg : msg["data"].as<JsonObjectConst>();
+  // Hashed in place; neither the id nor the name is copied (the display name is interned at assignment)
+  ev.sourceHash = tallyHashSource(ev.legacy ? (msg["sourceId"] | "") : (data["id"] | ""));
+  ev.program = data["program"] | false;
+  ev.preview = data["preview"] | false;
+  ev.recording = data["recording"] | false;
+  ev.streaming = data["streaming"] | false;
+  ev.seq = data["seq"] | 0UL;
+}
+
+static void adminMessageFields(JsonDocument &f) { f["id"] = true; f["text"] = true; f["duration"] = true; f["color"] = true; }
+static void decodeAdminMessage(JsonObjectConst msg, NetEvent &ev) {
+  copyField(ev.id, msg["id"] | "");
+  copyField(ev.name, msg["text"] | "");
+  ev.duration = msg["duration"] | 0UL;
+  ev.hasColor = parseHexColor565(msg["color"] | (const char *)nullptr, ev.color);
+}
+
+static void assignmentFields(JsonDocument &f) {
+  JsonObject data = f["data"].to<JsonObject>();
+  data["mode"] = true;
+  data["sourceId"] = true;
+  data["sourceName"] = true;
+  data["slot"] = true;
+  data["slotEpoch"] = true;
+  f["sourceId"] = true;
+}
+static void decodeAssignment(JsonObjectConst msg, NetEvent &ev) {
+  if (msg["data"].is<JsonObjectConst>()) {
+    JsonObjectConst data = msg["data"];
+    const char *sourceId = data["sourceId"] | "";
+    copyField(ev.id, sourceId);
+    ev.sourceHash = tallyHashSource(sourceId); // ids longer than ev.id still match their tally packets
+    copyField(ev.name, data["sourceName"] | "");
+    ev.assigned = strcmp(data["mode"] | "", "assigned") == 0;
+    ev.slotValid = ev.assigned && !data["slot"].isNull();
+    ev.slot = data["slot"] | TALLY_NO_SLOT;
+    ev.slotEpoch = data["slotEpoch"] | 0;
   } else {
-    Serial.println("Failed to restart UDP");
+    // Legacy format without data: empty sourceId means unassigned
+    ev.legacy = true;
+    const char *sourceId = msg["sourceId"] | "";
+    copyField(ev.id, sourceId);
+    ev.sourceHash = tallyHashSource(sourceId);
+    ev.assigned = ev.id[0] != '\0';
   }
 }
 
-void ensureUDPConnection() {
-  // Check if UDP is still working by attempting to send a test packet
-  if (WiFi.status() == WL_CONNECTED) {
-    static unsigned long lastUDPTest = 0;
-    const unsigned long UDP_TEST_INTERVAL = 300000; // Test every 5 minutes (reduced frequency)
-    
-    if (millis() - lastUDPTest > UDP_TEST_INTERVAL) {
-      Serial.println("Testing UDP connection...");
-      
-      // Send a simple ping without restarting UDP on failure
-      JsonDocument doc;
-      doc["type"] = "ping";
-      doc["deviceId"] = deviceID;
-      doc["timestamp"] = millis();
-      
-      String message;
-      serializeJson(doc, message);
-      
-      int result = udp.beginPacket(hubIP.c_str(), hubPort);
-      if (result == 1) {
-        udp.print(message);
-        int endResult = udp.endPacket();
-        if (endResult == 1) {
-          Serial.println("UDP test successful");
-        } else {
-          Serial.println("UDP endPacket failed, but continuing...");
-        }
+static void syncDoneFields(JsonDocument &f) { f["pages"] = true; f["snap"] = true; }
+static void decodeSyncDone(JsonObjectConst msg, NetEvent &ev) {
+  ev.duration = msg["pages"] | 0UL;
+  ev.seq = msg["snap"] | 0UL;
+}
+
+// Indexed by HubMsgType; types this board does not act on have no handler and are rejected
+static const HubMessageHandler kHubHandlers[HUB_MSG_COUNT] = {
+  { HUB_MSG_UNKNOWN,           NET_EV_REGISTERED,        nullptr,                nullptr },
+  { HUB_MSG_REGISTERED,        NET_EV_REGISTERED,        registeredFields,       decodeRegistered },
+  { HUB_MSG_DISCOVER_REPLY,    NET_EV_REGISTERED,        nullptr,                nullptr },
+  { HUB_MSG_HEARTBEAT_ACK,     NET_EV_HEARTBEAT_ACK,     heartbeatAckFields,     decodeHeartbeatAck },
+  { HUB_MSG_REGISTER_REQUIRED, NET_EV_REGISTER_REQUIRED, registerRequiredFields, decodeRegisterRequired },
+  { HUB_MSG_TALLY,             NET_EV_TALLY,             tallyFields,            decodeTally },
+  { HUB_MSG_ADMIN_MESSAGE,     NET_EV_ADMIN_MESSAGE,     adminMessageFields,     decodeAdminMessage },
+  { HUB_MSG_ASSIGNMENT,        NET_EV_ASSIGNMENT,        assignmentFields,       decodeAssignment },
+  { HUB_MSG_SYNC_DONE,         NET_EV_SYNC_DONE,         syncDoneFields,         decodeSyncDone },
+};
+
+static JsonDocument gHubTypeFilter;
+static JsonDocument gHubFilters[HUB_MSG_COUNT];
+
+// Build the per-handler filters once, before the net task starts decoding
+static void buildHubFilters() {
+  gHubTypeFilter["type"] = true;
+  for (int i = 0; i < HUB_MSG_COUNT; i++) {
+    if (kHubHandlers[i].declareFields == nullptr) continue;
+    gHubFilters[i]["type"] = true;
+    kHubHandlers[i].declareFields(gHubFilters[i]);
+  }
+}
+
+// JSON fallback for older hubs and all non-tally messages. Parsed with only the fields the matching
+// handler declared; when the pre-scan could not read "type", a "type"-only pass runs first.
+static bool decodeJsonMessage(const char *buffer, size_t len, HubMsgType type, NetEvent &ev) {
+  static JsonDocument doc(&gNetJsonArena); // net task only
+  if (type == HUB_MSG_UNKNOWN) {
+    doc.clear();
+    gNetJsonArena.reset();
+    if (deserializeJson(doc, buffer, len, DeserializationOption::Filter(gHubTypeFilter)) != DeserializationError::Ok) {
+      Serial.println("Failed to parse JSON");
+      return false;
+    }
+    type = hubMessageType(doc["type"] | (const char *)nullptr);
+  }
+
+  const HubMessageHandler &handler = kHubHandlers[type];
+  if (type == HUB_MSG_UNKNOWN || handler.decode == nullptr) return false;
+
+  doc.clear();
+  gNetJsonArena.reset();
+  if (deserializeJson(doc, buffer, len, DeserializationOption::Filter(gHubFilters[type])) != DeserializationError::Ok) {
+    Serial.println("Failed to parse JSON");
+    return false;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.type = handler.event;
+  handler.decode(doc.as<JsonObjectConst>(), ev);
+  return true;
+}
+
+// Move the socket's multicast membership to group (0 = leave). IGMP reports go out from lwIP on join.
+static void netSetMulticastGroup(uint32_t group) {
+  struct ip_mreq mreq = {};
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (gMcastJoined != 0 && gMcastJoined != group) {
+    mreq.imr_multiaddr.s_addr = gMcastJoined;
+    setsockopt(gUdpSock, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
+    Serial.printf("Left multicast group %s\n", IPAddress(gMcastJoined).toString().c_str());
+    gMcastJoined = 0;
+  }
+  if (group != 0 && gMcastJoined != group) {
+    mreq.imr_multiaddr.s_addr = group;
+    if (setsockopt(gUdpSock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0) {
+      gMcastJoined = group;
+      Serial.printf("Joined multicast group %s\n", IPAddress(group).toString().c_str());
+    } else {
+      Serial.printf("Multicast join failed (%d), staying on unicast until the timeout\n", errno);
+    }
+  }
+  // Published even when the join failed: the silence then trips the unicast fallback in loop()
+  if (group != gMcastGroup.load()) gMcastLastRx.store(millis());
+  gMcastGroup.store(group);
+}
+
+// The one copy of each datagram: lwIP copies the payload straight from its pbuf into this buffer and every
+// decoder works on it in place. It holds TALLY_MAX_DATAGRAM plus one probe byte (and the NUL); lwIP
+// truncates silently, so a read that reaches the probe byte means the datagram was too long.
+static char gNetRxBuffer[TALLY_MAX_DATAGRAM + 2];
+
+// A deduplicated frame the hub is retransmitting (TALLY_CAP_TALLY_ACK) means our ack was lost. The loop never
+// sees it, so ack it from here with the version it carries, which is the one already applied.
+static void netAckDuplicate(const struct sockaddr_in &from, const uint8_t *buf, size_t len) {
+  if (!(gHubFeatures.load() & TALLY_CAP_TALLY_ACK) || len < TALLY_FRAME_HEADER_LEN || !tallyIsBinaryFrame(buf, len)) return;
+  bool snapshot = (buf[1] & 0x0F) == TALLY_KIND_SNAPSHOT;
+  if (!snapshot && tallyReadU64(buf + 8) != gAssignedHash.load()) return; // not our source: nothing pending
+  uint32_t seq = tallyReadU32(buf + 4);
+  if (seq == 0) return;
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"tally_ack\",\"%s\":%lu}", snapshot ? "snap" : "seq", (unsigned long)seq);
+  if (n > 0 && udpSendTo(IPAddress(from.sin_addr.s_addr), ntohs(from.sin_port), String(out))) tallyAcksSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void netRxTask(void *param) {
+  for (;;) {
+    if (gNetReopenRequested || gUdpSock < 0) {
+      gNetReopenRequested = false;
+      if (openUdpSocket(UDP_LOCAL_PORT)) {
+        Serial.printf("UDP started on port %d\n", UDP_LOCAL_PORT);
+        gMcastJoined = 0; // memberships belong to the old socket
+        netSetMulticastGroup(gMcastGroup.load());
       } else {
-        Serial.println("UDP beginPacket failed, but continuing...");
+        Serial.println("Failed to start UDP, retrying...");
+        vTaskDelay(pdMS_TO_TICKS(500));
+        continue;
       }
-      
-      lastUDPTest = millis();
     }
+
+    struct sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(gUdpSock, gNetRxBuffer, TALLY_MAX_DATAGRAM + 1, 0, (struct sockaddr *)&from, &fromLen);
+    if (len < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) continue; // receive timeout, nothing pending
+      gNetStats.socketErrors++;
+      Serial.printf("UDP recv error %d, reopening socket\n", errno);
+      gNetReopenRequested = true;
+      vTaskDelay(pdMS_TO_TICKS(100));
+      continue;
+    }
+    gNetStats.received++;
+    if (len > TALLY_MAX_DATAGRAM) {
+      gNetStats.oversize++;
+      Serial.printf("Dropping oversize datagram (> %d bytes)\n", TALLY_MAX_DATAGRAM);
+      continue;
+    }
+    gNetRxBuffer[len] = '\0';
+    // Only liveness and registration matter from the standby hub; its tally and snapshots stop here
+    bool fromStandby = gStandbyHubAddr.load() != 0 && from.sin_addr.s_addr == gStandbyHubAddr.load() &&
+                       from.sin_port == gStandbyHubPort.load();
+    if (fromStandby && tallyIsBinaryFrame((const uint8_t *)gNetRxBuffer, len)) {
+      gNetStats.standbyDropped++;
+      continue;
+    }
+    if (tallyFrameIsMulticast((const uint8_t *)gNetRxBuffer, len)) {
+      gNetStats.mcastFrames++;
+      gMcastLastRx.store(millis());
+    }
+
+    NetEvent ev;
+    NetDecodeResult result = decodeHubMessage(gNetRxBuffer, len, ev);
+    if (result == NET_DECODE_DUPLICATE && !fromStandby) {
+      // Nothing to apply; only that the hub is alive (picked up by handleUDPMessages)
+      gNetDupRxAt.store(millis() | 1);
+      netAckDuplicate(from, (const uint8_t *)gNetRxBuffer, len);
+      xTaskNotifyGive(gLoopTaskHandle);
+      continue;
+    }
+    if (result != NET_DECODE_OK) {
+      if (result == NET_DECODE_ERROR) gNetStats.parseErrors++;
+      continue;
+    }
+    ev.receivedAt = millis();
+    if (fromStandby) {
+      if (ev.type != NET_EV_HEARTBEAT_ACK && ev.type != NET_EV_REGISTERED && ev.type != NET_EV_REGISTER_REQUIRED) {
+        gNetStats.standbyDropped++;
+        continue;
+      }
+      ev.fromStandby = true;
+    } else if (ev.type == NET_EV_ASSIGNMENT) {
+      // Published here rather than when loop() applies it, so tally updates right behind the assignment pass the filter
+      gAssignedSlotKey.store(ev.slotValid ? ((uint32_t)ev.slotEpoch << 16 | ev.slot) : NET_NO_SLOT_KEY);
+      gAssignedHash.store(ev.assigned ? ev.sourceHash : 0);
+    } else if (ev.type == NET_EV_REGISTERED) {
+      gNetDedup = {}; // possibly a restarted hub: let its first resend of everything through
+      if (ev.slotValid) gAssignedSlotKey.store((uint32_t)ev.slotEpoch << 16 | ev.slot);
+      gHubFeatures.store(ev.features);
+      netSetMulticastGroup(ev.mcastGroup); // every registration reply states the delivery mode
+    }
+    if (!netQueuePush(ev)) gNetStats.dropped++;
+    xTaskNotifyGive(gLoopTaskHandle);
+  }
+}
+
+void startNetRxTask() {
+  if (gNetRxTaskHandle != nullptr) return;
+  if (gUdpSockMutex == nullptr) gUdpSockMutex = xSemaphoreCreateMutex();
+  gLoopTaskHandle = xTaskGetCurrentTaskHandle();
+  buildHubFilters();
+  // Bind now so the registration sent right after startup already has a socket; the task retries on failure
+  if (openUdpSocket(UDP_LOCAL_PORT)) Serial.printf("UDP started on port %d\n", UDP_LOCAL_PORT);
+  xTaskCreatePinnedToCore(netRxTask, "netRx", NET_RX_TASK_STACK, nullptr,
+                          NET_RX_TASK_PRIORITY, &gNetRxTaskHandle, NET_RX_TASK_CORE);
+}
+
+bool udpSendTo(IPAddress ip, uint16_t port, const String &message) {
+  struct sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  to.sin_addr.s_addr = (uint32_t)ip;
+  bool ok = false;
+  if (gUdpSockMutex != nullptr) {
+    xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+    if (gUdpSock >= 0) {
+      ok = sendto(gUdpSock, message.c_str(), message.length(), 0, (struct sockaddr *)&to, sizeof(to)) == (int)message.length();
+    }
+    xSemaphoreGive(gUdpSockMutex);
+  }
+  if (!ok) gNetStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+  return ok;
+}
+
+bool sendToHub(const String &message) {
+  IPAddress ip;
+  if (!ip.fromString(hubIP)) {
+    if (hubIP.length() == 0 || !WiFi.hostByName(hubIP.c_str(), ip)) {
+      gNetStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  return udpSendTo(ip, hubPort, message);
+}
+
+bool sendToStandbyHub(const String &message) {
+  IPAddress ip;
+  if (!ip.fromString(standbyHub.ip)) return false;
+  return udpSendTo(ip, standbyHub.port, message);
+}
+
+void ensureUDPConnection() {
+  // No separate ping: heartbeats and acks already exercise the socket, so only reopen it when sends have
+  // failed since the last check
+  static uint32_t lastSendErrors = 0;
+  uint32_t sendErrors = gNetStats.sendErrors.load(std::memory_order_relaxed);
+  if (WiFi.status() == WL_CONNECTED && sendErrors != lastSendErrors) {
+    Serial.println("UDP sends failing, restarting UDP...");
+    restartUDP();
   }
+  lastSendErrors = sendErrors;
 }
 
 void handleSources() {
@@ -1663,8 +3108,13 @@ void handleAssign() {
   String sourceId = server.arg("source");
   if (sourceId.length() > 0) {
     assignedSource = sourceId;
+    assignedSourceName = ""; // the hub's name belonged to the previous source; it comes back with the hub's assignment
     isAssigned = true;
+    internAssignedSource();
     saveConfiguration();
+    // The old snapshot slot belongs to the previous assignment; re-register so the hub hands out the new one
+    gAssignedSlotKey.store(NET_NO_SLOT_KEY);
+    registerDevice();
     
     String html = "<!DOCTYPE html><html><head>";
     html += "<title>Assignment Complete</title>";
@@ -1684,9 +3134,11 @@ void handleAssign() {
 }
 
 void handleUnassign() {
+  gAssignedSlotKey.store(NET_NO_SLOT_KEY);
   assignedSource = "";
   isAssigned = false;
   customDisplayName = ""; // Clear custom name when unassigning
+  internAssignedSource();
   saveConfiguration();
   
   String html = "<!DOCTYPE html><html><head>";
@@ -1712,7 +3164,7 @@ void handleSaveDisplayName() {
     currentSource = customDisplayName;
   } else if (assignedSource.length() > 0) {
     // If clearing custom name and we have an assigned source, use cleaned source name
-    currentSource = cleanSourceName(assignedSource);
+    currentSource = assignedDisplayName;
   } else {
     currentSource = "";
   }
@@ -1757,6 +3209,18 @@ void handleReset() {
   ESP.restart();
 }
 
+static String hubFeaturesText(uint32_t features) {
+  if (features == 0) return "not negotiated";
+  String text;
+  if (features & TALLY_CAP_SNAPSHOT) text += "snapshot ";
+  if (features & TALLY_CAP_BINARY) text += "binary ";
+  if (features & TALLY_CAP_JSON_TALLY) text += "json ";
+  if (features & TALLY_CAP_MULTICAST) text += "multicast ";
+  if (features & TALLY_CAP_SEQ) text += "seq";
+  text.trim();
+  return text;
+}
+
 void handleStatus() {
   String html = "<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'>";
   html += "<meta name='viewport' content='width=device-width, initial-scale=1.0'>";
@@ -1793,6 +3257,73 @@ void handleStatus() {
   html += "<div class='status-value'>" + String(isProgram ? "Program" : (isPreview ? "Preview" : "Off")) + "</div></div>";
   html += "<div class='status-item'><div class='status-label'>Uptime</div>";
   html += "<div class='status-value'>" + formatUptime() + "</div></div>";
+  html += "</div></div>";
+  html += "<div class='card'><div class='card-header'>";
+  html += "<h1>Network Receive</h1></div>";
+  html += "<div class='status-grid'>";
+  html += "<div class='status-item'><div class='status-label'>Packets Received</div>";
+  html += "<div class='status-value'>" + String(gNetStats.received) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Dropped (queue full)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.dropped) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Parse Errors (oversize)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.parseErrors) + " (" + String(gNetStats.oversize) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Socket / Send Errors</div>";
+  html += "<div class='status-value'>" + String(gNetStats.socketErrors) + " / " + String(gNetStats.sendErrors.load()) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Queue Depth (max)</div>";
+  html += "<div class='status-value'>" + String(netQueueDepth()) + " (" + String(gNetStats.queueHighWater) + "/" + String(NET_EVENT_QUEUE_LEN) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Loop Wakeups (avg / s)</div>";
+  html += "<div class='status-value'>" + String(millis() ? (float)gLoopPasses * 1000.0f / millis() : 0.0f, 1) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Connection</div>";
+  html += "<div class='status-value'>" + String(CONN_STATE_NAMES[connState]) + " (" + String((millis() - connStateSince) / 1000) + " s)</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Last WiFi Join (assoc / IP)</div>";
+  html += "<div class='status-value'>" + String(lastJoin.directed ? "directed" : "full") + ", " + String(lastJoin.assocMs) + " / "
+        + String(lastJoin.ipMs) + " ms" + (lastJoin.cachedLease ? " (cached lease)" : "") + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Standby Hub (epoch, failovers)</div>";
+  html += "<div class='status-value'>" + (standbyHub.ip.length() ? standbyHub.ip + ":" + String(standbyHub.port) + (standbyAlive() ? " up" : " down")
+        + " (" + String(standbyHub.epoch) + ", " + String(hubFailovers) + "), active epoch " + String(hubEpoch) : String("none")) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Negotiated Features (dropped)</div>";
+  html += "<div class='status-value'>" + hubFeaturesText(gHubFeatures.load()) + " (" + String(gNetStats.unnegotiated) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Hub Session (resumes)</div>";
+  html += "<div class='status-value'>" + String(hubSession.length() ? "held" : "none") + " (" + String(sessionResumes) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Boot to Registered</div>";
+  html += "<div class='status-value'>" + (bootToRegisteredMs ? String(bootToRegisteredMs) + " ms" : String("-")) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Heartbeat (sent, piggybacked)</div>";
+  html += "<div class='status-value'>every " + String(heartbeatIntervalMs / 1000) + " s (" + String(heartbeatsSent) + ", " + String(heartbeatsPiggybacked) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Tally Acks Sent</div>";
+  html += "<div class='status-value'>" + String(tallyAcksSent.load()) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Tally Sync (last, completed)</div>";
+  html += "<div class='status-value'>" + (syncPending ? String("pending") : lastSyncMs ? String(lastSyncMs) + " ms" : String("-"))
+        + " (" + String(syncsCompleted) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Hub RTT (RTO, probe timeouts)</div>";
+  html += "<div class='status-value'>" + (gHubRtt.valid ? String(gHubRtt.srtt) + " ± " + String(gHubRtt.rttvar) + " ms" : String("-"))
+        + " (" + String(tallyRto(gHubRtt)) + " ms, " + String(gNetStats.probeTimeouts) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Worst Apply Latency</div>";
+  html += "<div class='status-value'>" + String(gNetStats.maxApplyLatencyMs) + " ms</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Binary / JSON Frames</div>";
+  html += "<div class='status-value'>" + String(gNetStats.binaryFrames) + " / " + String(gNetStats.jsonFrames) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Avg Decode (bin / JSON)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.binaryFrames ? (unsigned long)(gNetStats.binaryDecodeUs / gNetStats.binaryFrames) : 0UL) + " / "
+        + String(gNetStats.jsonFrames ? (unsigned long)(gNetStats.jsonDecodeUs / gNetStats.jsonFrames) : 0UL) + " µs</div></div>";
+  html += "<div class='status-item'><div class='status-label'>JSON Heap Allocs (arena peak)</div>";
+  html += "<div class='status-value'>" + String(gNetJsonArena.heapAllocs()) + " (" + String((unsigned long)gNetJsonArena.highWater()) + "/" + String(NET_JSON_ARENA_SIZE) + " B)</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Pre-scan Rejects (cycles: reject / full parse)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.earlyRejects) + " (" + String(gNetStats.earlyRejects ? (unsigned long)(gNetStats.earlyRejectCycles / gNetStats.earlyRejects) : 0UL) + " / "
+        + String(gNetStats.jsonFrames ? (unsigned long)(gNetStats.jsonDecodeCycles / gNetStats.jsonFrames) : 0UL) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Tally Frames (applied / deduplicated)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.tallyApplied) + " / " + String(gNetStats.deduplicated) + "</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Seq Stale / Dup / Gaps (resyncs)</div>";
+  html += "<div class='status-value'>" + String(gNetStats.seqStale) + " / " + String(gNetStats.seqDuplicates) + " / " + String(gNetStats.seqGaps)
+        + " (" + String(gNetStats.seqResyncs) + ")</div></div>";
+  uint32_t mcastGroup = gMcastGroup.load();
+  html += "<div class='status-item'><div class='status-label'>Multicast (frames / fallbacks)</div>";
+  html += "<div class='status-value'>" + (mcastGroup ? IPAddress(mcastGroup).toString() : String(multicastSuspended ? "Unicast (fallback)" : "Unicast"))
+        + " (" + String(gNetStats.mcastFrames) + " / " + String(gNetStats.mcastFallbacks) + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Display Frame (loop blocked, max)</div>";
+  html += "<div class='status-value'>" + String(gDisplayStats.lastBlockedUs) + " µs, " + String(gDisplayStats.maxBlockedUs) + " µs ("
+        + String(gDisplayTaskHandle != nullptr ? "DMA" : "direct") + ")</div></div>";
+  html += "<div class='status-item'><div class='status-label'>Display Push (DMA / CPU, frames pushed)</div>";
+  html += "<div class='status-value'>" + (gDisplayTaskHandle != nullptr ? String(gDisplayStats.lastPushUs) + " / " + String(gDisplayStats.lastCopyUs) + " µs" : String("-"))
+        + " (" + String(gDisplayStats.pushes) + " of " + String(gDisplayStats.frames) + ")</div></div>";
   html += "</div>";
   html += "<div style='padding:1.5rem;text-align:center;'>";
   html += "<a href='/' class='btn btn-secondary'>Back to Main</a>";
@@ -0,0 +1,68 @@
+#pragma once
+// Bump allocator for the JSON documents the net task decodes, shared by every firmware.
+// Blocks are carved from a static buffer and released all at once by reset() between datagrams, so
+// steady-state decoding does no heap allocation. Anything that does not fit falls back to malloc and
+// is counted in heapAllocs(). Free of Arduino dependencies so firmware/test can measure it on the host.
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NET_JSON_ARENA_SIZE
+#define NET_JSON_ARENA_SIZE 6144
+#endif
+
+class NetJsonArena : public ArduinoJson::Allocator {
+public:
+  void reset() { used_ = 0; }
+  size_t highWater() const { return highWater_; }
+  uint32_t heapAllocs() const { return heapAllocs_; }
+
+  void *allocate(size_t size) override {
+    size_t need = align(size) + kHeader;
+    if (used_ + need > sizeof(buf_)) {
+      heapAllocs_++;
+      return malloc(size);
+    }
+    uint8_t *block = buf_ + used_;
+    *(size_t *)block = size;
+    used_ += need;
+    if (used_ > highWater_) highWater_ = used_;
+    return block + kHeader;
+  }
+
+  void deallocate(void *p) override {
+    if (!owns(p)) free(p); // arena blocks are released by reset()
+  }
+
+  void *reallocate(void *p, size_t size) override {
+    if (p == nullptr) return allocate(size);
+    if (!owns(p)) return realloc(p, size);
+    uint8_t *block = (uint8_t *)p - kHeader;
+    size_t old = *(size_t *)block;
+    bool newest = block + kHeader + align(old) == buf_ + used_;
+    if (newest && used_ - align(old) + align(size) <= sizeof(buf_)) {
+      // Newest block (the usual case: pool list growth, shrink-to-fit) resizes in place
+      used_ = used_ - align(old) + align(size);
+      if (used_ > highWater_) highWater_ = used_;
+      *(size_t *)block = size;
+      return p;
+    }
+    if (size <= old) return p;
+    void *moved = allocate(size);
+    if (moved) memcpy(moved, p, old);
+    return moved;
+  }
+
+private:
+  static constexpr size_t kHeader = 8; // keeps returned blocks 8-byte aligned
+  static size_t align(size_t n) { return (n + 7) & ~(size_t)7; }
+  bool owns(void *p) const { return p >= buf_ && p < buf_ + sizeof(buf_); }
+
+  alignas(8) uint8_t buf_[NET_JSON_ARENA_SIZE];
+  size_t used_ = 0;
+  size_t highWater_ = 0;
+  uint32_t heapAllocs_ = 0;
+};
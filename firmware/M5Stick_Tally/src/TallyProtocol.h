@@ -0,0 +1,501 @@
+#pragma once
+// Compact binary tally frames, mirrored by src/core/TallyProtocol.ts on the hub (keep both in sync).
+// Header-only and free of Arduino dependencies so the same file is shared by every firmware.
+//
+// Every frame starts with the same 16-byte little-endian header:
+//   0   u8   magic 0xA7 (JSON datagrams always start with '{', so the two never collide)
+//   1   u8   version << 4 | kind
+//   2   u8   flags (kind specific)
+//   3   u8   name length in bytes (<= TALLY_FRAME_MAX_NAME)
+//   4   u32  sequence number
+//   8   ...  kind specific
+//
+// TALLY_KIND_TALLY, one source:
+//   2   flags: bit0 program, bit1 preview, bit2 recording, bit3 streaming
+//   8   u64  FNV-1a 64 hash of the source id (UTF-8)
+//   16  ...  source name bytes, not NUL terminated
+//
+// TALLY_KIND_SNAPSHOT, every source on the switcher in one datagram:
+//   2   flags: bit0 sent to the multicast group (also the periodic refresh that keeps devices on multicast)
+//   8   u16  slot table epoch (slots handed out with the assignment are only valid within it)
+//   10  u16  slot count N
+//   12  u16  slot currently in program (TALLY_NO_SLOT if none)
+//   16  ...  four bitmaps of (N + 7) / 8 bytes: program, preview, recording, streaming
+//   ..  ...  live program source name bytes
+//
+// Devices advertise what they understand with "caps" (TALLY_CAP_*) in their register message, plus
+// "proto": TALLY_PROTO_LEVEL for hubs that predate capability negotiation.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TALLY_FRAME_MAGIC 0xA7
+#define TALLY_FRAME_VERSION 1
+#define TALLY_FRAME_HEADER_LEN 16
+#define TALLY_FRAME_MAX_NAME 95
+#define TALLY_SNAPSHOT_MAX_SLOTS 512
+#define TALLY_NO_SLOT 0xFFFF
+// Largest hub message (JSON or binary) a device accepts: one unfragmented UDP payload on a 1500-byte MTU
+#define TALLY_MAX_DATAGRAM 1472
+
+// 1 = single source binary frames, 2 = adds snapshot frames
+#define TALLY_PROTO_LEVEL 2
+
+// ---- Capability negotiation ----
+// A device offers "caps" (with "maxDatagram" and its display size) in register; the hub answers with
+// "features" in registered: the subset it will actually send, picking the cheapest encoding the device
+// takes (snapshots, then binary tally frames, then JSON). Formats outside it are dropped unparsed.
+// A registered without "features" comes from a hub that predates negotiation: accept everything.
+#define TALLY_CAP_JSON_TALLY 0x01 // {"type":"tally","data":{...}}
+#define TALLY_CAP_BINARY     0x02 // TALLY_KIND_TALLY frames
+#define TALLY_CAP_SNAPSHOT   0x04 // TALLY_KIND_SNAPSHOT frames
+#define TALLY_CAP_MULTICAST  0x08 // snapshots through the hub's multicast group
+#define TALLY_CAP_SEQ        0x10 // state versions in "seq" are honoured
+#define TALLY_CAP_TALLY_ACK  0x20 // applied transitions are acked with tally_ack; the hub retransmits until then
+#define TALLY_CAP_SYNC       0x40 // "sync" after registering replays the current state, ended by sync_done
+#define TALLY_DEVICE_CAPS (TALLY_CAP_JSON_TALLY | TALLY_CAP_BINARY | TALLY_CAP_SNAPSHOT | TALLY_CAP_MULTICAST | TALLY_CAP_SEQ | \
+                           TALLY_CAP_TALLY_ACK | TALLY_CAP_SYNC)
+
+enum TallyFrameKind : uint8_t {
+  TALLY_KIND_TALLY = 1,
+  TALLY_KIND_SNAPSHOT = 2
+};
+
+enum TallySnapshotPlane : uint8_t {
+  TALLY_PLANE_PROGRAM = 0,
+  TALLY_PLANE_PREVIEW,
+  TALLY_PLANE_RECORDING,
+  TALLY_PLANE_STREAMING,
+  TALLY_PLANE_COUNT
+};
+
+enum : uint8_t {
+  TALLY_FLAG_PROGRAM   = 0x01,
+  TALLY_FLAG_PREVIEW   = 0x02,
+  TALLY_FLAG_RECORDING = 0x04,
+  TALLY_FLAG_STREAMING = 0x08
+};
+
+enum : uint8_t {
+  TALLY_SNAPSHOT_FLAG_MULTICAST = 0x01
+};
+
+// Zero-copy view of a decoded frame; name and bitmaps point into the caller's buffer.
+struct TallyFrame {
+  uint8_t kind;
+  uint8_t flags;
+  uint8_t nameLen;
+  uint32_t seq;
+  uint64_t sourceHash;     // TALLY_KIND_TALLY only
+  uint16_t tableEpoch;     // TALLY_KIND_SNAPSHOT only
+  uint16_t slotCount;
+  uint16_t programSlot;
+  const uint8_t *bitmaps;
+  const char *name;
+};
+
+// FNV-1a 64 over the source id bytes (matches fnv1a64() on the hub)
+static inline uint64_t tallyHashSource(const char *s, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static inline uint64_t tallyHashSource(const char *s) {
+  return tallyHashSource(s, strlen(s));
+}
+
+static inline uint32_t tallyReadU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t tallyReadU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint64_t tallyReadU64(const uint8_t *p) {
+  return (uint64_t)tallyReadU32(p) | ((uint64_t)tallyReadU32(p + 4) << 32);
+}
+
+static inline bool tallyIsBinaryFrame(const uint8_t *buf, size_t len) {
+  return len > 0 && buf[0] == TALLY_FRAME_MAGIC;
+}
+
+static inline size_t tallyBitmapBytes(uint16_t slotCount) {
+  return ((size_t)slotCount + 7) / 8;
+}
+
+// Decode a frame without allocating. Returns false on wrong magic/version/kind or truncation.
+static inline bool tallyDecodeFrame(const uint8_t *buf, size_t len, TallyFrame &out) {
+  if (len < TALLY_FRAME_HEADER_LEN || buf[0] != TALLY_FRAME_MAGIC) return false;
+  if ((buf[1] >> 4) != TALLY_FRAME_VERSION) return false;
+  out.kind = buf[1] & 0x0F;
+  out.flags = buf[2];
+  out.nameLen = buf[3];
+  out.seq = tallyReadU32(buf + 4);
+  if (out.nameLen > TALLY_FRAME_MAX_NAME) return false;
+
+  size_t nameOffset = TALLY_FRAME_HEADER_LEN;
+  if (out.kind == TALLY_KIND_TALLY) {
+    out.sourceHash = tallyReadU64(buf + 8);
+    out.tableEpoch = 0;
+    out.slotCount = 0;
+    out.programSlot = TALLY_NO_SLOT;
+    out.bitmaps = nullptr;
+  } else if (out.kind == TALLY_KIND_SNAPSHOT) {
+    out.sourceHash = 0;
+    out.tableEpoch = tallyReadU16(buf + 8);
+    out.slotCount = tallyReadU16(buf + 10);
+    out.programSlot = tallyReadU16(buf + 12);
+    if (out.slotCount > TALLY_SNAPSHOT_MAX_SLOTS) return false;
+    out.bitmaps = buf + TALLY_FRAME_HEADER_LEN;
+    nameOffset += tallyBitmapBytes(out.slotCount) * TALLY_PLANE_COUNT;
+  } else {
+    return false;
+  }
+
+  if (len < nameOffset + out.nameLen) return false;
+  out.name = (const char *)buf + nameOffset;
+  return true;
+}
+
+// One bit of a decoded snapshot; out-of-range slots read as off.
+static inline bool tallySnapshotBit(const TallyFrame &f, TallySnapshotPlane plane, uint16_t slot) {
+  if (f.kind != TALLY_KIND_SNAPSHOT || slot >= f.slotCount) return false;
+  const uint8_t *p = f.bitmaps + tallyBitmapBytes(f.slotCount) * plane;
+  return (p[slot >> 3] >> (slot & 7)) & 1;
+}
+
+// True for a snapshot the hub sent to its multicast group; only the header is inspected.
+static inline bool tallyFrameIsMulticast(const uint8_t *buf, size_t len) {
+  return len >= TALLY_FRAME_HEADER_LEN && buf[0] == TALLY_FRAME_MAGIC &&
+         (buf[1] & 0x0F) == TALLY_KIND_SNAPSHOT && (buf[2] & TALLY_SNAPSHOT_FLAG_MULTICAST) != 0;
+}
+
+// Whether a binary frame is of a kind the hub negotiated (features 0 = not negotiated, anything goes)
+static inline bool tallyFrameNegotiated(const uint8_t *buf, size_t len, uint32_t features) {
+  if (features == 0 || len < 2) return true;
+  uint8_t kind = buf[1] & 0x0F;
+  if (kind == TALLY_KIND_TALLY) return (features & TALLY_CAP_BINARY) != 0;
+  if (kind == TALLY_KIND_SNAPSHOT) return (features & TALLY_CAP_SNAPSHOT) != 0;
+  return true;
+}
+
+// ---- State versions ----
+// Tally messages carry a seq that only moves forward when the state they describe changes (per source
+// for tally frames and JSON, per hub for snapshots). 0 means "unsequenced" (older hubs) and is always
+// applied. A backwards jump larger than the window is taken as a hub restart rather than a stale frame.
+#define TALLY_SEQ_RESYNC_WINDOW 1024
+
+enum TallySeqVerdict : uint8_t {
+  TALLY_SEQ_APPLY,
+  TALLY_SEQ_DUPLICATE,
+  TALLY_SEQ_STALE,
+  TALLY_SEQ_RESYNC
+};
+
+// Serial-number comparison of seq against the last applied version; gap = versions skipped in between.
+static inline TallySeqVerdict tallyCheckSeq(uint32_t last, uint32_t seq, uint32_t &gap) {
+  gap = 0;
+  if (last == 0 || seq == 0) return TALLY_SEQ_APPLY;
+  int32_t delta = (int32_t)(seq - last);
+  if (delta == 0) return TALLY_SEQ_DUPLICATE;
+  if (delta < 0) return -delta <= TALLY_SEQ_RESYNC_WINDOW ? TALLY_SEQ_STALE : TALLY_SEQ_RESYNC;
+  gap = (uint32_t)delta - 1;
+  return TALLY_SEQ_APPLY;
+}
+
+// ---- Duplicate payloads ----
+// The hub resends unchanged tally (mixer polls, registrations, retransmits). A tally datagram that is
+// byte-for-byte the last one seen for its source says nothing new, so the net task compares a hash of
+// the raw bytes before decoding and lets only liveness through. Keys are the source hash (binary frames,
+// JSON ids) or tallyDedupSnapshotKey(), mixed with whatever decides how a frame is applied (assignment),
+// so a re-assignment never hides a resend of the new source's state. Direct mapped: a collision only
+// costs one ordinary decode.
+#define TALLY_DEDUP_SLOTS 8
+#define TALLY_DEDUP_SNAPSHOT_KEY 0x5348415053484f54ULL // "SNAPSHOT"
+
+struct TallyDedupCache {
+  uint64_t key[TALLY_DEDUP_SLOTS];
+  uint32_t hash[TALLY_DEDUP_SLOTS];
+  uint16_t len[TALLY_DEDUP_SLOTS]; // 0 = empty slot
+};
+
+static inline uint32_t tallyRotl32(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+// xxHash32 (seed 0) of a datagram: four bytes per step, so a snapshot costs a fraction of FNV-1a
+static inline uint32_t tallyPayloadHash(const uint8_t *p, size_t len) {
+  const uint32_t P1 = 2654435761U, P2 = 2246822519U, P3 = 3266489917U, P4 = 668265263U, P5 = 374761393U;
+  const uint8_t *end = p + len;
+  uint32_t h;
+  if (len >= 16) {
+    uint32_t v1 = P1 + P2, v2 = P2, v3 = 0, v4 = 0U - P1;
+    const uint8_t *limit = end - 16;
+    do {
+      v1 = tallyRotl32(v1 + tallyReadU32(p) * P2, 13) * P1; p += 4;
+      v2 = tallyRotl32(v2 + tallyReadU32(p) * P2, 13) * P1; p += 4;
+      v3 = tallyRotl32(v3 + tallyReadU32(p) * P2, 13) * P1; p += 4;
+      v4 = tallyRotl32(v4 + tallyReadU32(p) * P2, 13) * P1; p += 4;
+    } while (p <= limit);
+    h = tallyRotl32(v1, 1) + tallyRotl32(v2, 7) + tallyRotl32(v3, 12) + tallyRotl32(v4, 18);
+  } else {
+    h = P5;
+  }
+  h += (uint32_t)len;
+  for (; p + 4 <= end; p += 4) h = tallyRotl32(h + tallyReadU32(p) * P3, 17) * P4;
+  for (; p < end; p++) h = tallyRotl32(h + *p * P5, 11) * P1;
+  h ^= h >> 15;
+  h *= P2;
+  h ^= h >> 13;
+  h *= P3;
+  h ^= h >> 16;
+  return h;
+}
+
+static inline size_t tallyDedupSlot(uint64_t key) {
+  return (size_t)((uint32_t)key ^ (uint32_t)(key >> 32)) % TALLY_DEDUP_SLOTS;
+}
+
+// Snapshots get one key per delivery path. While a device is on the multicast group the hub can still
+// unicast it a copy (a sync replay, the unicast fallback), and the two differ in the multicast flag; sharing a key would
+// make each copy evict the other and decode every time.
+static inline uint64_t tallyDedupSnapshotKey(uint8_t flags) {
+  return TALLY_DEDUP_SNAPSHOT_KEY ^ (flags & TALLY_SNAPSHOT_FLAG_MULTICAST);
+}
+
+// True when (hash, len) is what was last stored for key
+static inline bool tallyDedupHit(const TallyDedupCache &c, uint64_t key, uint32_t hash, size_t len) {
+  size_t i = tallyDedupSlot(key);
+  return c.len[i] == len && c.key[i] == key && c.hash[i] == hash;
+}
+
+static inline void tallyDedupStore(TallyDedupCache &c, uint64_t key, uint32_t hash, size_t len) {
+  size_t i = tallyDedupSlot(key);
+  c.key[i] = key;
+  c.hash[i] = hash;
+  c.len[i] = (uint16_t)len;
+}
+
+// ---- Hub round-trip time ----
+// Heartbeats carry the device's millis() as "t" and the hub echoes it in heartbeat_ack, so every ack is an
+// RTT sample (retried probes carry their own t, so samples are never ambiguous). Smoothed and turned into
+// a retransmission timeout the way TCP does it (RFC 6298), in whole milliseconds.
+#define TALLY_RTO_INITIAL_MS 1000
+#define TALLY_RTO_MIN_MS 200
+#define TALLY_RTO_MAX_MS 3000
+#define TALLY_RTO_GRANULARITY_MS 10
+
+struct TallyRtt {
+  uint32_t srtt;   // smoothed round-trip time
+  uint32_t rttvar; // smoothed mean deviation
+  bool valid;      // at least one sample taken
+};
+
+static inline void tallyRttSample(TallyRtt &r, uint32_t sample) {
+  if (!r.valid) {
+    r.srtt = sample;
+    r.rttvar = sample / 2;
+    r.valid = true;
+    return;
+  }
+  uint32_t err = sample > r.srtt ? sample - r.srtt : r.srtt - sample;
+  r.rttvar = (3 * r.rttvar + err) / 4;
+  r.srtt = (7 * r.srtt + sample) / 8;
+}
+
+static inline uint32_t tallyRto(const TallyRtt &r) {
+  if (!r.valid) return TALLY_RTO_INITIAL_MS;
+  uint32_t var = 4 * r.rttvar > TALLY_RTO_GRANULARITY_MS ? 4 * r.rttvar : TALLY_RTO_GRANULARITY_MS;
+  uint32_t rto = r.srtt + var;
+  if (rto < TALLY_RTO_MIN_MS) return TALLY_RTO_MIN_MS;
+  return rto > TALLY_RTO_MAX_MS ? TALLY_RTO_MAX_MS : rto;
+}
+
+// ---- Hub retry backoff ----
+// Capped exponential backoff with "equal jitter": attempt n waits a uniformly random time in
+// [e/2, e] where e = min(TALLY_BACKOFF_CAP_MS, TALLY_BACKOFF_BASE_MS << n). The generator is seeded from
+// the MAC, so a fleet that lost the hub at the same instant spreads its retries instead of bursting
+// together, and a given device always draws the same sequence (scripts/simulate-register-storm.js
+// mirrors this exactly).
+#define TALLY_BACKOFF_BASE_MS 1000
+#define TALLY_BACKOFF_CAP_MS 60000
+#define TALLY_RETRY_AFTER_MAX_MS 120000 // clamp for the hub's register_required retryAfter
+
+static inline uint32_t tallyBackoffSeed(const uint8_t mac[6]) {
+  uint32_t h = 2166136261u; // FNV-1a 32
+  for (int i = 0; i < 6; i++) {
+    h ^= mac[i];
+    h *= 16777619u;
+  }
+  return h != 0 ? h : 1; // xorshift never leaves 0
+}
+
+// xorshift32: one step of the per-device generator
+static inline uint32_t tallyBackoffNext(uint32_t &state) {
+  uint32_t x = state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return state = x;
+}
+
+static inline uint32_t tallyBackoffMs(uint32_t attempt, uint32_t &state) {
+  uint32_t e = attempt >= 16 ? TALLY_BACKOFF_CAP_MS : TALLY_BACKOFF_BASE_MS << attempt;
+  if (e > TALLY_BACKOFF_CAP_MS) e = TALLY_BACKOFF_CAP_MS;
+  return e / 2 + tallyBackoffNext(state) % (e / 2 + 1);
+}
+
+// JSON hub message types interned to small codes. tallyTypeHash() is constexpr, so every case label in
+// hubMessageType() is folded at compile time and a collision between two known types fails the build.
+// The final strcmp rejects unknown strings that happen to land on a known hash.
+enum HubMsgType : uint8_t {
+  HUB_MSG_UNKNOWN = 0,
+  HUB_MSG_REGISTERED,
+  HUB_MSG_DISCOVER_REPLY,
+  HUB_MSG_HEARTBEAT_ACK,
+  HUB_MSG_REGISTER_REQUIRED,
+  HUB_MSG_TALLY,
+  HUB_MSG_ADMIN_MESSAGE,
+  HUB_MSG_ASSIGNMENT,
+  HUB_MSG_SYNC_DONE,
+  HUB_MSG_COUNT
+};
+
+// FNV-1a 32, recursive so it stays a C++11 constexpr
+static constexpr uint32_t tallyTypeHash(const char *s, uint32_t h = 2166136261u) {
+  return *s ? tallyTypeHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+static inline HubMsgType hubMessageType(const char *type, size_t len) {
+  if (type == nullptr) return HUB_MSG_UNKNOWN;
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)type[i]) * 16777619u;
+  HubMsgType code;
+  const char *expected;
+  switch (h) {
+#define HUB_MSG_CASE(str, c) case tallyTypeHash(str): code = c; expected = str; break;
+    HUB_MSG_CASE("registered", HUB_MSG_REGISTERED)
+    HUB_MSG_CASE("discover_reply", HUB_MSG_DISCOVER_REPLY)
+    HUB_MSG_CASE("heartbeat_ack", HUB_MSG_HEARTBEAT_ACK)
+    HUB_MSG_CASE("register_required", HUB_MSG_REGISTER_REQUIRED)
+    HUB_MSG_CASE("tally", HUB_MSG_TALLY)
+    HUB_MSG_CASE("admin_message", HUB_MSG_ADMIN_MESSAGE)
+    HUB_MSG_CASE("assignment", HUB_MSG_ASSIGNMENT)
+    HUB_MSG_CASE("sync_done", HUB_MSG_SYNC_DONE)
+#undef HUB_MSG_CASE
+    default: return HUB_MSG_UNKNOWN;
+  }
+  return strlen(expected) == len && memcmp(type, expected, len) == 0 ? code : HUB_MSG_UNKNOWN;
+}
+
+static inline HubMsgType hubMessageType(const char *type) {
+  return type == nullptr ? HUB_MSG_UNKNOWN : hubMessageType(type, strlen(type));
+}
+
+// Raw JSON pre-scan: pulls the top-level "type" and, for tally messages, "id" and "program" of the
+// top-level "data" object straight out of the datagram without building a document, so tally packets for other sources can be dropped before
+// any parsing. It is not a validator: escaped values or layouts it does not recognise come back as
+// "not found" and the caller falls back to the full parse.
+struct TallyJsonScan {
+  const char *type;    // raw "type" value, not NUL terminated
+  size_t typeLen;
+  const char *id;      // raw "id" value (nullptr if absent or escaped)
+  size_t idLen;
+  bool hasProgram;
+  bool program;
+};
+
+static inline const char *tallyJsonSkipSpace(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+  return p;
+}
+
+// One past the JSON value starting at p, or nullptr if it runs past end. Strings honour escapes; objects
+// and arrays are skipped whole, whatever they contain. A scalar ends at the first delimiter.
+static inline const char *tallyJsonSkipValue(const char *p, const char *end) {
+  int depth = 0;
+  bool inString = false;
+  for (; p < end; p++) {
+    char c = *p;
+    if (inString) {
+      if (c == '\\') {
+        p++;
+      } else if (c == '"') {
+        inString = false;
+        if (depth == 0) return p + 1;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']' || c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      if (depth == 0) return p;
+      if ((c == '}' || c == ']') && --depth == 0) return p + 1;
+    }
+  }
+  return nullptr;
+}
+
+// Position of the value of "key" among the members of the object at obj, or nullptr. Only the object's
+// own members are compared: nested objects and arrays, and string values, are skipped without looking
+// inside, so a "key" deeper down (or quoted in a value) never matches. Escaped key names never match.
+static inline const char *tallyJsonFindValue(const char *obj, const char *end, const char *key) {
+  if (obj == nullptr || obj >= end || *obj != '{') return nullptr;
+  size_t keyLen = strlen(key);
+  const char *p = obj + 1;
+  while (true) {
+    p = tallyJsonSkipSpace(p, end);
+    if (p >= end || *p != '"') return nullptr; // end of the object, or not JSON
+    const char *name = p + 1;
+    const char *nameEnd = tallyJsonSkipValue(p, end);
+    if (nameEnd == nullptr) return nullptr;
+    p = tallyJsonSkipSpace(nameEnd, end);
+    if (p >= end || *p != ':') return nullptr;
+    const char *v = tallyJsonSkipSpace(p + 1, end);
+    if ((size_t)(nameEnd - 1 - name) == keyLen && memcmp(name, key, keyLen) == 0) return v;
+    p = tallyJsonSkipValue(v, end);
+    if (p == nullptr) return nullptr;
+    p = tallyJsonSkipSpace(p, end);
+    if (p >= end || *p != ',') return nullptr;
+    p++;
+  }
+}
+
+// String value without escapes at v; false if it is not a plain string
+static inline bool tallyJsonPlainString(const char *v, const char *end, const char *&out, size_t &outLen) {
+  if (v == nullptr || v >= end || *v != '"') return false;
+  const char *start = ++v;
+  while (v < end && *v != '"') {
+    if (*v == '\\') return false;
+    v++;
+  }
+  if (v >= end) return false;
+  out = start;
+  outLen = v - start;
+  return true;
+}
+
+// Returns false if no plain "type" value was found.
+static inline bool tallyScanJson(const char *buf, size_t len, TallyJsonScan &out) {
+  const char *end = buf + len;
+  memset(&out, 0, sizeof(out));
+  const char *root = tallyJsonSkipSpace(buf, end);
+  if (!tallyJsonPlainString(tallyJsonFindValue(root, end, "type"), end, out.type, out.typeLen)) return false;
+  if (hubMessageType(out.type, out.typeLen) != HUB_MSG_TALLY) return true;
+
+  const char *data = tallyJsonFindValue(root, end, "data");
+  if (!tallyJsonPlainString(tallyJsonFindValue(data, end, "id"), end, out.id, out.idLen)) out.id = nullptr;
+  const char *program = tallyJsonFindValue(data, end, "program");
+  if (program != nullptr && end - program >= 4 && memcmp(program, "true", 4) == 0) {
+    out.hasProgram = out.program = true;
+  } else if (program != nullptr && end - program >= 5 && memcmp(program, "false", 5) == 0) {
+    out.hasProgram = true;
+  }
+  return true;
+}
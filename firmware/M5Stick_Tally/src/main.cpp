@@ -1,14 +1,18 @@
 #include <M5Unified.h>
 #include <WiFi.h>
-#include <WiFiUdp.h>
 #include <WebServer.h>
 #include <DNSServer.h>
 #include <ArduinoJson.h>
 #include <ESPmDNS.h>
+#include <mdns.h>
 #include <Preferences.h>
 #include <EEPROM.h>
 #include <math.h>
 #include <qrcode.h>
+#include <lwip/sockets.h>
+#include <atomic>
+#include "TallyProtocol.h"
+#include "NetJsonArena.h"
 
 // -----------------------------------------------------------------------------
 // Optional Feature Flags (enable via platformio.ini build_flags or uncomment):
@@ -41,10 +45,28 @@ bool auto_discovery_enabled = true; // new preference: attempt hub auto-discover
 
 // WiFi Memory System - Store multiple networks
 #define MAX_WIFI_NETWORKS 5
+// Where the last successful join to a network landed. A directed join (WiFi.begin with BSSID and channel)
+// skips the scan, and the DHCP lease is installed as static config so the address is up without a DHCP
+// exchange; DHCP takes it over once the join is up (see connLeaseStep).
+// Stored as one blob per network; valid = 0 until a join succeeds, and again after a directed join fails.
+struct WiFiFastJoin {
+  uint8_t valid;
+  uint8_t channel;
+  uint8_t bssid[6];
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
 struct WiFiNetwork {
   String ssid;
   String password;
   bool isActive;
+  WiFiFastJoin fastJoin;
+  // Join history since boot, used to rank roaming candidates
+  uint16_t joinAttempts;
+  uint16_t joinSuccesses;
+  uint16_t joinMsAvg;      // smoothed begin -> got IP
 };
 WiFiNetwork savedNetworks[MAX_WIFI_NETWORKS];
 int networkCount = 0;
@@ -66,7 +88,134 @@ bool forceConfigMode = false;
 bool showQRCode = true; // Track whether to show QR code or text info
 
 // Network objects
-WiFiUDP udp;
+// Hub traffic uses a raw lwIP UDP socket owned by a dedicated receive task (netRxTask).
+// The task blocks on the socket, drains every pending datagram, decodes it into a
+// fixed-size NetEvent and hands it to loop() through a lock-free single-producer /
+// single-consumer ring, so a burst from the hub no longer costs one loop() period per packet.
+#ifndef NET_EVENT_QUEUE_LEN
+#define NET_EVENT_QUEUE_LEN 16          // must be a power of two
+#endif
+#define NET_RX_TASK_STACK 6144
+#define NET_RX_TASK_PRIORITY 3          // above loopTask (1), well below the Wi-Fi/lwIP tasks
+#define NET_RX_TASK_CORE 0              // keep socket work off the UI core
+#define NET_RX_TIMEOUT_MS 250           // recv timeout so reopen requests are noticed promptly
+#define NET_MCAST_TIMEOUT_MS 10000      // no multicast snapshot for this long -> back to unicast (hub refreshes every 2 s)
+#define NET_MCAST_RETRY_MS 300000       // how long to stay on unicast before offering multicast again
+
+enum NetEventType : uint8_t {
+  NET_EV_REGISTERED,
+  NET_EV_DISCOVER_REPLY,
+  NET_EV_HEARTBEAT_ACK,
+  NET_EV_REGISTER_REQUIRED,
+  NET_EV_TALLY,
+  NET_EV_ADMIN_MESSAGE,
+  NET_EV_ASSIGNMENT,
+  NET_EV_SNAPSHOT,
+  NET_EV_SYNC_DONE
+};
+
+// Decoded hub message. Which fields are meaningful depends on type; strings are always NUL-terminated.
+struct NetEvent {
+  NetEventType type;
+  unsigned long receivedAt;  // millis() when the datagram was read off the socket
+  bool program;              // tally
+  bool preview;              // tally
+  bool recording;            // tally
+  bool streaming;            // tally
+  bool assigned;             // assignment: mode == "assigned"
+  bool slotValid;            // snapshot: tally bits belong to our assigned slot / assignment, registered: slot supplied
+  bool resumed;              // registered: reply to a session resume, nothing to reset
+  bool fromStandby;          // sent by the standby hub (handled by handleStandbyEvent)
+  bool hasColor;             // admin_message: valid #RRGGBB supplied
+  uint16_t color;            // admin_message: background as RGB565
+  uint16_t port;             // discover_reply: udpPort (0 = keep current)
+  uint32_t duration;         // admin_message: ms (0 = default), register_required: retryAfter ms (0 = none), registered: sessionTtl ms,
+                             // sync_done: pages replayed
+  uint32_t seq;              // tally/snapshot: state version from the hub (0 = unsequenced), sync_done: snapshot seq
+  uint64_t sourceHash;       // tally: tallyHashSource() of the source id, filled for both encodings,
+                             // assignment: of the whole sourceId, which id may hold only in part
+  uint16_t slot;             // assignment, registered: snapshot slot of the assigned source
+  uint16_t slotEpoch;        // assignment, registered: slot table epoch the slot belongs to
+  uint32_t mcastGroup;       // registered: multicast group to join (network order, 0 = unicast only)
+  uint32_t echoT;            // heartbeat_ack, discover_reply: the probe's "t" (device millis()), 0 = not echoed
+  uint32_t epoch;            // registered, heartbeat_ack: the hub's leadership epoch (0 = not stamped)
+  uint32_t features;         // registered: negotiated TALLY_CAP_* set (0 = hub predates negotiation)
+  char id[64];               // assignment sourceId / admin message id / discover hubIp / registered session token
+  char name[96];             // tally name (assigned or program source only) / assignment sourceName / admin message text / snapshot live source
+};
+
+// Receive path counters. Most fields have a single writer, the net task or loop(), and are plain; a 64-bit
+// sum read by /status mid-update only skews a displayed average. sendErrors is bumped by udpSendTo() from
+// both tasks (loop sends, the net task acks duplicates), so it is atomic.
+struct NetRxStats {
+  uint32_t received;         // datagrams read from the socket
+  uint32_t dropped;          // decoded events discarded because the queue was full
+  uint32_t parseErrors;      // datagrams that were not a recognised hub message
+  uint32_t oversize;         // datagrams longer than TALLY_MAX_DATAGRAM, rejected without parsing
+  uint32_t socketErrors;     // recvfrom failures (socket gets reopened)
+  std::atomic<uint32_t> sendErrors; // sendto failures or unresolved hub address
+  uint32_t queueHighWater;   // deepest queue occupancy seen
+  unsigned long maxApplyLatencyMs; // worst receive -> state-applied delay seen by loop()
+  uint32_t binaryFrames;     // datagrams decoded via the binary tally frame path
+  uint32_t jsonFrames;       // datagrams decoded via deserializeJson
+  uint64_t binaryDecodeUs;   // cumulative decode time per path, for the averages on /status
+  uint64_t jsonDecodeUs;
+  uint32_t earlyRejects;     // JSON tally datagrams for other sources dropped by the raw pre-scan
+  uint64_t earlyRejectCycles; // CPU cycles spent on those, vs. jsonDecodeCycles for the full parse
+  uint64_t jsonDecodeCycles;
+  uint32_t seqStale;         // tally/snapshot versions older than the one already applied (reordered)
+  uint32_t seqDuplicates;    // same version received again
+  uint32_t seqGaps;          // versions skipped between two applied ones (lost datagrams)
+  uint32_t seqResyncs;       // large backwards jumps taken as a hub restart
+  uint32_t mcastFrames;      // snapshots received through the multicast group
+  uint32_t mcastFallbacks;   // times the group went quiet and the device fell back to unicast
+  uint32_t probeTimeouts;    // heartbeats not acknowledged within the RTO
+  uint32_t standbyDropped;   // standby hub datagrams other than heartbeat_ack / registered / register_required
+  uint32_t unnegotiated;     // tally in a format the hub did not negotiate, dropped unparsed
+  uint32_t deduplicated;     // tally datagrams identical to the last one for their source, dropped before decoding
+  uint32_t tallyApplied;     // tally/snapshot versions that passed the sequence check and were applied
+};
+static NetRxStats gNetStats = {};
+
+static NetEvent gNetQueue[NET_EVENT_QUEUE_LEN];
+static std::atomic<uint32_t> gNetQueueHead(0); // next slot written by the net task
+static std::atomic<uint32_t> gNetQueueTail(0); // next slot read by loop()
+
+static int gUdpSock = -1;                      // only the net task opens/closes it
+static uint32_t gMcastJoined = 0;              // group the socket is a member of (net task only)
+static std::atomic<uint32_t> gMcastGroup(0);   // group the hub handed out, 0 = unicast (written by the net task)
+static std::atomic<uint32_t> gMcastLastRx(0);  // millis() of the last multicast snapshot or of the join
+static std::atomic<uint32_t> gNetDupRxAt(0);   // millis() of the latest deduplicated tally datagram, 0 = taken by loop()
+static TallyDedupCache gNetDedup = {};         // net task only
+static std::atomic<uint32_t> gHubFeatures(0);    // TALLY_CAP_* set the hub negotiated in "registered" (0 = none, accept all)
+static std::atomic<uint32_t> gStandbyHubAddr(0); // standby hub IPv4, network order (0 = none; see publishStandbyHub)
+static std::atomic<uint32_t> gStandbyHubPort(0); // and its UDP port, network order
+static SemaphoreHandle_t gUdpSockMutex = nullptr; // guards gUdpSock against sends during a reopen
+static volatile bool gNetReopenRequested = false;
+static volatile uint16_t gNetBindPort = 0;
+
+// Snapshot slot of the assigned source as (epoch << 16 | slot). Written by the net task as assignment
+// messages are decoded, so every later snapshot in the same stream is read with the right slot.
+#define NET_NO_SLOT_KEY 0xFFFFFFFFUL
+static std::atomic<uint32_t> gAssignedSlotKey(NET_NO_SLOT_KEY);
+
+// assignedSourceHash, published by internAssignedSource() and by the net task as it
+// decodes assignments. Tally updates for any other source are dropped on the net task, except program
+// updates, which feed currentLiveSource.
+static std::atomic<uint64_t> gAssignedHash(0);
+static TaskHandle_t gNetRxTaskHandle = nullptr;
+static TaskHandle_t gLoopTaskHandle = nullptr; // woken whenever an event is queued or a button changes
+
+// loop() sleeps on its task notification until the earliest deadline registered during the pass
+// (loopWakeAt), capped at LOOP_IDLE_MAX_MS so the web portal's handleClient() stays responsive.
+// The net task notifies on every queued hub message and the button ISRs on every edge.
+#define LOOP_IDLE_MAX_MS 250
+#define LOOP_UI_TICK_MS 100       // overlays, held buttons and press sequences keep the old loop period
+#define LOOP_DEBOUNCE_TICK_MS 15  // re-poll while a raw button level disagrees with M5Unified's debounced state
+#define BUTTON_A_PIN 37           // same wiring on M5StickC Plus and Plus2
+#define BUTTON_B_PIN 39
+static uint32_t gLoopSleepMs = LOOP_IDLE_MAX_MS;
+static uint32_t gLoopPasses = 0;
 
 // -----------------------------------------------------------------------------
 // Runtime UI Configuration (can be changed via web UI; persisted in Preferences)
@@ -81,16 +230,49 @@ struct UIConfig {
 } uiCfg;
 // -----------------------------------------------------------------------------
 unsigned long lastHeartbeat = 0;
-unsigned long lastWiFiCheck = 0;
 unsigned long lastUDPRestart = 0;
 unsigned long configModeTimeout = 0;
-const unsigned long HEARTBEAT_INTERVAL = 30000;  // 30 seconds
-const unsigned long WIFI_CHECK_INTERVAL = 5000; // 5 seconds (improved from 10s)
+const unsigned long HEARTBEAT_INTERVAL = 30000;  // starting heartbeat interval (see heartbeatIntervalMs)
 const unsigned long UDP_RESTART_INTERVAL = 300000; // 5 minutes
 const unsigned long CONFIG_MODE_TIMEOUT = 300000; // 5 minutes
 const unsigned long HUB_TIMEOUT = 60000; // 60 seconds timeout for hub connection (increased from 15s)
 const unsigned long CONNECTION_CHECK_INTERVAL = 2000; // Check connection every 2 seconds
 
+// Hub liveness. Heartbeats double as probes: each ack is an RTT sample and an unacked probe is retried after
+// the RTO; LIVENESS_MAX_MISSES in a row declare the hub lost. While this light is in PROGRAM or PREVIEW a
+// probe goes out after LIVENESS_ACTIVE_PROBE_MS without hub traffic; when idle only the regular heartbeat
+// runs, and HUB_TIMEOUT stays as the backstop.
+#define LIVENESS_ACTIVE_PROBE_MS 300
+#define LIVENESS_MAX_MISSES 3
+static TallyRtt gHubRtt = {};
+static uint32_t gProbeOutstanding = 0;  // "t" of the unacknowledged heartbeat, 0 = none
+static unsigned long gProbeSentAt = 0;
+static uint8_t gProbeMisses = 0;
+static bool gProbeRetried = false;      // the outstanding probe is a retry after a timeout
+bool hubLinkLost = false;               // probes went unanswered; show HUB LOST until the hub answers again
+
+// The regular heartbeat adapts to the link. Each probe acknowledged first time stretches the interval by
+// HEARTBEAT_STEP_MS up to HEARTBEAT_MAX_MS. A timeout halves it, but not below HEARTBEAT_MIN_MS. The maximum
+// plus three RTO retries stays inside HUB_TIMEOUT. Any other exchange that carries a probe (an
+// admin_message_ack, a registration) counts as the interval's heartbeat, so a busy device sends none.
+const unsigned long HEARTBEAT_MIN_MS = 15000;
+const unsigned long HEARTBEAT_MAX_MS = 45000;
+const unsigned long HEARTBEAT_STEP_MS = 5000;
+unsigned long heartbeatIntervalMs = HEARTBEAT_INTERVAL;
+uint32_t heartbeatsSent = 0;            // regular heartbeats (probes and retries not counted)
+uint32_t heartbeatsPiggybacked = 0;     // intervals covered by a probe riding on another message
+std::atomic<uint32_t> tallyAcksSent(0); // tally_ack replies; the net task acks retransmitted duplicates again
+
+// Tally sync after registering (TALLY_CAP_SYNC): the "Connecting..." overlay stays up until sync_done
+const char *const SYNC_SCOPE = "all";  // the program bus on air too, for the live source line
+const uint8_t SYNC_MAX_ATTEMPTS = 2;    // each waits one RTO for sync_done
+bool syncPending = false;
+bool syncAfterResume = false;           // the overlay simply ends afterwards, no "Connected"
+uint8_t syncAttempts = 0;
+unsigned long syncRequestedAt = 0;
+unsigned long lastSyncMs = 0;           // first request to sync_done, for /status
+uint32_t syncsCompleted = 0;
+
 // Tally state
 bool isProgram = false;
 bool isPreview = false;
@@ -102,6 +284,12 @@ String currentSource = "";
 String assignedSource = ""; // The source this device is assigned to
 String assignedSourceName = ""; // The human-readable name of the assigned source
 String customDisplayName = ""; // Custom display name set via web portal
+uint64_t assignedSourceHash = 0; // tallyHashSource(assignedSource), interned once per assignment change
+String assignedDisplayName = ""; // cleaned assignedSourceName (or id), computed once per assignment change
+uint32_t lastTallySeq = 0;    // last applied state version of the assigned source (0 = none since assignment)
+uint32_t lastSnapshotSeq = 0; // last applied snapshot version (0 = none since registration)
+bool multicastSuspended = false;       // multicast went quiet; registering with mcast:false until the retry
+unsigned long multicastSuspendedAt = 0;
 bool isAssigned = false;    // Whether device has an assignment
 unsigned long lastTallyUpdate = 0;
 String currentLiveSource = ""; // Track what source is currently live for display context
@@ -110,9 +298,98 @@ unsigned long lastLiveSourceUpdate = 0; // When we last updated the live source
 // Hub connection tracking
 unsigned long lastHubResponse = 0;
 unsigned long hubConnectionAttempts = 0;
-unsigned long lastReconnectionAttempt = 0;
-const unsigned long MAX_HUB_RECONNECT_ATTEMPTS = 5;
-const unsigned long MIN_RECONNECTION_INTERVAL = 15000; // 15 seconds between attempts
+String hubSession = "";                 // resume token from the last full registration ("" = none)
+unsigned long hubSessionTtl = 0;        // the hub keeps the session this long after it last heard from us
+unsigned long hubSessionSeenAt = 0;     // last hub message (lastHubResponse is also reset on Wi-Fi joins)
+uint32_t sessionResumes = 0;
+
+// Optional standby hub. It holds a passive registration of its own (`standby: true`: the hub sends it only
+// registered and heartbeat_ack), kept alive by a heartbeat every STANDBY_HEARTBEAT_MS, so failing over is a
+// swap of endpoints and a resume rather than a register round trip. Anything else it sends is dropped on the
+// net task. Hubs stamp a leadership "epoch" on their JSON messages and the device follows the live hub with
+// the higher one (see standbyStep).
+struct StandbyHub {
+  String ip;                // "" = none configured (an IP address; this path does no DNS)
+  int port;
+  bool registered;          // it has confirmed our registration and answers heartbeats
+  uint32_t epoch;           // leadership epoch from its last registered / heartbeat_ack
+  unsigned long lastRx;     // millis() of its last message
+  unsigned long nextTxAt;   // next heartbeat or registration attempt
+  uint32_t attempts;        // unanswered registrations, for tallyBackoffMs()
+  String session;           // resume token it handed out
+  uint32_t slotKey;         // its snapshot slot key for our source (NET_NO_SLOT_KEY = none)
+  uint32_t features;        // TALLY_CAP_* set it negotiated in its "registered"
+};
+StandbyHub standbyHub = { "", 7411, false, 0, 0, 0, 0, "", NET_NO_SLOT_KEY, 0 };
+uint32_t hubEpoch = 0;                  // leadership epoch of the active hub (0 = not stamped)
+uint32_t hubFailovers = 0;              // switches to the standby hub
+const unsigned long STANDBY_HEARTBEAT_MS = 10000;
+const unsigned long STANDBY_ALIVE_MS = 3 * STANDBY_HEARTBEAT_MS + 5000;
+const unsigned long MAX_HUB_RECONNECT_ATTEMPTS = 5;   // unanswered attempts before the display says "Hub Lost"
+uint32_t gBackoffRng = 1;                             // per-device jitter generator, seeded from the MAC in setup()
+
+// Connection manager. connStep() runs once per loop() pass and only ever checks a timestamp or a status,
+// so Wi-Fi joins and hub retries happen in the background while tally, buttons and the portal keep running.
+enum ConnState : uint8_t {
+  CONN_WIFI_JOINING,  // async scan for saved networks, then WiFi.begin() on each in turn
+  CONN_DISCOVERING,   // Wi-Fi up but no hub address yet: discovery probes (mDNS after the last one)
+  CONN_REGISTERING,   // register sent, waiting for "registered"
+  CONN_REGISTERED,    // normal operation; checkHubLiveness() watches the hub from here
+  CONN_BACKOFF,       // waiting before the next Wi-Fi round or hub attempt
+};
+static const char *const CONN_STATE_NAMES[] = { "WiFi Joining", "Discovering", "Registering", "Registered", "Backoff" };
+ConnState connState = CONN_WIFI_JOINING;
+unsigned long connStateSince = 0;
+unsigned long connDeadline = 0;          // millis() at which the current state gives up or moves on
+bool wifiEverConnected = false;          // until the first join succeeds, running out of networks means config mode
+unsigned long bootToRegisteredMs = 0;    // power-on to first "registered" (what a tally needs to show)
+
+// Timing of the most recent Wi-Fi join attempt, from the STA events (shown on /status)
+struct WiFiJoinTiming {
+  unsigned long beganAt;   // WiFi.begin()
+  unsigned long assocMs;   // begin -> associated
+  unsigned long ipMs;      // associated -> got IP (about 0 with a cached lease)
+  bool directed;           // BSSID and channel from the fast-join cache, no scan
+  bool cachedLease;        // static config from the cached DHCP lease
+};
+WiFiJoinTiming lastJoin = {};
+const unsigned long CONN_WIFI_SCAN_TIMEOUT_MS = 8000;
+const unsigned long CONN_WIFI_DIRECT_TIMEOUT_MS = 4000; // directed join from the fast-join cache, then scan
+const unsigned long CONN_WIFI_JOIN_TIMEOUT_MS = 10000; // per network
+const unsigned long CONN_WIFI_RETRY_MS = 30000;        // between rounds over all saved networks
+const unsigned long CONN_REGISTER_TIMEOUT_MS = 3000;   // wait for "registered" before backing off
+
+// Hub auto-discovery pacing (see attemptHubDiscovery)
+static unsigned long gLastDiscoveryAttempt = 0;
+static uint8_t gDiscoveryAttempts = 0;
+const unsigned long DISCOVERY_INTERVAL_MS = 4000; // backoff window between probes
+const uint8_t DISCOVERY_MAX_ATTEMPTS = 6; // stop after ~24s initial scan (will retry on later recon cycles)
+
+// Hubs that answered the current discovery round. Replies collect for DISCOVERY_WINDOW_MS after a probe
+// (and until an mDNS query finishes); the window then closes on the best one (see closeDiscoveryWindow).
+struct HubCandidate {
+  uint32_t ip;      // network order
+  uint16_t port;
+  uint32_t rttMs;   // probe round trip, DISCOVERY_NO_RTT for mDNS answers
+  bool sameSubnet;  // on our own subnet (no router in between)
+};
+const uint8_t DISCOVERY_MAX_CANDIDATES = 4;
+const unsigned long DISCOVERY_WINDOW_MS = 400;
+const uint32_t DISCOVERY_NO_RTT = 0xFFFFFFFF;
+const uint32_t MDNS_QUERY_TIMEOUT_MS = 3000;
+static HubCandidate gHubCandidates[DISCOVERY_MAX_CANDIDATES];
+static uint8_t gHubCandidateCount = 0;
+static bool gDiscoveryWindowOpen = false;
+static unsigned long gDiscoveryWindowEnd = 0;
+static unsigned long gDiscoveryProbeAt = 0;      // millis() of the last probe, for hubs that do not echo "t"
+static mdns_search_once_t *gMdnsSearch = nullptr; // asynchronous _tallyhub._udp query in flight
+uint8_t lastDiscoveryHubs = 0;                   // hubs that answered the last closed round
+
+// The hub in hub_ip/hub_port is the cached discovery winner. It is used straight away on every (re)connect;
+// it only counts as confirmed for HUB_CACHE_TTL_MS after it last answered, and an unconfirmed cache (always
+// the case after boot: there is no wall clock to age the flash copy by) is revalidated by a background probe.
+unsigned long hubConfirmedAt = 0; // millis() the cached hub last answered (0 = not since boot)
+const unsigned long HUB_CACHE_TTL_MS = 300000;
 
 // Assignment confirmation display state
 bool showingAssignmentConfirmation = false;
@@ -174,20 +451,53 @@ const unsigned long NETWORK_SELECTION_TIMEOUT = 10000; // 10 seconds
 Preferences preferences;
 
 // Function declarations
-void connectToWiFi();
-void checkWiFiConnection();
-void reconnectWiFi();
+void connBegin();
+void connStep();
+void connEnter(ConnState state, unsigned long timeoutMs);
+void connStartWiFiJoin();
+void connStartWiFiScan();
+void connJoinNetwork(const String &ssid, const String &password);
+void connStartRegistering();
+bool resumeHubSession();
+void connRoamTo(int index, const WiFiFastJoin &target);
+void roamStep();
 void restartUDP();
 void ensureUDPConnection();
-void checkHubConnection();
-void registerWithHub();
-void sendHeartbeat();
+void registerWithHub(bool standby = false);
+void sendHeartbeat(bool probeOnly = false);
+void attachLivenessProbe(JsonDocument &doc);
+void sendTallyAck(bool snapshot, uint32_t seq);
+bool requestTallySync(bool resumed);
+void syncStep();
+void finishTallySync(bool answered);
+void checkHubLiveness();
+void declareHubLost(const char *reason);
+static bool standbyAlive();
+static void switchToStandby(const char *reason, bool oldRegistered, uint32_t retryMs);
+void checkMulticastDelivery();
 void handleUDPMessages();
-void attemptHubDiscovery(bool force=false);
+void startNetRxTask();
+bool udpSendTo(IPAddress ip, uint16_t port, const uint8_t *data, size_t len);
+bool sendToHub(const uint8_t *data, size_t len);
+bool sendToHub(const String &message);
+bool sendToStandbyHub(const String &message);
+void publishStandbyHub();
+void standbyStep();
+bool attemptHubDiscovery(bool force=false);
+void resetHubDiscovery();
 bool performDiscoveryExchange();
-bool attemptMdnsLookup();
-void handleTallyUpdate(JsonObject data);
+void discoveryStep();
+bool hubCacheFresh();
+void addHubCandidate(uint32_t ip, uint16_t port, uint32_t rttMs);
+void handleTallyUpdate(const NetEvent &ev);
+void handleTallySnapshot(const NetEvent &ev);
+void updateLiveSource(const char *sourceName);
+void applyAssignedTally(bool program, bool preview, bool recording, bool streaming);
+void internAssignedSource(uint64_t sourceHash = 0);
 void handleButtons();
+void loopWakeAt(unsigned long deadline);
+void loopWakeIn(unsigned long ms);
+void attachButtonWakeups();
 void updateDisplay();
 // Helper to force next updateDisplay to repaint immediately after overlay dismissal
 void forceImmediateDisplay();
@@ -226,12 +536,9 @@ void addNetworkToMemory(String ssid, String password);
 bool removeNetworkFromMemory(int index);
 void clearAllSavedNetworks();
 void addNetworkToMemory(String ssid, String password);
-bool connectToKnownNetworks();
-bool tryConnectToNetwork(String ssid, String password);
 void saveConfiguration();
 void loadAssignment();
 void saveAssignment();
-bool connectToSavedWiFi();
 String cleanSourceName(String sourceName);
 
 // Battery indicator support
@@ -255,6 +562,29 @@ static int gBattPctLeftX = -1; // updated each drawBatteryIndicator; -1 means un
 static unsigned long gBatAnimLast = 0;
 static int gBatAnimPhase = 0;
 
+// ---- Off-screen frame ----
+// All UI is drawn through gDraw into gFrame, a full-screen sprite, and reaches the panel only in
+// flushFrame(): it hashes the FRAME_TILE x FRAME_TILE tiles inside the dirty rectangle and pushes the
+// ones whose pixels differ from what the panel shows. Repainting unchanged content costs no SPI traffic.
+#define FRAME_TILE 16
+static M5Canvas gFrame(&M5.Lcd);
+static lgfx::LovyanGFX *gDraw = &M5.Lcd;  // gFrame once allocated; the panel itself if the sprite does not fit
+static uint32_t *gFrameTileHash = nullptr; // per tile, hash of the pixels last pushed
+static int gFrameTileCols = 0, gFrameTileRows = 0;
+static int gDirtyX0 = 0, gDirtyY0 = 0, gDirtyX1 = 0, gDirtyY1 = 0; // half-open; empty when x1 <= x0
+static bool gFramePushAll = true; // next flush pushes every tile (first frame)
+struct FrameStats {
+  uint32_t flushes;          // flushes that pushed at least one tile
+  uint32_t windows;          // panel address windows written
+  uint64_t bytesPushed;      // pixel bytes sent over SPI
+  uint32_t lastFlushBytes;
+  uint32_t lastChangeBytes;  // bytes pushed for the latest tally/status change on screen
+};
+static FrameStats gFrameStats = {};
+void frameBegin();
+void frameDirty(int x, int y, int w, int h);
+void flushFrame();
+
 void setup() {
   #ifdef M5STICKC_PLUS2
   auto cfg = M5.config();
@@ -262,14 +592,16 @@ void setup() {
   #else
   M5.begin();
   #endif
+  attachButtonWakeups(); // button edges wake loop() out of its sleep
   
   // (Optional AXP192 tweaks removed for uniform behavior across Plus and Plus2)
   
   // Configure display for M5StickC Plus / Plus2
   M5.Lcd.setRotation(3);  // Landscape mode for better text display
   M5.Lcd.fillScreen(BLACK);
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setTextSize(2);
+  frameBegin(); // after the rotation, so the sprite takes the landscape size
+  gDraw->setTextColor(WHITE);
+  gDraw->setTextSize(2);
   
   // Generate unique AP name using MAC address
   String macAddress = WiFi.macAddress();
@@ -277,6 +609,9 @@ void setup() {
   String uniqueId = macAddress.substring(6); // Use last 6 characters of MAC
   AP_SSID = "M5-Tally-Config-" + uniqueId;
   Serial.println("Generated AP SSID: " + AP_SSID);
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  gBackoffRng = tallyBackoffSeed(mac); // hub retry jitter differs per device
   
   // Initialize preferences
   preferences.begin("tally", false);
@@ -310,68 +645,20 @@ void setup() {
     delay(2000);
   }
   
-  // Try to connect to WiFi using memory system or fallback to saved WiFi
-  bool wifiConnected = false;
-  if (!forceConfigMode) {
-    // First try known networks from memory
-    if (networkCount > 0) {
-      showStatus("Auto Connect", BLUE);
-      wifiConnected = connectToKnownNetworks();
-    }
-    
-    // Fallback to legacy saved WiFi if memory connection failed
-    if (!wifiConnected && wifi_ssid.length() > 0) {
-      showStatus("Connecting...", BLUE);
-      wifiConnected = connectToSavedWiFi();
-    }
-  }
-  
-  if (wifiConnected) {
-    // Connected to WiFi
-    isConnected = true;
-    lastHubResponse = millis(); // Initialize hub response tracking
-    hubConnectionAttempts = 0;
-    showStatus("WiFi OK", GREEN);
-    delay(1000);
-
-    // Start mDNS responder early so hub can find us if needed (optional hostname: tally-<id>)
-    if (!MDNS.begin(device_id.c_str())) {
-      Serial.println("mDNS start failed");
-    } else {
-      Serial.println("mDNS responder started");
-    }
-    
-    // Start UDP
-    udp.begin(hub_port + 1); // Use different port for receiving
-
-    // Auto-discovery AFTER UDP listener starts so we can receive reply
-    if (auto_discovery_enabled && hub_ip.length() == 0) {
-      Serial.println("Hub IP not configured, starting auto-discovery...");
-      attemptHubDiscovery();
-      // mDNS fallback if no hub learned after initial UDP attempts (deferred in attemptHubDiscovery logic)
-    }
-    
-    // Start web server for configuration access
-    setupWebServer();
-    server.begin();
-    Serial.println("Web server started on WiFi network");
-    Serial.print("Access device at: http://");
-    Serial.println(WiFi.localIP());
-    
-    // Register with hub
-    registerWithHub();
-    
-    showStatus("Ready", GREEN);
-    delay(1000);
-  } else {
-    // Start configuration mode
+  if (forceConfigMode) {
     startConfigMode();
+  } else {
+    // Join a saved network in the background; connStep() brings up mDNS, UDP, the web server and
+    // registration once it associates, or falls back to config mode if none of them does
+    showStatus("Auto Connect", BLUE);
+    connBegin();
   }
 
   // Ensure status icons visible immediately regardless of later limiter logic
   BatteryInfo initBat = readBattery();
   drawBatteryIndicator(initBat);
   drawWiFiIndicator();
+  flushFrame();
 }
 
 // Fast connection monitoring function
@@ -395,12 +682,7 @@ void monitorConnectionStatus() {
     if (WiFi.status() == WL_CONNECTED && isRegisteredWithHub) {
       unsigned long timeSinceLastResponse = millis() - lastHubResponse;
       if (timeSinceLastResponse > HUB_TIMEOUT && lastHubResponse > 0) {
-        Serial.println("Hub timeout detected in monitor - immediate response!");
-        isConnected = false;
-        isRegisteredWithHub = false;
-        currentSource = "";
-        // Force immediate display update to show HUB LOST
-        showStatus("HUB LOST", RED);
+        declareHubLost("no hub traffic within HUB_TIMEOUT");
       }
     }
     
@@ -408,7 +690,33 @@ void monitorConnectionStatus() {
   }
 }
 
+// Ask the current loop() pass to run again no later than deadline (a millis() value)
+void loopWakeAt(unsigned long deadline) {
+  long remaining = (long)(deadline - millis());
+  uint32_t ms = remaining > 0 ? (uint32_t)remaining : 0;
+  if (ms < gLoopSleepMs) gLoopSleepMs = ms;
+}
+
+void loopWakeIn(unsigned long ms) {
+  loopWakeAt(millis() + ms);
+}
+
+static void IRAM_ATTR onButtonEdge() {
+  BaseType_t woken = pdFALSE;
+  if (gLoopTaskHandle != nullptr) vTaskNotifyGiveFromISR(gLoopTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// GPIO39 can raise spurious edges while Wi-Fi is active (ESP32 errata); each one only costs a loop pass
+void attachButtonWakeups() {
+  gLoopTaskHandle = xTaskGetCurrentTaskHandle();
+  attachInterrupt(digitalPinToInterrupt(BUTTON_A_PIN), onButtonEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_B_PIN), onButtonEdge, CHANGE);
+}
+
 void loop() {
+  gLoopSleepMs = LOOP_IDLE_MAX_MS;
+  gLoopPasses++;
   M5.update();
   
   // Handle configuration mode
@@ -423,20 +731,17 @@ void loop() {
   // Handle web server requests when connected to WiFi
   server.handleClient();
   
-  // Check WiFi connection
-  if (millis() - lastWiFiCheck > WIFI_CHECK_INTERVAL) {
-    checkWiFiConnection();
-    lastWiFiCheck = millis();
-  }
+  // Wi-Fi join, hub discovery/registration and retries (never blocks)
+  connStep();
+  if (configMode) return; // no saved network could be joined
+  roamStep();
+  standbyStep();
+  discoveryStep();
+  syncStep();
+  checkMulticastDelivery();
   
-  // Check hub connection and attempt reconnection if needed
-  checkHubConnection();
-  
-  // Send heartbeat
-  if (millis() - lastHeartbeat > HEARTBEAT_INTERVAL) {
-    sendHeartbeat();
-    lastHeartbeat = millis();
-  }
+  // Heartbeat / liveness probes
+  checkHubLiveness();
   
   // Check for incoming UDP messages
   handleUDPMessages();
@@ -463,6 +768,7 @@ void loop() {
   static int lastWifiLevel = -1;
   static bool lastCharging = false;
   static bool lastBlinkVisible = true;
+  static bool lastLowBattBlinking = false;
   const unsigned long MIN_INTERVAL = 250;   // don't redraw faster than this
   const unsigned long MAX_INTERVAL = 5000;  // force redraw at least this often
   unsigned long now = millis();
@@ -481,6 +787,7 @@ void loop() {
     bool lowBattBlinking = (!b.charging && b.percent < 15);
     if (pctBucket != lastPctBucket || wifiLevel != lastWifiLevel || b.charging != lastCharging) need = true;
     if (lowBattBlinking && blinkOn != lastBlinkVisible) need = true;
+    lastLowBattBlinking = lowBattBlinking;
     if ((now - lastHud) >= MAX_INTERVAL) need = true; // periodic refresh guard
     if (need) {
       drawBatteryIndicator(b);
@@ -492,175 +799,612 @@ void loop() {
       lastHud = now;
     }
   }
-  
-  delay(100);
+  flushFrame(); // one push per pass for whatever the pass drew
+  
+  // Deadlines for the timers above; anything without one is picked up within LOOP_IDLE_MAX_MS
+  if (connState != CONN_REGISTERED) loopWakeAt(connDeadline);
+  if (gAdminMessageActive) loopWakeAt(gAdminMessageExpire + 1);
+  if (lastLowBattBlinking) loopWakeAt((now / 700UL + 1UL) * 700UL);
+  bool rawA = digitalRead(BUTTON_A_PIN) == LOW;
+  bool rawB = digitalRead(BUTTON_B_PIN) == LOW;
+  if (rawA != M5.BtnA.isPressed() || rawB != M5.BtnB.isPressed()) {
+    loopWakeIn(LOOP_DEBOUNCE_TICK_MS);
+  } else if (rawA || rawB || showingAssignmentConfirmation || showingRegistrationStatus || networkSelectionMode || gAdminMessageActive) {
+    loopWakeIn(LOOP_UI_TICK_MS);
+  }
+
+  // Sleep until the earliest deadline, a queued hub message or a button edge
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(gLoopSleepMs));
 }
 
 // WiFi and UDP Connection Management Functions for M5Stick
 
-void reconnectWiFi() {
-  static unsigned long lastReconnectAttempt = 0;
-  static int reconnectAttempts = 0;
-  const unsigned long RECONNECT_INTERVAL = 30000; // 30 seconds between attempts
-  const int MAX_RECONNECT_ATTEMPTS = 10;
-  
-  if (millis() - lastReconnectAttempt < RECONNECT_INTERVAL) {
-    return; // Too soon to try again
+void restartUDP() {
+  Serial.println("Restarting UDP connection...");
+  gNetBindPort = hub_port + 1; // Use consistent companion port
+  if (gNetRxTaskHandle == nullptr) {
+    startNetRxTask();
+  } else {
+    gNetReopenRequested = true; // net task closes and rebinds on its next wakeup
   }
-  
-  lastReconnectAttempt = millis();
-  reconnectAttempts++;
-  
-  Serial.printf("WiFi reconnection attempt %d/%d\n", reconnectAttempts, MAX_RECONNECT_ATTEMPTS);
-  
-  // Reset WiFi and try to reconnect
-  WiFi.disconnect();
-  delay(1000);
-  
-  // Use stored credentials
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(wifi_ssid.c_str(), wifi_password.c_str());
-  
-  // Wait up to 15 seconds for connection
-  unsigned long connectStart = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - connectStart < 15000) {
-    delay(500);
-    Serial.print(".");
+}
+
+// Close the current socket (if any) and bind a fresh one. Runs on the net task (or before it starts).
+static bool openUdpSocket(uint16_t port) {
+  xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+  if (gUdpSock >= 0) {
+    close(gUdpSock);
+    gUdpSock = -1;
   }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWiFi reconnected successfully!");
-    Serial.println("IP address: " + WiFi.localIP().toString());
-    reconnectAttempts = 0;
-    
-    // Restart UDP and re-register with hub
-    restartUDP();
-    isConnected = false;
-    isRegisteredWithHub = false;
+  xSemaphoreGive(gUdpSockMutex);
+
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) return false;
+  int yes = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  setsockopt(s, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes)); // discovery probes
+  struct timeval tv = { 0, NET_RX_TIMEOUT_MS * 1000 };
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(s);
+    return false;
+  }
+
+  xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+  gUdpSock = s;
+  xSemaphoreGive(gUdpSockMutex);
+  return true;
+}
+
+static bool netQueuePush(const NetEvent &ev) {
+  uint32_t head = gNetQueueHead.load(std::memory_order_relaxed);
+  uint32_t tail = gNetQueueTail.load(std::memory_order_acquire);
+  if (head - tail >= NET_EVENT_QUEUE_LEN) return false;
+  gNetQueue[head & (NET_EVENT_QUEUE_LEN - 1)] = ev;
+  gNetQueueHead.store(head + 1, std::memory_order_release);
+  if (head + 1 - tail > gNetStats.queueHighWater) gNetStats.queueHighWater = head + 1 - tail;
+  return true;
+}
+
+static bool netQueuePop(NetEvent &ev) {
+  uint32_t tail = gNetQueueTail.load(std::memory_order_relaxed);
+  uint32_t head = gNetQueueHead.load(std::memory_order_acquire);
+  if (tail == head) return false;
+  ev = gNetQueue[tail & (NET_EVENT_QUEUE_LEN - 1)];
+  gNetQueueTail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+static uint32_t netQueueDepth() {
+  return gNetQueueHead.load(std::memory_order_acquire) - gNetQueueTail.load(std::memory_order_acquire);
+}
+
+template <size_t N>
+static void copyField(char (&dst)[N], const char *src) {
+  strncpy(dst, src ? src : "", N - 1);
+  dst[N - 1] = '\0';
+}
+
+// Parse a "#RRGGBB" string into RGB565. Returns false if malformed.
+static bool parseHexColor565(const char *hex, uint16_t &out) {
+  if (hex == nullptr) return false;
+  if (*hex == '#') hex++;
+  if (strlen(hex) != 6) return false;
+  char *end = nullptr;
+  unsigned long rgb = strtoul(hex, &end, 16);
+  if (end == nullptr || *end != '\0') return false;
+  uint8_t r = (rgb >> 16) & 0xFF, g = (rgb >> 8) & 0xFF, b = rgb & 0xFF;
+  out = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  return true;
+}
+
+static bool decodeJsonMessage(const char *buffer, size_t len, HubMsgType type, NetEvent &ev);
+
+// Tally updates the loop will act on: our source, or any source in program (for currentLiveSource)
+static bool wantTally(bool program, uint64_t sourceHash) {
+  return program || sourceHash == gAssignedHash.load(std::memory_order_relaxed);
+}
+
+// Binary frames (see TallyProtocol.h): fixed header, no heap, name copied straight out of the datagram.
+// A snapshot carries every source; only the four bits of our assigned slot are kept.
+static bool decodeBinaryTally(const uint8_t *buffer, size_t len, NetEvent &ev) {
+  TallyFrame frame;
+  if (!tallyDecodeFrame(buffer, len, frame)) return false;
+  memset(&ev, 0, sizeof(ev));
+  ev.seq = frame.seq;
+  if (frame.kind == TALLY_KIND_SNAPSHOT) {
+    ev.type = NET_EV_SNAPSHOT;
+    uint32_t key = gAssignedSlotKey.load(std::memory_order_relaxed);
+    uint16_t slot = key & 0xFFFF;
+    ev.slotValid = key != NET_NO_SLOT_KEY && (key >> 16) == frame.tableEpoch && slot < frame.slotCount;
+    if (ev.slotValid) {
+      ev.program = tallySnapshotBit(frame, TALLY_PLANE_PROGRAM, slot);
+      ev.preview = tallySnapshotBit(frame, TALLY_PLANE_PREVIEW, slot);
+      ev.recording = tallySnapshotBit(frame, TALLY_PLANE_RECORDING, slot);
+      ev.streaming = tallySnapshotBit(frame, TALLY_PLANE_STREAMING, slot);
+    }
   } else {
-    Serial.println("\nWiFi reconnection failed");
-    
-    if (reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-      Serial.println("Max reconnection attempts reached, powering off (unified)...");
-      // Attempt graceful power off; if platform ignores, fallback to restart
-      M5.Power.powerOff();
-      delay(750);
-      esp_restart();
+    ev.type = NET_EV_TALLY;
+    ev.sourceHash = frame.sourceHash;
+    ev.program = frame.flags & TALLY_FLAG_PROGRAM;
+    ev.preview = frame.flags & TALLY_FLAG_PREVIEW;
+    ev.recording = frame.flags & TALLY_FLAG_RECORDING;
+    ev.streaming = frame.flags & TALLY_FLAG_STREAMING;
+    if (!wantTally(ev.program, ev.sourceHash)) return true; // filtered by the caller, skip the name
+  }
+  size_t n = frame.nameLen < sizeof(ev.name) - 1 ? frame.nameLen : sizeof(ev.name) - 1;
+  memcpy(ev.name, frame.name, n);
+  ev.name[n] = '\0';
+  return true;
+}
+
+enum NetDecodeResult : uint8_t {
+  NET_DECODE_ERROR,     // junk or unknown type
+  NET_DECODE_OK,
+  NET_DECODE_FILTERED,  // valid, but a tally update the loop would ignore
+  NET_DECODE_DUPLICATE  // tally identical to the last datagram for its source (see tallyPayloadHash)
+};
+
+// Dedup key for a source: re-assigning changes the key, so the new source's first resend is applied
+static uint64_t netDedupKey(uint64_t sourceKey) {
+  uint32_t slotKey = gAssignedSlotKey.load(std::memory_order_relaxed);
+  return sourceKey ^ gAssignedHash.load(std::memory_order_relaxed) ^ ((uint64_t)slotKey << 32 | slotKey);
+}
+
+// Decode one hub datagram into a NetEvent. Runs on the net task. Tally updates for other sources never
+// reach the queue: binary frames are filtered after the fixed header, JSON by a raw pre-scan of the
+// buffer (tallyScanJson) before any document is built.
+static NetDecodeResult decodeHubMessage(const char *buffer, size_t len, NetEvent &ev) {
+  int64_t start = esp_timer_get_time();
+  if (tallyIsBinaryFrame((const uint8_t *)buffer, len)) {
+    if (!tallyFrameNegotiated((const uint8_t *)buffer, len, gHubFeatures.load())) {
+      gNetStats.unnegotiated++;
+      return NET_DECODE_FILTERED;
     }
+    const uint8_t *raw = (const uint8_t *)buffer;
+    uint64_t key = len >= TALLY_FRAME_HEADER_LEN && (raw[1] & 0x0F) == TALLY_KIND_TALLY
+                   ? netDedupKey(tallyReadU64(raw + 8)) : netDedupKey(tallyDedupSnapshotKey(raw[2]));
+    uint32_t hash = tallyPayloadHash(raw, len);
+    if (tallyDedupHit(gNetDedup, key, hash, len)) {
+      gNetStats.deduplicated++;
+      return NET_DECODE_DUPLICATE;
+    }
+    bool ok = decodeBinaryTally((const uint8_t *)buffer, len, ev);
+    gNetStats.binaryFrames++;
+    gNetStats.binaryDecodeUs += esp_timer_get_time() - start;
+    if (!ok) return NET_DECODE_ERROR;
+    if (ev.type == NET_EV_TALLY && !wantTally(ev.program, ev.sourceHash)) return NET_DECODE_FILTERED;
+    tallyDedupStore(gNetDedup, key, hash, len);
+    return NET_DECODE_OK;
   }
+
+  uint32_t cycles = ESP.getCycleCount();
+  TallyJsonScan scan;
+  HubMsgType type = HUB_MSG_UNKNOWN;
+  bool dedupable = false; // a tally whose id the pre-scan read: key and hash below are set
+  uint64_t key = 0;
+  uint32_t hash = 0;
+  if (tallyScanJson(buffer, len, scan)) {
+    type = hubMessageType(scan.type, scan.typeLen);
+    uint32_t features = gHubFeatures.load();
+    if (type == HUB_MSG_TALLY && features != 0 && (features & TALLY_CAP_JSON_TALLY) == 0) {
+      gNetStats.unnegotiated++;
+      return NET_DECODE_FILTERED;
+    }
+    if (type == HUB_MSG_TALLY && scan.id != nullptr) {
+      uint64_t sourceHash = tallyHashSource(scan.id, scan.idLen);
+      if (!wantTally(scan.program, sourceHash)) {
+        gNetStats.earlyRejects++;
+        gNetStats.earlyRejectCycles += ESP.getCycleCount() - cycles;
+        return NET_DECODE_FILTERED;
+      }
+      key = netDedupKey(sourceHash);
+      hash = tallyPayloadHash((const uint8_t *)buffer, len);
+      if (tallyDedupHit(gNetDedup, key, hash, len)) {
+        gNetStats.deduplicated++;
+        return NET_DECODE_DUPLICATE;
+      }
+      dedupable = true;
+    }
+  }
+
+  bool ok = decodeJsonMessage(buffer, len, type, ev);
+  gNetStats.jsonFrames++;
+  gNetStats.jsonDecodeUs += esp_timer_get_time() - start;
+  gNetStats.jsonDecodeCycles += ESP.getCycleCount() - cycles;
+  if (!ok) return NET_DECODE_ERROR;
+  // Ids the pre-scan could not read (escapes, unusual layout) are filtered after the full parse instead
+  if (ev.type == NET_EV_TALLY && !wantTally(ev.program, ev.sourceHash)) return NET_DECODE_FILTERED;
+  if (dedupable) tallyDedupStore(gNetDedup, key, hash, len);
+  return NET_DECODE_OK;
 }
 
-void restartUDP() {
-  Serial.println("Restarting UDP connection...");
-  udp.stop();
-  delay(100);
-  
-  if (udp.begin(hub_port + 1)) { // Use consistent port 7413
-    Serial.println("UDP restarted successfully");
-  } else {
-    Serial.println("Failed to restart UDP");
+// ---- JSON hub messages ----
+// The type string is interned to a HubMsgType (TallyProtocol.h) and looked up in kHubHandlers. Each
+// handler declares the fields it reads as an ArduinoJson filter, built once at startup, so everything
+// else in the datagram (timestamps, device ids, ...) is skipped by the parser and never stored.
+// Documents live in a bump arena that is reset per datagram, so steady-state decoding does no heap
+// allocation (NetJsonArena.h).
+
+static NetJsonArena gNetJsonArena;
+
+struct HubMessageHandler {
+  HubMsgType type;
+  NetEventType event;
+  void (*declareFields)(JsonDocument &filter);
+  void (*decode)(JsonObjectConst msg, NetEvent &ev);
+};
+
+static void heartbeatAckFields(JsonDocument &f) { f["t"] = true; f["epoch"] = true; }
+static void decodeHeartbeatAck(JsonObjectConst msg, NetEvent &ev) {
+  ev.echoT = msg["t"] | 0UL;
+  ev.epoch = msg["epoch"] | 0UL;
+}
+
+static void registeredFields(JsonDocument &f) {
+  f["slot"] = true;
+  f["slotEpoch"] = true;
+  f["mcastGroup"] = true;
+  f["session"] = true;
+  f["sessionTtl"] = true;
+  f["resumed"] = true;
+  f["epoch"] = true;
+  f["features"] = true;
+}
+static void decodeRegistered(JsonObjectConst msg, NetEvent &ev) {
+  copyField(ev.id, msg["session"] | "");
+  ev.duration = msg["sessionTtl"] | 0UL;
+  ev.resumed = msg["resumed"] | false;
+  ev.epoch = msg["epoch"] | 0UL;
+  ev.features = msg["features"] | 0UL;
+  ev.slotValid = !msg["slot"].isNull();
+  ev.slot = msg["slot"] | TALLY_NO_SLOT;
+  ev.slotEpoch = msg["slotEpoch"] | 0;
+  IPAddress group;
+  bool isMulticast = group.fromString(msg["mcastGroup"] | "") && group[0] >= 224 && group[0] <= 239;
+  ev.mcastGroup = isMulticast ? (uint32_t)group : 0;
+}
+
+static void discoverReplyFields(JsonDocument &f) { f["hubIp"] = true; f["udpPort"] = true; f["t"] = true; }
+static void decodeDiscoverReply(JsonObjectConst msg, NetEvent &ev) {
+  copyField(ev.id, msg["hubIp"] | "");
+  ev.port = msg["udpPort"] | 0;
+  ev.echoT = msg["t"] | 0UL;
+}
+
+static void registerRequiredFields(JsonDocument &f) { f["retryAfter"] = true; }
+static void decodeRegisterRequired(JsonObjectConst msg, NetEvent &ev) {
+  ev.duration = msg["retryAfter"] | 0UL;
+}
+
+static void tallyFields(JsonDocument &f) {
+  JsonObject data = f["data"].to<JsonObject>();
+  data["id"] = true;
+  data["name"] = true;
+  data["program"] = true;
+  data["preview"] = true;
+  data["recording"] = true;
+  data["streaming"] = true;
+  data["seq"] = true;
+}
+static void decodeTally(JsonObjectConst msg, NetEvent &ev) {
+  JsonObjectConst data = msg["data"];
+  ev.sourceHash = tallyHashSource(data["id"] | ""); // hashed in place; the id itself is never copied
+  ev.program = data["program"] | false;
+  ev.preview = data["preview"] | false;
+  ev.recording = data["recording"] | false;
+  ev.streaming = data["streaming"] | false;
+  ev.seq = data["seq"] | 0UL;
+  copyField(ev.name, data["name"] | "");
+}
+
+static void adminMessageFields(JsonDocument &f) { f["id"] = true; f["text"] = true; f["duration"] = true; f["color"] = true; }
+static void decodeAdminMessage(JsonObjectConst msg, NetEvent &ev) {
+  copyField(ev.id, msg["id"] | "");
+  copyField(ev.name, msg["text"] | "");
+  ev.duration = msg["duration"] | 0UL;
+  ev.hasColor = parseHexColor565(msg["color"] | (const char *)nullptr, ev.color);
+}
+
+static void assignmentFields(JsonDocument &f) {
+  JsonObject data = f["data"].to<JsonObject>();
+  data["mode"] = true;
+  data["sourceId"] = true;
+  data["sourceName"] = true;
+  data["slot"] = true;
+  data["slotEpoch"] = true;
+}
+static void decodeAssignment(JsonObjectConst msg, NetEvent &ev) {
+  JsonObjectConst data = msg["data"];
+  const char *sourceId = data["sourceId"] | "";
+  copyField(ev.id, sourceId);
+  ev.sourceHash = tallyHashSource(sourceId); // ids longer than ev.id still match their tally packets
+  copyField(ev.name, data["sourceName"] | "");
+  ev.assigned = strcmp(data["mode"] | "", "assigned") == 0;
+  ev.slotValid = ev.assigned && !data["slot"].isNull();
+  ev.slot = data["slot"] | TALLY_NO_SLOT;
+  ev.slotEpoch = data["slotEpoch"] | 0;
+}
+
+static void syncDoneFields(JsonDocument &f) { f["pages"] = true; f["snap"] = true; }
+static void decodeSyncDone(JsonObjectConst msg, NetEvent &ev) {
+  ev.duration = msg["pages"] | 0UL;
+  ev.seq = msg["snap"] | 0UL;
+}
+
+// Indexed by HubMsgType
+static const HubMessageHandler kHubHandlers[HUB_MSG_COUNT] = {
+  { HUB_MSG_UNKNOWN,           NET_EV_REGISTERED,        nullptr,                nullptr },
+  { HUB_MSG_REGISTERED,        NET_EV_REGISTERED,        registeredFields,       decodeRegistered },
+  { HUB_MSG_DISCOVER_REPLY,    NET_EV_DISCOVER_REPLY,    discoverReplyFields,    decodeDiscoverReply },
+  { HUB_MSG_HEARTBEAT_ACK,     NET_EV_HEARTBEAT_ACK,     heartbeatAckFields,     decodeHeartbeatAck },
+  { HUB_MSG_REGISTER_REQUIRED, NET_EV_REGISTER_REQUIRED, registerRequiredFields, decodeRegisterRequired },
+  { HUB_MSG_TALLY,             NET_EV_TALLY,             tallyFields,            decodeTally },
+  { HUB_MSG_ADMIN_MESSAGE,     NET_EV_ADMIN_MESSAGE,     adminMessageFields,     decodeAdminMessage },
+  { HUB_MSG_ASSIGNMENT,        NET_EV_ASSIGNMENT,        assignmentFields,       decodeAssignment },
+  { HUB_MSG_SYNC_DONE,         NET_EV_SYNC_DONE,         syncDoneFields,         decodeSyncDone },
+};
+
+static JsonDocument gHubTypeFilter;
+static JsonDocument gHubFilters[HUB_MSG_COUNT];
+
+// Build the per-handler filters once, before the net task starts decoding
+static void buildHubFilters() {
+  gHubTypeFilter["type"] = true;
+  for (int i = 0; i < HUB_MSG_COUNT; i++) {
+    if (kHubHandlers[i].declareFields == nullptr) continue;
+    gHubFilters[i]["type"] = true;
+    kHubHandlers[i].declareFields(gHubFilters[i]);
   }
 }
 
-void ensureUDPConnection() {
-  // Check if UDP is still working by attempting to send a test packet
-  if (WiFi.status() == WL_CONNECTED) {
-    static unsigned long lastUDPTest = 0;
-    const unsigned long UDP_TEST_INTERVAL = 120000; // Test every 2 minutes
-    
-    if (millis() - lastUDPTest > UDP_TEST_INTERVAL) {
-      Serial.println("Testing UDP connection...");
-      
-      // Send a test heartbeat
-      JsonDocument doc;
-      doc["type"] = "ping";
-      doc["deviceId"] = device_id;
-      doc["timestamp"] = millis();
-      
-      String message;
-      serializeJson(doc, message);
-      
-      int result = udp.beginPacket(hub_ip.c_str(), hub_port);
-      if (result == 1) {
-        udp.print(message);
-        int endResult = udp.endPacket();
-        if (endResult == 1) {
-          Serial.println("UDP test successful");
-        } else {
-          Serial.println("UDP test failed on endPacket, restarting UDP...");
-          restartUDP();
-        }
+// JSON fallback for older hubs and all non-tally messages. Parsed with only the fields the matching
+// handler declared; when the pre-scan could not read "type", a "type"-only pass runs first.
+static bool decodeJsonMessage(const char *buffer, size_t len, HubMsgType type, NetEvent &ev) {
+  static JsonDocument doc(&gNetJsonArena); // net task only
+  if (type == HUB_MSG_UNKNOWN) {
+    doc.clear();
+    gNetJsonArena.reset();
+    DeserializationError error = deserializeJson(doc, buffer, len, DeserializationOption::Filter(gHubTypeFilter));
+    if (error) {
+      Serial.printf("JSON parsing failed: %s\n", error.c_str());
+      return false;
+    }
+    type = hubMessageType(doc["type"] | (const char *)nullptr);
+  }
+
+  const HubMessageHandler &handler = kHubHandlers[type];
+  if (type == HUB_MSG_UNKNOWN || handler.decode == nullptr) return false;
+
+  doc.clear();
+  gNetJsonArena.reset();
+  DeserializationError error = deserializeJson(doc, buffer, len, DeserializationOption::Filter(gHubFilters[type]));
+  if (error) {
+    Serial.printf("JSON parsing failed: %s\n", error.c_str());
+    return false;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.type = handler.event;
+  handler.decode(doc.as<JsonObjectConst>(), ev);
+  return true;
+}
+
+// Move the socket's multicast membership to group (0 = leave). IGMP reports go out from lwIP on join.
+static void netSetMulticastGroup(uint32_t group) {
+  struct ip_mreq mreq = {};
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (gMcastJoined != 0 && gMcastJoined != group) {
+    mreq.imr_multiaddr.s_addr = gMcastJoined;
+    setsockopt(gUdpSock, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
+    Serial.printf("Left multicast group %s\n", IPAddress(gMcastJoined).toString().c_str());
+    gMcastJoined = 0;
+  }
+  if (group != 0 && gMcastJoined != group) {
+    mreq.imr_multiaddr.s_addr = group;
+    if (setsockopt(gUdpSock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0) {
+      gMcastJoined = group;
+      Serial.printf("Joined multicast group %s\n", IPAddress(group).toString().c_str());
+    } else {
+      Serial.printf("Multicast join failed (%d), staying on unicast until the timeout\n", errno);
+    }
+  }
+  // Published even when the join failed: the silence then trips the unicast fallback in loop()
+  if (group != gMcastGroup.load()) gMcastLastRx.store(millis());
+  gMcastGroup.store(group);
+}
+
+// The one copy of each datagram: lwIP copies the payload straight from its pbuf into this buffer and every
+// decoder works on it in place. It holds TALLY_MAX_DATAGRAM plus one probe byte (and the NUL); lwIP
+// truncates silently, so a read that reaches the probe byte means the datagram was too long.
+static char gNetRxBuffer[TALLY_MAX_DATAGRAM + 2];
+
+// A deduplicated frame the hub is retransmitting (TALLY_CAP_TALLY_ACK) means our ack was lost. The loop never
+// sees it, so ack it from here with the version it carries, which is the one already applied.
+static void netAckDuplicate(const struct sockaddr_in &from, const uint8_t *buf, size_t len) {
+  if (!(gHubFeatures.load() & TALLY_CAP_TALLY_ACK) || len < TALLY_FRAME_HEADER_LEN || !tallyIsBinaryFrame(buf, len)) return;
+  bool snapshot = (buf[1] & 0x0F) == TALLY_KIND_SNAPSHOT;
+  if (!snapshot && tallyReadU64(buf + 8) != gAssignedHash.load()) return; // not our source: nothing pending
+  uint32_t seq = tallyReadU32(buf + 4);
+  if (seq == 0) return;
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"tally_ack\",\"%s\":%lu}", snapshot ? "snap" : "seq", (unsigned long)seq);
+  if (n > 0 && udpSendTo(IPAddress(from.sin_addr.s_addr), ntohs(from.sin_port), (const uint8_t *)out, n)) tallyAcksSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void netRxTask(void *param) {
+  for (;;) {
+    if (gNetReopenRequested || gUdpSock < 0) {
+      gNetReopenRequested = false;
+      if (openUdpSocket(gNetBindPort)) {
+        Serial.printf("UDP socket listening on port %u\n", (unsigned)gNetBindPort);
+        gMcastJoined = 0; // memberships belong to the old socket
+        netSetMulticastGroup(gMcastGroup.load());
       } else {
-        Serial.println("UDP test failed on beginPacket, restarting UDP...");
-        restartUDP();
+        Serial.println("Failed to open UDP socket, retrying...");
+        vTaskDelay(pdMS_TO_TICKS(500));
+        continue;
       }
-      
-      lastUDPTest = millis();
     }
+
+    struct sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(gUdpSock, gNetRxBuffer, TALLY_MAX_DATAGRAM + 1, 0, (struct sockaddr *)&from, &fromLen);
+    if (len < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) continue; // receive timeout, nothing pending
+      gNetStats.socketErrors++;
+      Serial.printf("UDP recv error %d, reopening socket\n", errno);
+      gNetReopenRequested = true;
+      vTaskDelay(pdMS_TO_TICKS(100));
+      continue;
+    }
+    gNetStats.received++;
+    if (len > TALLY_MAX_DATAGRAM) {
+      gNetStats.oversize++;
+      Serial.printf("Dropping oversize datagram (> %d bytes)\n", TALLY_MAX_DATAGRAM);
+      continue;
+    }
+    gNetRxBuffer[len] = '\0';
+    // Only liveness and registration matter from the standby hub; its tally and snapshots stop here
+    bool fromStandby = gStandbyHubAddr.load() != 0 && from.sin_addr.s_addr == gStandbyHubAddr.load() &&
+                       from.sin_port == gStandbyHubPort.load();
+    if (fromStandby && tallyIsBinaryFrame((const uint8_t *)gNetRxBuffer, len)) {
+      gNetStats.standbyDropped++;
+      continue;
+    }
+    if (tallyFrameIsMulticast((const uint8_t *)gNetRxBuffer, len)) {
+      gNetStats.mcastFrames++;
+      gMcastLastRx.store(millis());
+    }
+
+    NetEvent ev;
+    NetDecodeResult result = decodeHubMessage(gNetRxBuffer, len, ev);
+    if (result == NET_DECODE_DUPLICATE && !fromStandby) {
+      // Nothing to apply; only that the hub is alive (picked up by handleUDPMessages)
+      gNetDupRxAt.store(millis() | 1);
+      netAckDuplicate(from, (const uint8_t *)gNetRxBuffer, len);
+      xTaskNotifyGive(gLoopTaskHandle);
+      continue;
+    }
+    if (result != NET_DECODE_OK) {
+      if (result == NET_DECODE_ERROR) gNetStats.parseErrors++;
+      continue;
+    }
+    ev.receivedAt = millis();
+    if (fromStandby) {
+      if (ev.type != NET_EV_HEARTBEAT_ACK && ev.type != NET_EV_REGISTERED && ev.type != NET_EV_REGISTER_REQUIRED) {
+        gNetStats.standbyDropped++;
+        continue;
+      }
+      ev.fromStandby = true;
+    } else if (ev.type == NET_EV_ASSIGNMENT) {
+      // Published here rather than when loop() applies it, so tally updates right behind the assignment pass the filter
+      gAssignedSlotKey.store(ev.slotValid ? ((uint32_t)ev.slotEpoch << 16 | ev.slot) : NET_NO_SLOT_KEY);
+      gAssignedHash.store(ev.assigned ? ev.sourceHash : 0);
+    } else if (ev.type == NET_EV_REGISTERED) {
+      gNetDedup = {}; // possibly a restarted hub: let its first resend of everything through
+      if (ev.slotValid) gAssignedSlotKey.store((uint32_t)ev.slotEpoch << 16 | ev.slot);
+      gHubFeatures.store(ev.features);
+      netSetMulticastGroup(ev.mcastGroup); // every registration reply states the delivery mode
+    }
+    if (!netQueuePush(ev)) gNetStats.dropped++;
+    xTaskNotifyGive(gLoopTaskHandle);
   }
 }
 
-void connectToWiFi() {
-  if (!connectToSavedWiFi()) {
-    startConfigMode();
+void startNetRxTask() {
+  if (gNetRxTaskHandle != nullptr) return;
+  if (gUdpSockMutex == nullptr) gUdpSockMutex = xSemaphoreCreateMutex();
+  gLoopTaskHandle = xTaskGetCurrentTaskHandle();
+  gNetBindPort = hub_port + 1;
+  buildHubFilters();
+  // Bind now so the registration sent right after startup already has a socket; the task retries on failure
+  if (openUdpSocket(gNetBindPort)) Serial.printf("UDP socket listening on port %u\n", (unsigned)gNetBindPort);
+  xTaskCreatePinnedToCore(netRxTask, "netRx", NET_RX_TASK_STACK, nullptr,
+                          NET_RX_TASK_PRIORITY, &gNetRxTaskHandle, NET_RX_TASK_CORE);
+}
+
+bool udpSendTo(IPAddress ip, uint16_t port, const uint8_t *data, size_t len) {
+  struct sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  to.sin_addr.s_addr = (uint32_t)ip;
+  bool ok = false;
+  if (gUdpSockMutex != nullptr) {
+    xSemaphoreTake(gUdpSockMutex, portMAX_DELAY);
+    if (gUdpSock >= 0) {
+      ok = sendto(gUdpSock, data, len, 0, (struct sockaddr *)&to, sizeof(to)) == (int)len;
+    }
+    xSemaphoreGive(gUdpSockMutex);
+  }
+  if (!ok) gNetStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+  return ok;
+}
+
+bool sendToHub(const uint8_t *data, size_t len) {
+  IPAddress ip;
+  if (!ip.fromString(hub_ip)) {
+    if (hub_ip.length() == 0 || !WiFi.hostByName(hub_ip.c_str(), ip)) {
+      gNetStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
   }
+  return udpSendTo(ip, hub_port, data, len);
 }
 
-void checkWiFiConnection() {
-  if (WiFi.status() != WL_CONNECTED) {
-    isConnected = false;
-    isRegisteredWithHub = false;
-    Serial.println("WiFi disconnected, attempting reconnection...");
-    
-    // Try to reconnect to saved WiFi
-    if (connectToSavedWiFi()) {
-      isConnected = true;
-      lastHubResponse = millis(); // Reset hub response tracking
-      hubConnectionAttempts = 0;
-      // Restart web server after reconnection
-      server.stop();
-      setupWebServer();
-      server.begin();
-      Serial.println("Web server restarted after WiFi reconnection");
-      Serial.print("Access device at: http://");
-      Serial.println(WiFi.localIP());
-      if (auto_discovery_enabled) attemptHubDiscovery();
-      registerWithHub();
-    } else {
-      Serial.println("Reconnection failed, starting config mode");
-      startConfigMode();
-    }
-  } else if (!isConnected) {
-    isConnected = true;
-    lastHubResponse = millis(); // Reset hub response tracking
-    hubConnectionAttempts = 0;
-    // Start web server if not already started
-    setupWebServer();
-    server.begin();
-    Serial.println("Web server started after WiFi connection restored");
-    Serial.print("Access device at: http://");
-    Serial.println(WiFi.localIP());
-    if (auto_discovery_enabled) attemptHubDiscovery();
-    registerWithHub();
+bool sendToHub(const String &message) {
+  return sendToHub((const uint8_t *)message.c_str(), message.length());
+}
+
+bool sendToStandbyHub(const String &message) {
+  IPAddress ip;
+  if (!ip.fromString(standbyHub.ip)) return false;
+  return udpSendTo(ip, standbyHub.port, (const uint8_t *)message.c_str(), message.length());
+}
+
+void ensureUDPConnection() {
+  // No separate ping: heartbeats and acks already exercise the socket, so only reopen it when sends have
+  // failed since the last check
+  static uint32_t lastSendErrors = 0;
+  uint32_t sendErrors = gNetStats.sendErrors.load(std::memory_order_relaxed);
+  if (WiFi.status() == WL_CONNECTED && sendErrors != lastSendErrors) {
+    Serial.println("UDP sends failing, restarting UDP...");
+    restartUDP();
   }
+  lastSendErrors = sendErrors;
 }
 
-void registerWithHub() {
+// standby: register passively with the standby hub instead, quietly and for unicast delivery
+void registerWithHub(bool standby) {
   if (WiFi.status() != WL_CONNECTED) return;
   
-  Serial.println("Registering with Tally Hub...");
-  showStatus("Register", BLUE);
+  if (!standby) {
+    Serial.println("Registering with Tally Hub...");
+    showStatus("Register", BLUE);
+  }
   
   JsonDocument doc;
   doc["type"] = "register";
   doc["deviceId"] = device_id;
   doc["deviceName"] = device_name;
+  doc["proto"] = TALLY_PROTO_LEVEL; // hub may send binary tally frames and snapshots instead of JSON
+  doc["caps"] = TALLY_DEVICE_CAPS; // the hub answers with the subset it will use ("features")
+  doc["maxDatagram"] = TALLY_MAX_DATAGRAM;
+  doc["display"]["w"] = M5.Lcd.width();
+  doc["display"]["h"] = M5.Lcd.height();
+  doc["mcast"] = !standby && !multicastSuspended; // snapshots through the hub's multicast group, unless it went quiet on us
+  if (standby) doc["standby"] = true; // no tally or snapshots until we resume the session there
   
   // Include assignment information if device has an assignment
   if (isAssigned && assignedSource.length() > 0) {
     doc["assignedSource"] = assignedSource;
     doc["isAssigned"] = true;
-    Serial.println("Registration includes assignment: " + assignedSource);
+    if (!standby) Serial.println("Registration includes assignment: " + assignedSource);
   } else {
     doc["isAssigned"] = false;
   }
@@ -668,206 +1412,1003 @@ void registerWithHub() {
   String message;
   serializeJson(doc, message);
   
-  udp.beginPacket(hub_ip.c_str(), hub_port);
-  udp.print(message);
-  udp.endPacket();
+  if (standby) {
+    sendToStandbyHub(message);
+    return;
+  }
+  sendToHub(message);
   
   Serial.println("Registration sent to hub");
 }
 
-void sendHeartbeat() {
-  if (!isRegisteredWithHub) return;
-  
-  JsonDocument doc;
-  doc["type"] = "heartbeat";
-  doc["deviceId"] = device_id;
-  
-  String message;
-  serializeJson(doc, message);
-  
-  udp.beginPacket(hub_ip.c_str(), hub_port);
-  udp.print(message);
-  udp.endPacket();
-  
-  Serial.println("Heartbeat sent");
+// After a short outage, reconnect with the token from the last "registered" instead of a full register.
+// The hub answers "registered" with resumed set and sends no assignment unless it changed meanwhile, so
+// recovery takes one round trip. An unknown or expired token gets register_required instead.
+bool resumeHubSession() {
+  if (hubSession.length() == 0 || millis() - hubSessionSeenAt >= hubSessionTtl) return false;
+  if (WiFi.status() != WL_CONNECTED) return false;
+  JsonDocument doc;
+  doc["type"] = "resume";
+  doc["deviceId"] = device_id;
+  doc["session"] = hubSession;
+  doc["mcast"] = !multicastSuspended;
+  if (isAssigned && assignedSource.length() > 0) doc["assignedSource"] = assignedSource;
+
+  String message;
+  serializeJson(doc, message);
+  sendToHub(message);
+  Serial.println("Resuming hub session");
+  return true;
+}
+
+// The hub re-sends the multicast snapshot every 2 s; if none arrives (IGMP snooping, AP filtering, a failed
+// join) re-register without multicast so the hub goes back to unicast, and offer it again later.
+void checkMulticastDelivery() {
+  if (multicastSuspended) {
+    if (millis() - multicastSuspendedAt > NET_MCAST_RETRY_MS) {
+      multicastSuspended = false;
+      if (isRegisteredWithHub) registerWithHub();
+    }
+    return;
+  }
+  if (gMcastGroup.load() == 0) return;
+  uint32_t lastRx = gMcastLastRx.load(); // read before millis() so the difference cannot underflow
+  if ((uint32_t)millis() - lastRx > NET_MCAST_TIMEOUT_MS) {
+    Serial.println("No multicast tally received, falling back to unicast");
+    gNetStats.mcastFallbacks++;
+    multicastSuspended = true;
+    multicastSuspendedAt = millis();
+    registerWithHub();
+  }
+}
+
+// probeOnly: an on-air liveness probe or a retry, sent without the log line
+void sendHeartbeat(bool probeOnly) {
+  if (!isRegisteredWithHub) return;
+  
+  JsonDocument doc;
+  doc["type"] = "heartbeat";
+  doc["deviceId"] = device_id;
+  uint32_t t = millis() | 1; // echoed by the hub in heartbeat_ack; never 0, which means "none"
+  doc["t"] = t;
+  
+  String message;
+  serializeJson(doc, message);
+  
+  sendToHub(message);
+  gProbeOutstanding = t;
+  gProbeSentAt = millis();
+  gProbeRetried = false;
+  lastHeartbeat = gProbeSentAt;
+  
+  if (probeOnly) return;
+  heartbeatsSent++;
+  ensureUDPConnection();
+  Serial.printf("Heartbeat sent (interval=%lums rx=%lu drop=%lu parseErr=%lu qmax=%lu worst=%lums srtt=%lums rto=%lums)\n",
+                heartbeatIntervalMs, (unsigned long)gNetStats.received, (unsigned long)gNetStats.dropped,
+                (unsigned long)gNetStats.parseErrors, (unsigned long)gNetStats.queueHighWater,
+                gNetStats.maxApplyLatencyMs, (unsigned long)gHubRtt.srtt, (unsigned long)tallyRto(gHubRtt));
+}
+
+void checkHubLiveness() {
+  if (!isRegisteredWithHub) {
+    gProbeOutstanding = 0;
+    gProbeMisses = 0;
+    return;
+  }
+
+  unsigned long now = millis();
+  if (gProbeOutstanding != 0 && now - gProbeSentAt >= tallyRto(gHubRtt)) {
+    gNetStats.probeTimeouts++;
+    heartbeatIntervalMs = std::max(HEARTBEAT_MIN_MS, heartbeatIntervalMs / 2); // loss: check more often for a while
+    if (++gProbeMisses >= LIVENESS_MAX_MISSES) {
+      declareHubLost("heartbeats unacknowledged");
+      return;
+    }
+    sendHeartbeat(true); // retry straight away rather than waiting for the next interval
+    gProbeRetried = true;
+  } else if (gProbeOutstanding == 0) {
+    bool onAir = isProgram || isPreview;
+    if (now - lastHeartbeat >= heartbeatIntervalMs) {
+      sendHeartbeat();
+    } else if (onAir && now - lastHubResponse >= LIVENESS_ACTIVE_PROBE_MS && now - lastHeartbeat >= LIVENESS_ACTIVE_PROBE_MS) {
+      sendHeartbeat(true);
+    }
+  }
+
+  if (gProbeOutstanding != 0) {
+    loopWakeAt(gProbeSentAt + tallyRto(gHubRtt));
+  } else {
+    loopWakeAt(lastHeartbeat + heartbeatIntervalMs);
+    if (isProgram || isPreview) loopWakeAt(std::max(lastHubResponse, lastHeartbeat) + LIVENESS_ACTIVE_PROBE_MS);
+  }
+}
+
+// Piggyback a liveness probe on a message the device sends anyway. The hub answers any "t" with heartbeat_ack,
+// so the exchange stands in for this interval's heartbeat. Only hubs that negotiate features echo it.
+void attachLivenessProbe(JsonDocument &doc) {
+  if (!isRegisteredWithHub || gProbeOutstanding != 0 || gHubFeatures.load() == 0) return;
+  uint32_t t = millis() | 1;
+  doc["t"] = t;
+  gProbeOutstanding = t;
+  gProbeSentAt = millis();
+  gProbeRetried = false;
+  lastHeartbeat = gProbeSentAt;
+  heartbeatsPiggybacked++;
+}
+
+// Tell the hub which tally version is on screen so it stops retransmitting. Called for duplicates and stale
+// versions too: the retransmit that arrives after a lost ack is answered the same way, with no redraw.
+void sendTallyAck(bool snapshot, uint32_t seq) {
+  if (seq == 0 || !(gHubFeatures.load() & TALLY_CAP_TALLY_ACK)) return;
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"tally_ack\",\"%s\":%lu}", snapshot ? "snap" : "seq", (unsigned long)seq);
+  sendToHub((const uint8_t *)out, n);
+  tallyAcksSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Ask the hub to replay the current tally state after registering or resuming, so a device that comes back
+// mid-show lights up right away instead of showing IDLE until the next cut. The replay arrives as ordinary
+// tally/snapshot datagrams, applied in order before sync_done, so the first frame drawn after the overlay
+// is already the hub's state. Returns false when the hub did not negotiate TALLY_CAP_SYNC.
+bool requestTallySync(bool resumed) {
+  if (!(gHubFeatures.load() & TALLY_CAP_SYNC)) return false;
+  if (!syncPending) {
+    syncPending = true;
+    syncAfterResume = resumed;
+    syncAttempts = 0;
+    lastSyncMs = millis();
+    showingRegistrationStatus = true;
+    registrationStatusStart = millis();
+    registrationStatusMessage = "Connecting...";
+    registrationStatusColor = YELLOW;
+  }
+  char out[48];
+  int n = snprintf(out, sizeof(out), "{\"type\":\"sync\",\"scope\":\"%s\"}", SYNC_SCOPE);
+  sendToHub((const uint8_t *)out, n);
+  syncAttempts++;
+  syncRequestedAt = millis();
+  loopWakeAt(syncRequestedAt + tallyRto(gHubRtt));
+  return true;
+}
+
+void syncStep() {
+  if (!syncPending || millis() - syncRequestedAt < tallyRto(gHubRtt)) return;
+  if (!isRegisteredWithHub) {
+    syncPending = false; // registration is starting over and will ask again
+    return;
+  }
+  if (syncAttempts < SYNC_MAX_ATTEMPTS) {
+    Serial.println("Tally sync unanswered - asking again");
+    requestTallySync(syncAfterResume);
+    return;
+  }
+  Serial.println("Tally sync unanswered - showing the state received so far");
+  finishTallySync(false);
+}
+
+void finishTallySync(bool answered) {
+  if (!syncPending) return;
+  syncPending = false;
+  if (answered) {
+    lastSyncMs = millis() - lastSyncMs;
+    syncsCompleted++;
+  } else {
+    lastSyncMs = 0;
+  }
+  showingRegistrationStatus = true;
+  registrationStatusStart = syncAfterResume ? 0 : millis();
+  registrationStatusMessage = "Connected";
+  registrationStatusColor = GREEN;
+}
+
+void declareHubLost(const char *reason) {
+  Serial.printf("Hub lost: %s\n", reason);
+  if (standbyAlive()) {
+    switchToStandby(reason, false, 0); // tally carries on from the standby, no HUB LOST
+    return;
+  }
+  hubLinkLost = true;
+  isConnected = false;
+  isRegisteredWithHub = false;
+  currentSource = "";
+  // Force immediate display update to show HUB LOST
+  showStatus("HUB LOST", RED);
+}
+
+// ---------------------------------------------------------------
+// Standby hub
+// ---------------------------------------------------------------
+
+// Publish the standby endpoint to the net task, which filters its datagrams by source address
+void publishStandbyHub() {
+  IPAddress ip;
+  bool valid = standbyHub.ip.length() > 0 && ip.fromString(standbyHub.ip);
+  if (standbyHub.ip.length() > 0 && !valid) Serial.printf("Standby hub \"%s\" is not an IP address, ignoring it\n", standbyHub.ip.c_str());
+  gStandbyHubPort.store(valid ? htons((uint16_t)standbyHub.port) : 0);
+  gStandbyHubAddr.store(valid ? (uint32_t)ip : 0);
+}
+
+static bool standbyAlive() {
+  return standbyHub.ip.length() > 0 && standbyHub.registered && millis() - standbyHub.lastRx < STANDBY_ALIVE_MS;
+}
+
+// Make the standby the active hub. It already has us registered passively, so resuming that session starts
+// its tally (the resumed reply also asks for a sync) and the display carries on; only per-hub state (sequence
+// numbers, RTT, snapshot slot, negotiated features) is swapped or starts over. The hub we leave is registered
+// again as the passive standby, at once when oldRegistered (it still has us and just leads with a lower
+// epoch), otherwise after retryMs (0 = one backoff step).
+static void switchToStandby(const char *reason, bool oldRegistered, uint32_t retryMs) {
+  Serial.printf("Switching to standby hub %s:%d, epoch %lu (%s)\n", standbyHub.ip.c_str(), standbyHub.port,
+                (unsigned long)standbyHub.epoch, reason);
+  unsigned long now = millis();
+  std::swap(hub_ip, standbyHub.ip);
+  std::swap(hub_port, standbyHub.port);
+  std::swap(hubSession, standbyHub.session);
+  std::swap(hubEpoch, standbyHub.epoch);
+  standbyHub.slotKey = gAssignedSlotKey.exchange(standbyHub.slotKey);
+  standbyHub.features = gHubFeatures.exchange(standbyHub.features);
+  publishStandbyHub();
+  standbyHub.registered = false; // until it confirms the passive registration; until then it keeps sending tally
+  standbyHub.lastRx = oldRegistered ? lastHubResponse : 0;
+  standbyHub.attempts = 0;
+  if (retryMs > TALLY_RETRY_AFTER_MAX_MS) retryMs = TALLY_RETRY_AFTER_MAX_MS;
+  standbyHub.nextTxAt = now + (oldRegistered ? 0 : retryMs > 0 ? retryMs : tallyBackoffMs(0, gBackoffRng));
+
+  isRegisteredWithHub = true;
+  isConnected = true;
+  hubLinkLost = false;
+  hubConnectionAttempts = 0;
+  lastHubResponse = now;
+  hubSessionSeenAt = now;
+  gProbeOutstanding = 0;
+  gProbeMisses = 0;
+  gHubRtt = {};
+  lastTallySeq = 0;     // each hub numbers its own state versions
+  lastSnapshotSeq = 0;
+  gMcastGroup.store(0); // the standby registration asked for unicast
+  hubFailovers++;
+  connEnter(CONN_REGISTERED, 0);
+  if (!resumeHubSession()) registerWithHub(); // a refused resume gets register_required and the usual path
+  sendHeartbeat(true);  // first RTT sample from the new hub
+}
+
+// Messages from the standby hub only keep its registration and epoch current
+static void handleStandbyEvent(const NetEvent &ev) {
+  standbyHub.lastRx = millis();
+  switch (ev.type) {
+  case NET_EV_REGISTERED:
+    if (!standbyHub.registered) Serial.printf("Registered with standby hub %s:%d\n", standbyHub.ip.c_str(), standbyHub.port);
+    standbyHub.registered = true;
+    standbyHub.attempts = 0;
+    standbyHub.epoch = ev.epoch;
+    if (ev.id[0] != '\0') standbyHub.session = ev.id;
+    standbyHub.slotKey = ev.slotValid ? ((uint32_t)ev.slotEpoch << 16 | ev.slot) : NET_NO_SLOT_KEY;
+    standbyHub.features = ev.features;
+    standbyHub.nextTxAt = standbyHub.lastRx + STANDBY_HEARTBEAT_MS;
+    break;
+  case NET_EV_HEARTBEAT_ACK:
+    standbyHub.epoch = ev.epoch;
+    break;
+  case NET_EV_REGISTER_REQUIRED: {
+    // The standby restarted: register again when it says (its epoch may now be the higher one)
+    uint32_t wait = ev.duration > TALLY_RETRY_AFTER_MAX_MS ? TALLY_RETRY_AFTER_MAX_MS : ev.duration;
+    standbyHub.registered = false;
+    standbyHub.nextTxAt = standbyHub.lastRx + (wait > 0 ? wait : tallyBackoffMs(0, gBackoffRng));
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+// Once per loop() pass: heartbeat the standby every STANDBY_HEARTBEAT_MS while it has us registered,
+// (re)register it at the backoff pace otherwise, and hand over to it when it is alive and either the active
+// hub is unavailable or the standby leads with a higher epoch.
+void standbyStep() {
+  if (standbyHub.ip.length() == 0 || WiFi.status() != WL_CONNECTED) return;
+  unsigned long now = millis();
+  if (standbyHub.registered && now - standbyHub.lastRx >= STANDBY_ALIVE_MS) {
+    Serial.printf("Standby hub %s:%d stopped answering\n", standbyHub.ip.c_str(), standbyHub.port);
+    standbyHub.registered = false;
+    standbyHub.attempts = 0;
+  }
+  if (standbyAlive() && hub_ip.length() > 0 && (!isRegisteredWithHub || standbyHub.epoch > hubEpoch)) {
+    if (isRegisteredWithHub) {
+      switchToStandby("it leads with a higher epoch", true, 0);
+    } else {
+      switchToStandby("active hub unavailable", false, 0);
+    }
+    return;
+  }
+
+  if ((long)(now - standbyHub.nextTxAt) >= 0) {
+    if (standbyHub.registered) {
+      JsonDocument doc;
+      doc["type"] = "heartbeat";
+      doc["deviceId"] = device_id;
+      String message;
+      serializeJson(doc, message);
+      sendToStandbyHub(message);
+      standbyHub.nextTxAt = now + STANDBY_HEARTBEAT_MS;
+    } else {
+      registerWithHub(true);
+      standbyHub.nextTxAt = now + CONN_REGISTER_TIMEOUT_MS + tallyBackoffMs(standbyHub.attempts++, gBackoffRng);
+    }
+  }
+  loopWakeAt(standbyHub.nextTxAt);
+}
+
+// ---------------------------------------------------------------
+// Connection manager
+// ---------------------------------------------------------------
+
+static bool gWifiScanning = false;
+static int8_t gDirectedIndex = -1;               // savedNetworks entry the directed join is using
+static int8_t gJoinIndex = -1;                   // savedNetworks entry the current attempt is for (-1 = other)
+static bool gStaticLeaseActive = false;          // WiFi.config() holds a cached lease; undo before DHCP joins
+static unsigned long gLeaseJoinedAt = 0;         // join on a cached lease came up, waiting for the hub (0 = not)
+static bool gLeaseRenewing = false;              // DHCP took over from the cached lease, waiting for its address
+const unsigned long LEASE_VERIFY_MS = 5000;      // the hub must answer on a cached lease within this
+static volatile unsigned long gWifiAssocAt = 0;  // set from the WiFi event task
+static volatile unsigned long gWifiGotIpAt = 0;
+static bool gConnWiFiBackoff = false;            // CONN_BACKOFF is waiting for the next Wi-Fi round, not a hub retry
+static int8_t gJoinOrder[MAX_WIFI_NETWORKS + 1]; // savedNetworks indices to try, -1 = legacy wifi_ssid
+static uint8_t gJoinCount = 0;
+static uint8_t gJoinNext = 0;
+
+static void connBuildJoinOrder(int found);
+static void connTryNextNetwork();
+
+void connEnter(ConnState state, unsigned long timeoutMs) {
+  if (state != connState) {
+    Serial.printf("Connection: %s -> %s\n", CONN_STATE_NAMES[connState], CONN_STATE_NAMES[state]);
+  }
+  connState = state;
+  gConnWiFiBackoff = false;
+  connStateSince = millis();
+  connDeadline = connStateSince + timeoutMs;
+}
+
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+    gWifiAssocAt = millis();
+  } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    gWifiGotIpAt = millis();
+  }
+}
+
+static void connUseDhcp() {
+  if (!gStaticLeaseActive) return;
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0)); // back to DHCP
+  gStaticLeaseActive = false;
+}
+
+// Every join goes through here so each attempt is timed and counted
+static void connWiFiBegin(const String &ssid, const String &password, const WiFiFastJoin *fast, int index) {
+  bool useLease = false;
+#ifndef WIFI_NO_CACHED_LEASE
+  useLease = fast != nullptr && fast->ip != 0;
+#endif
+  if (useLease) {
+    WiFi.config(IPAddress(fast->ip), IPAddress(fast->gateway), IPAddress(fast->subnet), IPAddress(fast->dns));
+    gStaticLeaseActive = true;
+  } else {
+    connUseDhcp();
+  }
+  gLeaseJoinedAt = 0;
+  gLeaseRenewing = false;
+
+  lastJoin = {};
+  lastJoin.beganAt = millis();
+  lastJoin.directed = fast != nullptr;
+  lastJoin.cachedLease = useLease;
+  gWifiAssocAt = 0;
+  gWifiGotIpAt = 0;
+  gJoinIndex = index;
+  if (index >= 0) savedNetworks[index].joinAttempts++;
+  if (fast != nullptr) {
+    WiFi.begin(ssid.c_str(), password.c_str(), fast->channel, fast->bssid);
+  } else {
+    WiFi.begin(ssid.c_str(), password.c_str());
+  }
+}
+
+void connBegin() {
+  WiFi.onEvent(onWiFiEvent);
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false); // every rejoin goes through the connection manager
+  connStartWiFiJoin();
+}
+
+// Start joining: straight to the AP that worked last time if it is cached, otherwise scan
+void connStartWiFiJoin() {
+  gDirectedIndex = -1;
+  for (int i = 0; i < networkCount; i++) {
+    if (savedNetworks[i].isActive && savedNetworks[i].fastJoin.valid && savedNetworks[i].ssid == wifi_ssid) {
+      gDirectedIndex = i;
+      break;
+    }
+  }
+  if (gDirectedIndex < 0) {
+    connStartWiFiScan();
+    return;
+  }
+
+  WiFiNetwork &net = savedNetworks[gDirectedIndex];
+  Serial.printf("Directed join: %s on channel %u\n", net.ssid.c_str(), net.fastJoin.channel);
+  gWifiScanning = false;
+  gJoinCount = 0;
+  gJoinNext = 0;
+  connWiFiBegin(net.ssid, net.password, &net.fastJoin, gDirectedIndex);
+  connEnter(CONN_WIFI_JOINING, CONN_WIFI_DIRECT_TIMEOUT_MS);
+}
+
+// Hand over to another AP picked by roamStep(), as a directed join; if it does not associate the directed-join
+// fallback forgets the target and scans, like any other failed directed join
+void connRoamTo(int index, const WiFiFastJoin &target) {
+  WiFiNetwork &net = savedNetworks[index];
+  gWifiScanning = false;
+  gJoinCount = 0;
+  gJoinNext = 0;
+  gDirectedIndex = index;
+  net.fastJoin = target;
+  connWiFiBegin(net.ssid, net.password, &net.fastJoin, index);
+  connEnter(CONN_WIFI_JOINING, CONN_WIFI_DIRECT_TIMEOUT_MS);
+}
+
+// Start a scan round: an async scan decides which saved networks are in range
+void connStartWiFiScan() {
+  gDirectedIndex = -1;
+  gWifiScanning = WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING;
+  connEnter(CONN_WIFI_JOINING, CONN_WIFI_SCAN_TIMEOUT_MS);
+  if (!gWifiScanning) {
+    connBuildJoinOrder(WIFI_SCAN_FAILED);
+    connTryNextNetwork();
+  }
+}
+
+// Join one specific network (network selection); if it fails the normal scan rounds take over
+void connJoinNetwork(const String &ssid, const String &password) {
+  isConnected = false;
+  isRegisteredWithHub = false;
+  WiFi.disconnect();
+  connWiFiBegin(ssid, password, nullptr, -1);
+  gDirectedIndex = -1;
+  gWifiScanning = false;
+  gJoinCount = 0;
+  gJoinNext = 0;
+  connEnter(CONN_WIFI_JOINING, CONN_WIFI_JOIN_TIMEOUT_MS);
+}
+
+// Candidates for this round: active saved networks seen by the scan (all of them if the scan failed),
+// then the legacy single network if it is not already among them
+static void connBuildJoinOrder(int found) {
+  gJoinCount = 0;
+  gJoinNext = 0;
+  bool legacyListed = false;
+  for (int i = 0; i < networkCount; i++) {
+    if (!savedNetworks[i].isActive) continue;
+    bool visible = found < 0;
+    for (int j = 0; j < found && !visible; j++) {
+      visible = WiFi.SSID(j) == savedNetworks[i].ssid;
+    }
+    if (!visible) continue;
+    gJoinOrder[gJoinCount++] = i;
+    if (savedNetworks[i].ssid == wifi_ssid) legacyListed = true;
+  }
+  if (wifi_ssid.length() > 0 && !legacyListed) gJoinOrder[gJoinCount++] = -1;
+  if (found >= 0) WiFi.scanDelete();
+  Serial.printf("WiFi scan: %d networks, %u saved candidates\n", found, gJoinCount);
+}
+
+static void connTryNextNetwork() {
+  if (gJoinNext < gJoinCount) {
+    int8_t idx = gJoinOrder[gJoinNext++];
+    const String &ssid = idx < 0 ? wifi_ssid : savedNetworks[idx].ssid;
+    const String &password = idx < 0 ? wifi_password : savedNetworks[idx].password;
+    Serial.printf("Attempting to connect to: %s\n", ssid.c_str());
+    connWiFiBegin(ssid, password, nullptr, idx);
+    connEnter(CONN_WIFI_JOINING, CONN_WIFI_JOIN_TIMEOUT_MS);
+    return;
+  }
+
+  if (!wifiEverConnected) {
+    Serial.println("Could not connect to any known networks, starting config mode");
+    startConfigMode();
+    return;
+  }
+  Serial.println("WiFi reconnection failed, next round in 30s");
+  connEnter(CONN_BACKOFF, CONN_WIFI_RETRY_MS);
+  gConnWiFiBackoff = true;
+}
+
+// Cache where this join landed so the next one can be directed; written only when something changed
+static void saveFastJoin() {
+  for (int i = 0; i < networkCount; i++) {
+    if (savedNetworks[i].ssid != wifi_ssid) continue;
+    WiFiFastJoin fast = {};
+    fast.valid = 1;
+    fast.channel = (uint8_t)WiFi.channel();
+    const uint8_t *bssid = WiFi.BSSID();
+    if (bssid != nullptr) memcpy(fast.bssid, bssid, sizeof(fast.bssid));
+    fast.ip = (uint32_t)WiFi.localIP();
+    fast.gateway = (uint32_t)WiFi.gatewayIP();
+    fast.subnet = (uint32_t)WiFi.subnetMask();
+    fast.dns = (uint32_t)WiFi.dnsIP(0);
+    if (memcmp(&fast, &savedNetworks[i].fastJoin, sizeof(fast)) != 0) {
+      savedNetworks[i].fastJoin = fast;
+      preferences.putBytes(("wifi_fj_" + String(i)).c_str(), &fast, sizeof(fast));
+    }
+    if (preferences.getString("wifi_ssid", "") != wifi_ssid) preferences.putString("wifi_ssid", wifi_ssid);
+    return;
+  }
+}
+
+static void connOnWiFiUp() {
+  // Remember which network worked (the network memory may have picked one other than wifi_ssid)
+  wifi_ssid = WiFi.SSID();
+  wifi_password = WiFi.psk();
+  unsigned long assocAt = gWifiAssocAt != 0 ? gWifiAssocAt : millis();
+  unsigned long gotIpAt = gWifiGotIpAt != 0 ? gWifiGotIpAt : millis();
+  lastJoin.assocMs = assocAt - lastJoin.beganAt;
+  lastJoin.ipMs = gotIpAt > assocAt ? gotIpAt - assocAt : 0;
+  if (gJoinIndex >= 0 && savedNetworks[gJoinIndex].ssid == WiFi.SSID()) {
+    WiFiNetwork &net = savedNetworks[gJoinIndex];
+    uint16_t joinMs = (uint16_t)std::min(gotIpAt - lastJoin.beganAt, 60000UL);
+    net.joinMsAvg = net.joinSuccesses == 0 ? joinMs : (uint16_t)((3UL * net.joinMsAvg + joinMs) / 4);
+    net.joinSuccesses++;
+  }
+  Serial.printf("WiFi connected to %s, IP %s (%s join: assoc %lu ms, IP %lu ms%s)\n", wifi_ssid.c_str(),
+                WiFi.localIP().toString().c_str(), lastJoin.directed ? "directed" : "scanned",
+                lastJoin.assocMs, lastJoin.ipMs, lastJoin.cachedLease ? " cached lease" : "");
+  saveFastJoin();
+  if (lastJoin.cachedLease) gLeaseJoinedAt = millis() | 1;
+
+  isConnected = true;
+  lastHubResponse = millis(); // Reset hub response tracking
+  hubConnectionAttempts = 0;
+  resetHubDiscovery();
+
+  if (!wifiEverConnected) {
+    showStatus("WiFi OK", GREEN);
+    // Start mDNS responder so hub can find us if needed (optional hostname: tally-<id>)
+    if (!MDNS.begin(device_id.c_str())) {
+      Serial.println("mDNS start failed");
+    } else {
+      Serial.println("mDNS responder started");
+    }
+    setupWebServer();
+  } else {
+    server.stop();
+  }
+  server.begin();
+  Serial.print("Access device at: http://");
+  Serial.println(WiFi.localIP());
+  wifiEverConnected = true;
+
+  // (Re)bind the UDP socket (hub_port + 1) so discovery replies and hub messages come back to us
+  restartUDP();
+
+  if (auto_discovery_enabled && hub_ip.length() == 0) {
+    Serial.println("Hub IP not configured, starting auto-discovery...");
+    attemptHubDiscovery();
+    connEnter(CONN_DISCOVERING, DISCOVERY_INTERVAL_MS);
+  } else {
+    connStartRegistering();
+    // Straight to the cached hub; one probe alongside checks it is still the one to use
+    if (auto_discovery_enabled && !hubCacheFresh()) attemptHubDiscovery();
+  }
+}
+
+// One hub attempt: a discovery probe first when enabled (it finds a hub that moved), then register
+static void connStartHubAttempt() {
+  hubConnectionAttempts++;
+  Serial.printf("Attempting hub connection/reconnection (attempt %lu)\n", hubConnectionAttempts);
+
+  showingRegistrationStatus = true;
+  registrationStatusStart = millis();
+  registrationStatusMessage = "Connecting...";
+  registrationStatusColor = YELLOW;
+
+  // A recently confirmed hub is retried directly a couple of times before probing for one that moved
+  if (auto_discovery_enabled && (!hubCacheFresh() || hubConnectionAttempts > 2)) attemptHubDiscovery();
+  if (hub_ip.length() == 0) {
+    connEnter(CONN_DISCOVERING, DISCOVERY_INTERVAL_MS);
+  } else {
+    connStartRegistering();
+  }
+}
+
+void connStartRegistering() {
+  if (!resumeHubSession()) registerWithHub();
+  // Don't reset lastHubResponse here - only reset when we get an actual response
+  connEnter(CONN_REGISTERING, CONN_REGISTER_TIMEOUT_MS);
+}
+
+// Registration went unanswered: wait a jittered, exponentially growing time (tallyBackoffMs) before the next
+// attempt, so devices that lost the hub together do not all come back in the same instant
+static void connHubBackoff() {
+  uint32_t wait = tallyBackoffMs(hubConnectionAttempts, gBackoffRng);
+  Serial.printf("Hub retry in %lu ms\n", (unsigned long)wait);
+  if (hubConnectionAttempts >= MAX_HUB_RECONNECT_ATTEMPTS) {
+    showingRegistrationStatus = true;
+    registrationStatusStart = millis();
+    registrationStatusMessage = "Hub Lost";
+    registrationStatusColor = RED;
+    // Fresh discovery budget every few attempts (about every 5 minutes at the cap): the hub may have moved
+    if (hubConnectionAttempts % MAX_HUB_RECONNECT_ATTEMPTS == 0) resetHubDiscovery();
+  }
+  connEnter(CONN_BACKOFF, wait);
+}
+
+// register_required: the hub has forgotten us (it restarted, or pruned us as stale). Honour its retryAfter,
+// plus up to a quarter of it again as jitter, then register; a hub that sends none gets a first backoff step.
+static void connDeferRegistration(uint32_t retryAfterMs) {
+  isRegisteredWithHub = false;
+  if (retryAfterMs > TALLY_RETRY_AFTER_MAX_MS) retryAfterMs = TALLY_RETRY_AFTER_MAX_MS;
+  uint32_t wait = retryAfterMs > 0 ? retryAfterMs + tallyBackoffNext(gBackoffRng) % (retryAfterMs / 4 + 1)
+                                   : tallyBackoffMs(0, gBackoffRng);
+  Serial.printf("Re-registering in %lu ms\n", (unsigned long)wait);
+  connEnter(CONN_BACKOFF, wait);
+}
+
+// A cached lease installed as static config is never renewed and may not fit the network any more (a new
+// subnet, gateway or DHCP pool). Once a join on one is up, the hub has LEASE_VERIFY_MS to answer; then DHCP
+// takes the address over and renews it from there, normally handing the same address back. A lease the hub
+// did not answer on is forgotten, so the next join waits for DHCP instead. The address DHCP settles on is
+// cached for the next join.
+static void connLeaseStep(unsigned long now) {
+  if (gLeaseRenewing) {
+    if (gWifiGotIpAt == 0) return;
+    gLeaseRenewing = false;
+    Serial.printf("DHCP took over the cached lease: IP %s\n", WiFi.localIP().toString().c_str());
+    saveFastJoin();
+    return;
+  }
+  if (gLeaseJoinedAt == 0) return;
+  bool answered = hubConfirmedAt != 0 && (long)(hubConfirmedAt - gLeaseJoinedAt) >= 0;
+  if (!answered && now - gLeaseJoinedAt < LEASE_VERIFY_MS) {
+    loopWakeAt(gLeaseJoinedAt + LEASE_VERIFY_MS);
+    return;
+  }
+  if (!answered && gJoinIndex >= 0) {
+    Serial.println("No hub answer on the cached lease, dropping it");
+    WiFiNetwork &net = savedNetworks[gJoinIndex];
+    net.fastJoin.ip = 0;
+    preferences.putBytes(("wifi_fj_" + String(gJoinIndex)).c_str(), &net.fastJoin, sizeof(WiFiFastJoin));
+  }
+  gLeaseJoinedAt = 0;
+  gWifiGotIpAt = 0;
+  gLeaseRenewing = true;
+  connUseDhcp();
+}
+
+void connStep() {
+  unsigned long now = millis();
+  bool wifiUp = WiFi.status() == WL_CONNECTED;
+  if (wifiUp) connLeaseStep(now);
+
+  if (!wifiUp && connState != CONN_WIFI_JOINING && !gConnWiFiBackoff) {
+    Serial.println("WiFi lost - marking as disconnected");
+    isConnected = false;
+    isRegisteredWithHub = false;
+    connStartWiFiJoin();
+    return;
+  }
+
+  switch (connState) {
+  case CONN_WIFI_JOINING:
+    if (wifiUp) {
+      gWifiScanning = false;
+      WiFi.scanDelete();
+      connOnWiFiUp();
+    } else if (gWifiScanning) {
+      int found = WiFi.scanComplete();
+      if (found == WIFI_SCAN_RUNNING && (long)(now - connDeadline) < 0) break;
+      gWifiScanning = false;
+      connBuildJoinOrder(found);
+      connTryNextNetwork();
+    } else if ((long)(now - connDeadline) >= 0) {
+      if (gDirectedIndex >= 0) {
+        // The AP moved, changed channel or is gone: forget it and find the network by scanning
+        Serial.printf("Directed join to %s failed, scanning\n", savedNetworks[gDirectedIndex].ssid.c_str());
+        savedNetworks[gDirectedIndex].fastJoin.valid = 0;
+        preferences.putBytes(("wifi_fj_" + String(gDirectedIndex)).c_str(), &savedNetworks[gDirectedIndex].fastJoin, sizeof(WiFiFastJoin));
+        connStartWiFiScan();
+      } else if (gJoinCount == 0) {
+        connStartWiFiScan(); // the network selection join failed
+      } else {
+        connTryNextNetwork();
+      }
+    }
+    break;
+
+  case CONN_DISCOVERING:
+    if (hub_ip.length() > 0) {
+      connStartRegistering();
+    } else if ((long)(now - connDeadline) >= 0) {
+      // The probe budget is per Wi-Fi session (the last probe also tries mDNS); once spent, back off
+      bool sent = attemptHubDiscovery();
+      if (hub_ip.length() > 0) {
+        connStartRegistering();
+      } else if (sent || gDiscoveryWindowOpen) {
+        connEnter(CONN_DISCOVERING, DISCOVERY_INTERVAL_MS);
+      } else {
+        connHubBackoff();
+      }
+    }
+    break;
+
+  case CONN_REGISTERING:
+    if (isRegisteredWithHub) {
+      connEnter(CONN_REGISTERED, 0);
+    } else if ((long)(now - connDeadline) >= 0) {
+      connHubBackoff();
+    }
+    break;
+
+  case CONN_REGISTERED:
+    if (!isRegisteredWithHub) {
+      // Liveness declared the hub lost. Every device sees a hub restart at about the same moment, so even
+      // the first attempt waits a jittered step.
+      Serial.println("Hub connection lost - will trigger reconnection attempts");
+      connHubBackoff();
+    }
+    break;
+
+  case CONN_BACKOFF:
+    if (isRegisteredWithHub) {
+      connEnter(CONN_REGISTERED, 0); // a late "registered" or a button re-register got through
+    } else if ((long)(now - connDeadline) >= 0) {
+      if (!wifiUp) {
+        connStartWiFiJoin();
+      } else {
+        connStartHubAttempt();
+      }
+    }
+    break;
+  }
+}
+
+// ---------------------------------------------------------------
+// Roaming
+// ---------------------------------------------------------------
+// While registered, the link RSSI is smoothed every ROAM_SAMPLE_MS. Once it sinks below ROAM_RSSI_THRESHOLD a
+// background async scan (at most one per ROAM_SCAN_MIN_INTERVAL_MS) ranks every AP of every saved network - other
+// APs of the current SSID included - by RSSI minus a penalty for that network's failed and slow joins. If the
+// best beats the current AP by ROAM_HYSTERESIS_DB the device hands over with a directed join. While this light
+// is on air it only roams below ROAM_RSSI_CRITICAL, since a handover costs a few hundred ms of link.
+#define ROAM_RSSI_THRESHOLD -72
+#define ROAM_RSSI_CRITICAL -82
+#define ROAM_HYSTERESIS_DB 8
+const unsigned long ROAM_SAMPLE_MS = 2000;
+const unsigned long ROAM_SCAN_MIN_INTERVAL_MS = 60000;
+const unsigned long ROAM_SCAN_TIMEOUT_MS = 8000;
+static int gRoamRssiAvg = 0;           // smoothed link RSSI, 0 = no sample yet
+static unsigned long gRoamLastSample = 0;
+static unsigned long gRoamLastScan = 0;
+static bool gRoamScanning = false;
+uint32_t roamScans = 0;
+uint32_t roamHandovers = 0;
+
+// dB taken off a candidate's RSSI: up to 20 for a network that keeps failing to join, 1 per 250 ms of join time
+static int roamPenalty(const WiFiNetwork &net) {
+  int penalty = net.joinMsAvg / 250;
+  if (net.joinAttempts > 0) penalty += 20 * (net.joinAttempts - net.joinSuccesses) / net.joinAttempts;
+  return penalty;
 }
 
-void checkHubConnection() {
-  // Only check if we're connected to WiFi
-  if (WiFi.status() != WL_CONNECTED) {
-    if (isConnected || isRegisteredWithHub) {
-      Serial.println("WiFi lost - marking as disconnected");
-      isConnected = false;
-      isRegisteredWithHub = false;
+static void roamPickAndSwitch(int found) {
+  if (found < 0) return;
+  uint8_t current[6] = {};
+  const uint8_t *bssid = WiFi.BSSID();
+  if (bssid != nullptr) memcpy(current, bssid, sizeof(current));
+
+  int bestScan = -1;
+  int bestNet = -1;
+  int bestScore = gRoamRssiAvg + ROAM_HYSTERESIS_DB - 1; // must beat the current AP by the hysteresis
+  for (int j = 0; j < found; j++) {
+    const uint8_t *candidate = WiFi.BSSID(j);
+    if (candidate == nullptr || memcmp(candidate, current, sizeof(current)) == 0) continue;
+    for (int i = 0; i < networkCount; i++) {
+      if (!savedNetworks[i].isActive || WiFi.SSID(j) != savedNetworks[i].ssid) continue;
+      int score = WiFi.RSSI(j) - roamPenalty(savedNetworks[i]);
+      if (score > bestScore) {
+        bestScore = score;
+        bestScan = j;
+        bestNet = i;
+      }
+      break;
     }
+  }
+
+  if (bestScan < 0) {
+    Serial.printf("Roaming: no AP better than %d dBm\n", gRoamRssiAvg);
+    WiFi.scanDelete();
     return;
   }
-  
-  // If we're not registered with hub, try to connect/reconnect
-  if (!isRegisteredWithHub) {
-    // Don't attempt reconnection too frequently
-    unsigned long timeSinceLastAttempt = millis() - lastReconnectionAttempt;
-    if (timeSinceLastAttempt < MIN_RECONNECTION_INTERVAL) {
-      return; // Not enough time passed, skip this attempt
-    }
-    
-    // Don't attempt reconnection too frequently or indefinitely
-    if (hubConnectionAttempts < MAX_HUB_RECONNECT_ATTEMPTS) {
-      hubConnectionAttempts++;
-      lastReconnectionAttempt = millis();
-      Serial.printf("Attempting hub connection/reconnection (attempt %lu/%lu)\n", hubConnectionAttempts, MAX_HUB_RECONNECT_ATTEMPTS);
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Connecting...";
-      registrationStatusColor = YELLOW;
-      
-      // Attempt to register with the hub
-      delay(1000); // Brief delay before attempting connection
-      if (auto_discovery_enabled) attemptHubDiscovery();
-      registerWithHub();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
-    } else {
-      Serial.println("Max quick reconnection attempts reached, switching to slow retry mode");
-      
-      // Reset attempt counter every 5 minutes to keep trying
-      static unsigned long lastAttemptReset = 0;
-      if (millis() - lastAttemptReset > 300000) { // 5 minutes
-        Serial.println("Resetting reconnection attempts - continuing to try...");
-        hubConnectionAttempts = 0;
-        lastAttemptReset = millis();
-        return; // Let the next call handle the reconnection
-      }
-      
-      lastReconnectionAttempt = millis();
-      
-      showingRegistrationStatus = true;
-      registrationStatusStart = millis();
-      registrationStatusMessage = "Hub Lost";
-      registrationStatusColor = RED;
-      
-      isConnected = false;
-      isRegisteredWithHub = false;
-      
-      // Continue trying with longer delays
-      delay(10000); // Wait 10 seconds before next attempt
-      Serial.println("Attempting slow reconnection...");
-      if (auto_discovery_enabled) attemptHubDiscovery();
-      registerWithHub();
-      // Don't reset lastHubResponse here - only reset when we get an actual response
-    }
+
+  WiFiFastJoin target = {};
+  target.valid = 1;
+  target.channel = (uint8_t)WiFi.channel(bestScan);
+  memcpy(target.bssid, WiFi.BSSID(bestScan), sizeof(target.bssid));
+  const WiFiNetwork &net = savedNetworks[bestNet];
+  if (net.ssid == WiFi.SSID()) {
+    // Same SSID, normally the same DHCP server: keep the address, so sockets and the hub's view of us survive.
+    // It is only a bridge: connLeaseStep() hands it to DHCP, or drops it if the hub is not reachable there.
+    target.ip = (uint32_t)WiFi.localIP();
+    target.gateway = (uint32_t)WiFi.gatewayIP();
+    target.subnet = (uint32_t)WiFi.subnetMask();
+    target.dns = (uint32_t)WiFi.dnsIP(0);
+  } else if (net.fastJoin.valid) {
+    target.ip = net.fastJoin.ip;
+    target.gateway = net.fastJoin.gateway;
+    target.subnet = net.fastJoin.subnet;
+    target.dns = net.fastJoin.dns;
+  }
+  Serial.printf("Roaming: %d dBm -> %s %s ch %u (%ld dBm, score %d)\n", gRoamRssiAvg, net.ssid.c_str(),
+                WiFi.BSSIDstr(bestScan).c_str(), target.channel, (long)WiFi.RSSI(bestScan), bestScore);
+  WiFi.scanDelete();
+  roamHandovers++;
+  gRoamRssiAvg = 0;
+  connRoamTo(bestNet, target);
+}
+
+void roamStep() {
+  if (connState != CONN_REGISTERED || WiFi.status() != WL_CONNECTED) {
+    // The connection manager owns any scan from here on (it deletes the results itself)
+    gRoamScanning = false;
+    gRoamRssiAvg = 0;
     return;
   }
-  
-  // If we're registered, check for timeout
-  unsigned long timeSinceLastResponse = millis() - lastHubResponse;
-  if (timeSinceLastResponse > HUB_TIMEOUT) {
-    // Don't attempt reconnection too frequently
-    unsigned long timeSinceLastAttempt = millis() - lastReconnectionAttempt;
-    if (timeSinceLastAttempt < MIN_RECONNECTION_INTERVAL) {
-      return; // Not enough time passed, skip this attempt
+
+  unsigned long now = millis();
+  if (gRoamScanning) {
+    int found = WiFi.scanComplete();
+    if (found == WIFI_SCAN_RUNNING && now - gRoamLastScan < ROAM_SCAN_TIMEOUT_MS) return;
+    gRoamScanning = false;
+    roamPickAndSwitch(found);
+    return;
+  }
+
+  if (now - gRoamLastSample >= ROAM_SAMPLE_MS) {
+    gRoamLastSample = now;
+    int rssi = WiFi.RSSI();
+    gRoamRssiAvg = gRoamRssiAvg == 0 ? rssi : (3 * gRoamRssiAvg + rssi) / 4;
+
+    int threshold = (isProgram || isPreview) ? ROAM_RSSI_CRITICAL : ROAM_RSSI_THRESHOLD;
+    bool scanAllowed = gRoamLastScan == 0 || now - gRoamLastScan >= ROAM_SCAN_MIN_INTERVAL_MS;
+    if (gRoamRssiAvg < threshold && scanAllowed) {
+      Serial.printf("Roaming: link at %d dBm, scanning in the background\n", gRoamRssiAvg);
+      gRoamLastScan = now;
+      roamScans++;
+      gRoamScanning = WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING;
     }
-    
-    Serial.printf("Hub connection timeout (%lu ms since last response)\n", timeSinceLastResponse);
-    
-    // Immediately mark as not registered to trigger reconnection logic
-    isRegisteredWithHub = false;
-    isConnected = false;
-    
-    Serial.println("Hub timeout detected - will trigger reconnection attempts");
-    // The reconnection will be handled in the next call to checkHubConnection()
   }
+  loopWakeAt(gRoamLastSample + ROAM_SAMPLE_MS);
 }
 
 void handleUDPMessages() {
-  int packetSize = udp.parsePacket();
-  if (packetSize) {
-    char buffer[512];
-    int len = udp.read(buffer, sizeof(buffer) - 1);
-    buffer[len] = '\0';
-    
-    Serial.printf("Received UDP message: %s\n", buffer);
-    
+  // Deduplicated tally never reaches the queue, but it is still hub traffic
+  uint32_t dupAt = gNetDupRxAt.exchange(0);
+  if (dupAt != 0 && (long)(dupAt - lastHubResponse) > 0) {
+    lastHubResponse = dupAt;
+    hubSessionSeenAt = dupAt;
+    gProbeMisses = 0;
+    hubLinkLost = false;
+  }
+
+  // Drain everything the net task has decoded since the last pass
+  NetEvent ev;
+  while (netQueuePop(ev)) {
+    unsigned long latency = millis() - ev.receivedAt;
+    if (latency > gNetStats.maxApplyLatencyMs) gNetStats.maxApplyLatencyMs = latency;
+
+    if (ev.fromStandby) {
+      handleStandbyEvent(ev);
+      continue;
+    }
+
     // Update last hub response time for any message from hub
     lastHubResponse = millis();
+    hubSessionSeenAt = lastHubResponse;
     hubConnectionAttempts = 0; // Reset connection attempts on successful response
-    
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, buffer);
-    
-    if (error) {
-      Serial.printf("JSON parsing failed: %s\n", error.c_str());
-      return;
-    }
-    
-    String messageType = doc["type"];
-    
-    if (messageType == "registered") {
-      Serial.println("Registration confirmed by hub");
+    gProbeMisses = 0;          // any hub traffic proves it is alive
+    hubLinkLost = false;
+
+    switch (ev.type) {
+    case NET_EV_REGISTERED:
       isRegisteredWithHub = true;
+      lastHeartbeat = ev.receivedAt; // the hub has just heard from us
+      hubEpoch = ev.epoch;
+      hubConfirmedAt = ev.receivedAt;
+      if (ev.resumed) {
+        // Same hub, same session: assignment, snapshot sequence and display carry on as they were
+        Serial.println("Hub session resumed");
+        sessionResumes++;
+        // Tally changes made while we were away are replayed; without sync the overlay just ends
+        if (!requestTallySync(true)) registrationStatusStart = 0;
+        break;
+      }
+      Serial.println("Registration confirmed by hub");
+      if (ev.id[0] != '\0') {
+        hubSession = ev.id;
+        hubSessionTtl = ev.duration;
+      }
+      if (bootToRegisteredMs == 0) bootToRegisteredMs = millis();
+      lastTallySeq = 0;    // the hub may have restarted and begun counting again,
+      lastSnapshotSeq = 0; // even for an assignment it does not resend
+      if (requestTallySync(false)) break; // "Connected" once the current state is in
       
       showingRegistrationStatus = true;
       registrationStatusStart = millis();
       registrationStatusMessage = "Connected";
       registrationStatusColor = GREEN;
-    }
-    else if (messageType == "discover_reply") {
-      // Hub responded to discovery request
-      if (!doc["hubIp"].isNull()) {
-        String newIp = doc["hubIp"].as<String>();
-        int newUdp = doc["udpPort"].isNull()? hub_port : doc["udpPort"].as<int>();
-        bool changed = (newIp != hub_ip) || (newUdp != hub_port);
-        if (changed) {
-          Serial.printf("Discovery: updating hub to %s:%d\n", newIp.c_str(), newUdp);
-          hub_ip = newIp; hub_port = newUdp; saveConfiguration();
-          restartUDP(); // ensure we listen on correct companion port (hub_port+1 still fine)
-          // Immediately try registration with new hub details
-          registerWithHub();
-        }
+      break;
+
+    case NET_EV_SYNC_DONE:
+      Serial.printf("Tally sync done: %lu page(s), snapshot seq %lu\n", (unsigned long)ev.duration, (unsigned long)ev.seq);
+      finishTallySync(true);
+      break;
+
+    case NET_EV_DISCOVER_REPLY: {
+      // A hub answered the probe: one candidate until the discovery window closes (discoveryStep)
+      IPAddress ip;
+      if (ip.fromString(ev.id)) {
+        uint32_t rtt = ev.echoT != 0 ? ev.receivedAt - ev.echoT : ev.receivedAt - gDiscoveryProbeAt;
+        addHubCandidate((uint32_t)ip, ev.port == 0 ? hub_port : ev.port, rtt);
       }
+      break;
     }
-    else if (messageType == "heartbeat_ack") {
-      Serial.println("Heartbeat acknowledged");
+
+    case NET_EV_HEARTBEAT_ACK:
+      // Acks from hubs that do not echo "t" still clear the probe, they just give no RTT sample
+      if (ev.echoT != 0) tallyRttSample(gHubRtt, ev.receivedAt - ev.echoT);
+      if (gProbeOutstanding != 0 && !gProbeRetried) heartbeatIntervalMs = std::min(HEARTBEAT_MAX_MS, heartbeatIntervalMs + HEARTBEAT_STEP_MS);
+      gProbeOutstanding = 0;
+      hubEpoch = ev.epoch;
+      hubConfirmedAt = ev.receivedAt;
       hubConnectionAttempts = 0; // Reset reconnection attempts on successful communication
-    }
-    else if (messageType == "register_required") {
+      break;
+
+    case NET_EV_REGISTER_REQUIRED:
       Serial.println("Hub requesting registration - re-registering...");
       
       showingRegistrationStatus = true;
       registrationStatusStart = millis();
       registrationStatusMessage = "Re-register";
       registrationStatusColor = YELLOW;
+      syncPending = false;
       
-      registerWithHub();
-    }
-    else if (messageType == "tally") {
-      handleTallyUpdate(doc["data"]);
-    }
-    else if (messageType == "admin_message") {
+      hubSession = ""; // the hub has forgotten the session too
+      if (standbyAlive()) {
+        // The active hub restarted: keep tally going from the standby and register with it again later
+        switchToStandby("active hub asked us to register again", false, ev.duration);
+        break;
+      }
+      connDeferRegistration(ev.duration);
+      break;
+
+    case NET_EV_TALLY:
+      handleTallyUpdate(ev);
+      break;
+
+    case NET_EV_SNAPSHOT:
+      handleTallySnapshot(ev);
+      break;
+
+    case NET_EV_ADMIN_MESSAGE:
       // Expected fields: text, color (optional #RRGGBB), duration (ms)
-      const char* txt = doc["text"] | "";
-      if (strlen(txt) > 0) {
-        gAdminMessage = String(txt);
-        gAdminMessageId = doc["id"].isNull() ? String("") : String((const char*)doc["id"].as<const char*>());
+      if (ev.name[0] != '\0') {
+        gAdminMessage = String(ev.name);
+        gAdminMessageId = String(ev.id);
         // Duration clamp: 1s..30s default 8s
-        unsigned long dur = doc["duration"].isNull() ? 8000UL : (unsigned long)doc["duration"].as<unsigned long>();
+        unsigned long dur = ev.duration == 0 ? 8000UL : (unsigned long)ev.duration;
         if (dur < 1000UL) dur = 1000UL; if (dur > 30000UL) dur = 30000UL;
         gAdminMessageExpire = millis() + dur;
-        // Parse color (#RRGGBB) -> RGB565 background
-        gAdminMessageColor = 0x001F; // default blue
-        if (!doc["color"].isNull()) {
-          String c = doc["color"].as<String>();
-          if (c.startsWith("#")) c.remove(0,1);
-          if (c.length() == 6) {
-            char rHex[3]={c[0],c[1],'\0'}; char gHex[3]={c[2],c[3],'\0'}; char bHex[3]={c[4],c[5],'\0'};
-            int r = strtol(rHex,nullptr,16); int g = strtol(gHex,nullptr,16); int b = strtol(bHex,nullptr,16);
-            // Convert 8-bit each to RGB565
-            uint16_t rr = (r & 0xF8) << 8;
-            uint16_t gg = (g & 0xFC) << 3;
-            uint16_t bb = (b >> 3);
-            gAdminMessageColor = rr | gg | bb;
-          }
-        }
+        // Background color already converted to RGB565 by the net task (default blue)
+        gAdminMessageColor = ev.hasColor ? ev.color : 0x001F;
         gAdminMessageActive = true;
         gBgColor = gAdminMessageColor; // remember overlay background for consistent partial redraws
         gAdminOverlayReset = true; // ensure overlay redraw logic re-wraps with potential different sizing
@@ -886,27 +2427,26 @@ void handleUDPMessages() {
           ack["timestamp"] = (uint32_t)millis();
           ack["textSnippet"] = snippet;
           if (gAdminMessageId.length() > 0) ack["id"] = gAdminMessageId;
-          char out[192]; size_t n = serializeJson(ack, out, sizeof(out));
-          udp.beginPacket(hub_ip.c_str(), hub_port);
-          udp.write((const uint8_t*)out, n);
-          udp.endPacket();
+          attachLivenessProbe(ack);
+          char out[224]; size_t n = serializeJson(ack, out, sizeof(out));
+          sendToHub((const uint8_t*)out, n);
         }
         // Don't trigger blue screen - messages only appear in status bar
         // showStatus("", gAdminMessageColor); // DISABLED: No more blue screen pop-ups
       }
-    }
-    else if (messageType == "assignment") {
-      JsonObject data = doc["data"];
-      String newAssignedSource = data["sourceId"];
-      String sourceName = data["sourceName"];
-      String mode = data["mode"];
+      break;
+
+    case NET_EV_ASSIGNMENT: {
+      String newAssignedSource = String(ev.id);
+      String sourceName = String(ev.name);
       
-      Serial.printf("Assignment update - Mode: %s, Source: %s\n", mode.c_str(), sourceName.c_str());
+      Serial.printf("Assignment update - Mode: %s, Source: %s\n", ev.assigned ? "assigned" : "unassigned", sourceName.c_str());
       
-      if (mode == "assigned") {
+      if (ev.assigned) {
         assignedSource = newAssignedSource;
         assignedSourceName = sourceName;
         isAssigned = true;
+        internAssignedSource(ev.sourceHash);
         
         // Only override custom display name if we don't have one set locally
         // This preserves user-set display names from the web portal
@@ -935,6 +2475,7 @@ void handleUDPMessages() {
         assignedSourceName = "";
         customDisplayName = ""; // Clear custom display name on unassignment
         isAssigned = false;
+        internAssignedSource();
         saveAssignment();
         
         showingAssignmentConfirmation = true;
@@ -949,46 +2490,48 @@ void handleUDPMessages() {
         isStreaming = false;
         currentSource = "";
       }
+      break;
+    }
     }
   }
 }
 
-void handleTallyUpdate(JsonObject data) {
-  String sourceId = data["id"];
-  String sourceName = data["name"];
-  bool program = data["program"];
-  bool preview = data["preview"];
-  
-  // Better handling of optional fields
-  bool recording = false;
-  bool streaming = false;
-  
-  // ArduinoJson 7+: containsKey deprecated; use isNull() pattern
-  if (!data["recording"].isNull()) {
-    recording = data["recording"].as<bool>();
-  }
-  if (!data["streaming"].isNull()) {
-    streaming = data["streaming"].as<bool>();
+// Drop tally state older than (or equal to) what is already shown; UDP may duplicate or reorder datagrams
+bool acceptTallySeq(uint32_t &lastSeq, uint32_t seq) {
+  uint32_t gap;
+  switch (tallyCheckSeq(lastSeq, seq, gap)) {
+  case TALLY_SEQ_DUPLICATE:
+    gNetStats.seqDuplicates++;
+    return false;
+  case TALLY_SEQ_STALE:
+    gNetStats.seqStale++;
+    Serial.printf("Dropping stale tally seq=%lu (applied %lu)\n", (unsigned long)seq, (unsigned long)lastSeq);
+    return false;
+  case TALLY_SEQ_RESYNC:
+    gNetStats.seqResyncs++;
+    break;
+  case TALLY_SEQ_APPLY:
+    gNetStats.seqGaps += gap;
+    break;
   }
+  if (seq != 0) lastSeq = seq;
+  gNetStats.tallyApplied++;
+  return true;
+}
+
+void handleTallyUpdate(const NetEvent &ev) {
+  bool program = ev.program;
+  bool preview = ev.preview;
+  bool recording = ev.recording;
+  bool streaming = ev.streaming;
   
-  // Debug print raw JSON data
-  Serial.print("Raw tally update received: ");
-  String jsonString;
-  serializeJson(data, jsonString);
-  Serial.println(jsonString);
+  Serial.printf("Tally update received: hash=%08lx seq=%lu name=%s P=%d PV=%d R=%d S=%d (queued %lu ms)\n",
+                (unsigned long)(ev.sourceHash & 0xFFFFFFFFUL), (unsigned long)ev.seq, ev.name,
+                program, preview, recording, streaming, millis() - ev.receivedAt);
   
   // Global live source capture: update on ANY Program=true (regardless of this device's assignment)
   if (program) {
-    String newLiveSource = cleanSourceName(sourceName);
-    if (newLiveSource.length() > 0) {
-      if (newLiveSource != currentLiveSource) {
-        currentLiveSource = newLiveSource;
-        saveConfiguration(); // Persist only when it changes to avoid flash wear
-        Serial.printf("📺 Live source (global) updated: %s\n", currentLiveSource.c_str());
-      }
-      // Refresh the timestamp on every program broadcast so UI stays fresh
-      lastLiveSourceUpdate = millis();
-    }
+    updateLiveSource(ev.name);
   }
   
   if (!isAssigned || assignedSource.length() == 0) {
@@ -996,14 +2539,76 @@ void handleTallyUpdate(JsonObject data) {
     return;
   }
   
-  if (sourceId != assignedSource) {
+  // Binary frames only carry the id hash, so match on the interned hash for both encodings
+  if (ev.sourceHash != assignedSourceHash) {
+    return;
+  }
+
+  if (!acceptTallySeq(lastTallySeq, ev.seq)) {
+    sendTallyAck(false, lastTallySeq);
     return;
   }
   
   Serial.printf("Tally update for assigned source: %s, Program: %s, Preview: %s, Recording: %s, Streaming: %s\n", 
-                sourceName.c_str(), program ? "YES" : "NO", preview ? "YES" : "NO", 
+                assignedDisplayName.c_str(), program ? "YES" : "NO", preview ? "YES" : "NO", 
                 recording ? "YES" : "NO", streaming ? "YES" : "NO");
   
+  applyAssignedTally(program, preview, recording, streaming);
+  sendTallyAck(false, lastTallySeq);
+}
+
+// Whole-switcher snapshot: the net task already picked out our slot's bits, so this is O(1) per frame
+void handleTallySnapshot(const NetEvent &ev) {
+  if (!acceptTallySeq(lastSnapshotSeq, ev.seq)) {
+    sendTallyAck(true, lastSnapshotSeq);
+    return;
+  }
+
+  // The hub only names a live source when a program bus (scene/input) is on air
+  updateLiveSource(ev.name);
+
+  if (!ev.slotValid || !isAssigned || assignedSource.length() == 0) return;
+
+  // Every snapshot carries every source; only a change to ours is a transition the hub waits on an ack for
+  bool changed = ev.program != isProgram || ev.preview != isPreview || ev.recording != isRecording || ev.streaming != isStreaming;
+  if (changed) {
+    Serial.printf("Snapshot seq=%lu for assigned source: P=%d PV=%d R=%d S=%d (queued %lu ms)\n",
+                  (unsigned long)ev.seq, ev.program, ev.preview, ev.recording, ev.streaming, millis() - ev.receivedAt);
+  }
+  applyAssignedTally(ev.program, ev.preview, ev.recording, ev.streaming);
+  if (changed) sendTallyAck(true, lastSnapshotSeq);
+}
+
+void updateLiveSource(const char *sourceName) {
+  // The same program name repeats on every broadcast; only clean (and allocate) when the raw name changes
+  static char lastRawName[sizeof(NetEvent::name)] = "";
+  if (sourceName[0] == '\0') return;
+  if (strcmp(sourceName, lastRawName) != 0) {
+    String newLiveSource = cleanSourceName(String(sourceName));
+    if (newLiveSource.length() == 0) return;
+    copyField(lastRawName, sourceName);
+    if (newLiveSource != currentLiveSource) {
+      currentLiveSource = newLiveSource;
+      saveConfiguration(); // Persist only when it changes to avoid flash wear
+      Serial.printf("📺 Live source (global) updated: %s\n", currentLiveSource.c_str());
+    }
+  }
+  // Refresh the timestamp on every program broadcast so UI stays fresh
+  lastLiveSourceUpdate = millis();
+}
+
+// Resolve the assignment to a hash and a display name once, so tally packets compare integers and copy nothing
+// sourceHash: the id's hash as the hub sent it, for ids too long to keep whole (see decodeAssignment)
+void internAssignedSource(uint64_t sourceHash) {
+  bool hasAssignment = isAssigned && assignedSource.length() > 0;
+  if (hasAssignment && sourceHash == 0) sourceHash = tallyHashSource(assignedSource.c_str());
+  assignedSourceHash = hasAssignment ? sourceHash : 0;
+  assignedDisplayName = hasAssignment ? cleanSourceName(assignedSourceName.length() > 0 ? assignedSourceName : assignedSource) : "";
+  gAssignedHash.store(assignedSourceHash);
+  lastTallySeq = 0; // versions are per source; start over with the new one
+}
+
+void applyAssignedTally(bool program, bool preview, bool recording, bool streaming) {
   // Track recording/streaming state changes for debugging
   bool recordingChanged = (isRecording != recording);
   bool streamingChanged = (isStreaming != streaming);
@@ -1012,7 +2617,7 @@ void handleTallyUpdate(JsonObject data) {
   isPreview = preview;
   isRecording = recording;
   isStreaming = streaming;
-  currentSource = cleanSourceName(sourceName);
+  if (currentSource != assignedDisplayName) currentSource = assignedDisplayName;
   lastTallyUpdate = millis();
   
   // Log state changes
@@ -1114,10 +2719,9 @@ void handleButtons() {
             ack["timestamp"] = (uint32_t)millis();
             ack["textSnippet"] = snippet;
             if (gAdminMessageId.length() > 0) ack["id"] = gAdminMessageId;
-            char out[192]; size_t n = serializeJson(ack, out, sizeof(out));
-            udp.beginPacket(hub_ip.c_str(), hub_port);
-            udp.write((const uint8_t*)out, n);
-            udp.endPacket();
+            attachLivenessProbe(ack);
+            char out[224]; size_t n = serializeJson(ack, out, sizeof(out));
+            sendToHub((const uint8_t*)out, n);
           }
         }
       }
@@ -1189,12 +2793,122 @@ void handleButtons() {
     if (now - btnBFirstPressTime > doublePressWindow) {
       btnBPressCount = 0;
       btnBFirstPressTime = 0;
+    } else {
+      loopWakeAt(btnBFirstPressTime + doublePressWindow + 1);
     }
   }
   
   } // End of processIndividualButtons if block
 }
 
+// ---- Off-screen frame ----
+
+void frameBegin() {
+  gFrame.setColorDepth(16);
+  if (gFrame.createSprite(M5.Lcd.width(), M5.Lcd.height()) == nullptr) {
+    Serial.println("Display: no RAM for the frame sprite, drawing to the panel directly");
+    return;
+  }
+  gFrameTileCols = (gFrame.width() + FRAME_TILE - 1) / FRAME_TILE;
+  gFrameTileRows = (gFrame.height() + FRAME_TILE - 1) / FRAME_TILE;
+  gFrameTileHash = (uint32_t*)calloc(gFrameTileCols * gFrameTileRows, sizeof(uint32_t));
+  if (gFrameTileHash == nullptr) {
+    gFrame.deleteSprite();
+    Serial.println("Display: no RAM for the tile table, drawing to the panel directly");
+    return;
+  }
+  gFrame.fillScreen(BLACK);
+  gDraw = &gFrame;
+  gFramePushAll = true;
+  Serial.printf("Display: %dx%d frame sprite, %dx%d tiles\n", gFrame.width(), gFrame.height(), gFrameTileCols, gFrameTileRows);
+}
+
+// Grow the dirty rectangle to cover x,y,w,h; flushFrame() only looks at tiles inside it.
+void frameDirty(int x, int y, int w, int h) {
+  if (w <= 0 || h <= 0) return;
+  if (gDirtyX1 <= gDirtyX0) {
+    gDirtyX0 = x; gDirtyY0 = y; gDirtyX1 = x + w; gDirtyY1 = y + h;
+    return;
+  }
+  if (x < gDirtyX0) gDirtyX0 = x;
+  if (y < gDirtyY0) gDirtyY0 = y;
+  if (x + w > gDirtyX1) gDirtyX1 = x + w;
+  if (y + h > gDirtyY1) gDirtyY1 = y + h;
+}
+
+// FNV-1a over the 16-bit pixels of one tile
+static uint32_t frameTileHash(const uint16_t *buf, int stride, int x, int y, int w, int h) {
+  uint32_t hash = 2166136261u;
+  for (int row = y; row < y + h; ++row) {
+    const uint16_t *px = buf + row * stride + x;
+    for (int i = 0; i < w; ++i) hash = (hash ^ px[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Copy one rectangle of the sprite to the panel (the clip rect limits pushSprite to it)
+static uint32_t framePushRect(int x, int y, int w, int h) {
+  M5.Lcd.setClipRect(x, y, w, h);
+  gFrame.pushSprite(0, 0);
+  gFrameStats.windows++;
+  return (uint32_t)w * h * 2;
+}
+
+void flushFrame() {
+  if (gDraw != &gFrame) return;
+  if (gFramePushAll) frameDirty(0, 0, gFrame.width(), gFrame.height());
+  if (gDirtyX1 <= gDirtyX0 || gDirtyY1 <= gDirtyY0) return;
+
+  const int screenW = gFrame.width(), screenH = gFrame.height();
+  const uint16_t *buf = (const uint16_t*)gFrame.getBuffer();
+  int c0 = max(0, gDirtyX0 / FRAME_TILE), c1 = min(gFrameTileCols, (gDirtyX1 + FRAME_TILE - 1) / FRAME_TILE);
+  int r0 = max(0, gDirtyY0 / FRAME_TILE), r1 = min(gFrameTileRows, (gDirtyY1 + FRAME_TILE - 1) / FRAME_TILE);
+  gDirtyX1 = gDirtyX0; // empty again
+
+  // A run of changed tiles in one tile row becomes one window; a lone run lined up with the
+  // previous row's lone run extends that window downwards (full-width repaints are one window)
+  uint32_t bytes = 0;
+  int openX = 0, openY = 0, openW = 0, openH = 0;
+  M5.Lcd.startWrite();
+  for (int r = r0; r < r1; ++r) {
+    int y = r * FRAME_TILE, h = min(FRAME_TILE, screenH - y);
+    int runX[8], runW[8], runs = 0; // runs past the 8th are merged into the last one
+    int c = c0;
+    while (c < c1) {
+      int x = c * FRAME_TILE, w = min(FRAME_TILE, screenW - x);
+      uint32_t &pushed = gFrameTileHash[r * gFrameTileCols + c];
+      uint32_t hash = frameTileHash(buf, screenW, x, y, w, h);
+      bool changed = gFramePushAll || hash != pushed;
+      pushed = hash;
+      ++c;
+      if (!changed) continue;
+      if (runs > 0 && runX[runs - 1] + runW[runs - 1] == x) { runW[runs - 1] += w; continue; }
+      if (runs == (int)(sizeof(runX) / sizeof(runX[0]))) { runW[runs - 1] = x + w - runX[runs - 1]; continue; }
+      runX[runs] = x; runW[runs] = w; ++runs;
+    }
+    if (runs == 1 && openH > 0 && runX[0] == openX && runW[0] == openW && openY + openH == y) {
+      openH += h;
+      continue;
+    }
+    if (openH > 0) { bytes += framePushRect(openX, openY, openW, openH); openH = 0; }
+    if (runs == 1) {
+      openX = runX[0]; openY = y; openW = runW[0]; openH = h;
+      continue;
+    }
+    for (int i = 0; i < runs; ++i) bytes += framePushRect(runX[i], y, runW[i], h);
+  }
+  if (openH > 0) bytes += framePushRect(openX, openY, openW, openH);
+  M5.Lcd.clearClipRect();
+  M5.Lcd.endWrite();
+
+  gFramePushAll = false;
+  gFrameStats.lastFlushBytes = bytes;
+  if (bytes > 0) {
+    gFrameStats.flushes++;
+    gFrameStats.bytesPushed += bytes;
+  }
+}
+
 void forceImmediateDisplay() {
   // Reset internal trackers used by updateDisplay so it treats next cycle as changed
   // These statics live inside updateDisplay; we emulate by using volatile flags via globals if needed.
@@ -1252,6 +2966,7 @@ void updateDisplay() {
     static String lastSrc = "";
     static int lastPct = -1; // coarse bucket
     static int lastWifiLevel = -1;
+    frameDirty(0, 0, gDraw->width(), gDraw->height());
   const unsigned long ICON_REFRESH_INTERVAL = 900;   // icons (battery/wifi) refresh interval
   bool needBar = false; // redraw top bar (state/source) when changed
     bool needIcons = false;
@@ -1276,10 +2991,10 @@ void updateDisplay() {
     static unsigned long lastScrollFrame = 0;
     if (firstDraw || gAdminOverlayReset) {
       // One-time full paint
-      M5.Lcd.fillScreen(gAdminMessageColor);
+      gDraw->fillScreen(gAdminMessageColor);
       needBar = true;
       // Draw wrapped message once
-      String raw = gAdminMessage; int screenW = M5.Lcd.width(); int screenH = M5.Lcd.height();
+      String raw = gAdminMessage; int screenW = gDraw->width(); int screenH = gDraw->height();
       int topOffset = 15; int bottomReserve = 10; int availH = screenH - topOffset - bottomReserve; // Reduced margins for more space
 
       // Special case: very short message (<=10 chars, no space) -> attempt ultra-large single-line full-screen display
@@ -1295,15 +3010,15 @@ void updateDisplay() {
         }
         // Draw without status bar for maximum area
         needBar = false; // skip top bar when ultra-large
-        M5.Lcd.fillScreen(gAdminMessageColor);
-        M5.Lcd.setTextSize(bestSize);
-        M5.Lcd.setTextColor(WHITE);
+        gDraw->fillScreen(gAdminMessageColor);
+        gDraw->setTextSize(bestSize);
+        gDraw->setTextColor(WHITE);
         int charH = 8*bestSize + 2; int textW = raw.length() * (6*bestSize);
         int x = (screenW - textW) / 2; if (x < 0) x = 0;
         int y = (screenH - charH) / 2; if (y < 0) y = 0;
-        M5.Lcd.setCursor(x,y); M5.Lcd.print(raw);
+        gDraw->setCursor(x,y); gDraw->print(raw);
         // Small dismiss hint at bottom
-        M5.Lcd.setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; M5.Lcd.setCursor((screenW-hw)/2, screenH-8); M5.Lcd.print(hint);
+        gDraw->setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; gDraw->setCursor((screenW-hw)/2, screenH-8); gDraw->print(hint);
         firstDraw = false; gAdminOverlayReset = false; needIcons = false; // no icons in giant mode
         return; // done
       }
@@ -1333,14 +3048,14 @@ void updateDisplay() {
       startY = topOffset + (availH - blockH)/2; if (startY<topOffset) startY=topOffset;
 #endif
       // Render initial (may be clipped if scrolling) 
-      M5.Lcd.setTextColor(WHITE); M5.Lcd.setTextSize(best.textSize);
+      gDraw->setTextColor(WHITE); gDraw->setTextSize(best.textSize);
       for(size_t i=0;i<best.lines.size();++i){ 
         int w = best.lines[i].length()*(6*best.textSize); int x=(screenW-w)/2; if (x<2) x=2; 
         int lineY = startY + i*charH - scrollOffset; 
         if (lineY + charH < topOffset || lineY > topOffset + availH) continue; // basic vertical clip
-        M5.Lcd.setCursor(x,lineY); M5.Lcd.print(best.lines[i]); 
+        gDraw->setCursor(x,lineY); gDraw->print(best.lines[i]); 
       }
-      M5.Lcd.setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; M5.Lcd.setCursor((screenW-hw)/2, screenH-8); M5.Lcd.print(hint); // Moved hint closer to bottom
+      gDraw->setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; gDraw->setCursor((screenW-hw)/2, screenH-8); gDraw->print(hint); // Moved hint closer to bottom
       firstDraw = false; gAdminOverlayReset = false; needIcons = true; // draw icons after
       // Store for incremental scroll refresh inside static captures
       // Reuse lastSrc etc; scrolling state static above.
@@ -1356,10 +3071,10 @@ void updateDisplay() {
           scrollOffset += (int)(step + 0.5f);
           if (scrollOffset > scrollMax) scrollOffset = scrollMax; // clamp (one pass)
           // Redraw scrolling region only (message body area)
-          int screenW = M5.Lcd.width(); int screenH = M5.Lcd.height();
+          int screenW = gDraw->width(); int screenH = gDraw->height();
           int topOffset = 15; int bottomReserve = 10; int availH = screenH - topOffset - bottomReserve; // Match updated margins
           // Clear body area
-          M5.Lcd.fillRect(0, topOffset, screenW, availH, gAdminMessageColor);
+          gDraw->fillRect(0, topOffset, screenW, availH, gAdminMessageColor);
           // Re-wrap text quickly (duplicate minimal logic) to repaint lines at new offset
           String raw = gAdminMessage; struct LineWrap { std::vector<String> lines; int textSize; int charH; int startY; int availH; } wrap;
           // Determine size again (use last chosen best.textSize via static capture not stored; recompute)
@@ -1372,35 +3087,35 @@ void updateDisplay() {
           }
           if (chosenSize==0){ chosenSize=1; lines={raw}; }
           int charH = 8*chosenSize+2; int blockH = lines.size()*charH; int startY = topOffset; // for scrolling we always start at top
-          M5.Lcd.setTextSize(chosenSize); M5.Lcd.setTextColor(WHITE);
-          for(size_t i=0;i<lines.size(); ++i){ int w=lines[i].length()*(6*chosenSize); int x=(screenW-w)/2; if (x<2) x=2; int lineY=startY + i*charH - scrollOffset; if (lineY + charH < topOffset || lineY > topOffset + availH) continue; M5.Lcd.setCursor(x,lineY); M5.Lcd.print(lines[i]); }
+          gDraw->setTextSize(chosenSize); gDraw->setTextColor(WHITE);
+          for(size_t i=0;i<lines.size(); ++i){ int w=lines[i].length()*(6*chosenSize); int x=(screenW-w)/2; if (x<2) x=2; int lineY=startY + i*charH - scrollOffset; if (lineY + charH < topOffset || lineY > topOffset + availH) continue; gDraw->setCursor(x,lineY); gDraw->print(lines[i]); }
           // Redraw hint (static) with updated position
-          M5.Lcd.setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; M5.Lcd.setCursor((screenW-hw)/2, screenH-8); M5.Lcd.print(hint);
+          gDraw->setTextSize(1); String hint="Btn A dismiss"; int hw=hint.length()*6; gDraw->setCursor((screenW-hw)/2, screenH-8); gDraw->print(hint);
         }
       }
 #endif
     }
     if (needBar) {
       // Monochrome HUD-style bar: black background, white text, left-aligned
-      M5.Lcd.fillRect(0,0,M5.Lcd.width(),16,BLACK);
-      M5.Lcd.setTextSize(1); M5.Lcd.setTextColor(WHITE); M5.Lcd.setCursor(2,4);
-      if (isProgram) M5.Lcd.print("PROGRAM"); else if (isPreview) M5.Lcd.print("PREVIEW"); else M5.Lcd.print("IDLE");
+      gDraw->fillRect(0,0,gDraw->width(),16,BLACK);
+      gDraw->setTextSize(1); gDraw->setTextColor(WHITE); gDraw->setCursor(2,4);
+      if (isProgram) gDraw->print("PROGRAM"); else if (isPreview) gDraw->print("PREVIEW"); else gDraw->print("IDLE");
       // Show current source trimmed on the right side without overlapping battery/percent
-      const int screenW = M5.Lcd.width();
+      const int screenW = gDraw->width();
       const int battW = 24; const int tipW = 3; const int battX = screenW - (battW + tipW + 2);
       int rightBoundary = battX; if (gBattPctLeftX >= 0 && gBattPctLeftX < battX) { rightBoundary = gBattPctLeftX - 2; if (rightBoundary < 0) rightBoundary = 0; }
       if (currentSource.length()>0) {
         String src=currentSource; int maxChars = (rightBoundary - 4) / 6; if (maxChars < 0) maxChars = 0;
         if ((int)src.length() > maxChars) { int keep = max(0, maxChars - 3); src = src.substring(0, keep) + "..."; }
-        int w=src.length()*6; int x = rightBoundary - w; if (x < 2) x = 2; M5.Lcd.setCursor(x,4); M5.Lcd.print(src);
+        int w=src.length()*6; int x = rightBoundary - w; if (x < 2) x = 2; gDraw->setCursor(x,4); gDraw->print(src);
       }
       needIcons = true; // bar overwrote icon area
       lastProg = isProgram; lastPrev = isPreview; lastSrc = currentSource;
     }
     if (needIcons) {
       // Clear icon zone to background color then redraw icons
-      int screenW = M5.Lcd.width();
-      M5.Lcd.fillRect(screenW-80,0,80,16,gAdminMessageColor);
+      int screenW = gDraw->width();
+      gDraw->fillRect(screenW-80,0,80,16,gAdminMessageColor);
       BatteryInfo b = readBattery(); drawBatteryIndicator(b); drawWiFiIndicator();
     }
     return;    
@@ -1410,7 +3125,7 @@ void updateDisplay() {
   if (showingRegistrationStatus) {
     unsigned long displayDuration = (registrationStatusMessage == "Re-register") ? 500 : 1000;
     
-    if (millis() - registrationStatusStart < displayDuration) {
+    if (syncPending || millis() - registrationStatusStart < displayDuration) { // held while the sync is out
       showStatus(registrationStatusMessage, registrationStatusColor);
       return;
     } else {
@@ -1451,27 +3166,28 @@ void updateDisplay() {
   // Handle assignment confirmation display
   if (showingAssignmentConfirmation) {
     if (millis() - assignmentConfirmationStart < 3000) {
+      frameDirty(0, 0, gDraw->width(), gDraw->height()); // repainted every pass; only the first one reaches the panel
       if (confirmationIsAssigned) {
-        M5.Lcd.fillScreen(BLUE);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.setCursor(10, 20);
-        M5.Lcd.print("ASSIGNED TO:");
-        M5.Lcd.setCursor(10, 40);
-        M5.Lcd.print(confirmationSourceName);
-        M5.Lcd.setCursor(10, 60);
-        M5.Lcd.print("ID: " + confirmationSourceId);
-        M5.Lcd.setCursor(10, 80);
-        M5.Lcd.print("SAVED TO MEMORY");
+        gDraw->fillScreen(BLUE);
+        gDraw->setTextColor(WHITE);
+        gDraw->setTextSize(1);
+        gDraw->setCursor(10, 20);
+        gDraw->print("ASSIGNED TO:");
+        gDraw->setCursor(10, 40);
+        gDraw->print(confirmationSourceName);
+        gDraw->setCursor(10, 60);
+        gDraw->print("ID: " + confirmationSourceId);
+        gDraw->setCursor(10, 80);
+        gDraw->print("SAVED TO MEMORY");
       } else {
-        M5.Lcd.fillScreen(RED);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.setCursor(30, 40);
-        M5.Lcd.print("UNASSIGNED");
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.setCursor(10, 80);
-        M5.Lcd.print("No source assigned");
+        gDraw->fillScreen(RED);
+        gDraw->setTextColor(WHITE);
+        gDraw->setTextSize(2);
+        gDraw->setCursor(30, 40);
+        gDraw->print("UNASSIGNED");
+        gDraw->setTextSize(1);
+        gDraw->setCursor(10, 80);
+        gDraw->print("No source assigned");
       }
       return;
     } else {
@@ -1501,7 +3217,7 @@ void updateDisplay() {
     } else if (!isRegisteredWithHub) {
       // Check if we've been trying to connect for a while
       unsigned long timeSinceLastResponse = millis() - lastHubResponse;
-      if ((timeSinceLastResponse > HUB_TIMEOUT && lastHubResponse > 0) || 
+      if (hubLinkLost || (timeSinceLastResponse > HUB_TIMEOUT && lastHubResponse > 0) || 
           (lastHubResponse == 0 && millis() > 30000)) { // Show HUB LOST after 30 seconds if never connected
         showStatus("HUB LOST", RED); // Clear indication that hub is unreachable
       } else {
@@ -1516,6 +3232,7 @@ void updateDisplay() {
     } else {
       showTallyState("IDLE", 0x7BEF);     // Grey color (RGB565)
     }
+    if (stateChanged) gFrameStats.lastChangeBytes = gFrameStats.lastFlushBytes;
     
     lastDisplayUpdate = millis();
     lastProgramState = isProgram;
@@ -1530,8 +3247,9 @@ void updateDisplay() {
 }
 
 void showStatus(String message, uint16_t color) {
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
   // Clear screen below permanent status bar
-  M5.Lcd.fillRect(0, 16, M5.Lcd.width(), M5.Lcd.height() - 16, color);
+  gDraw->fillRect(0, 16, gDraw->width(), gDraw->height() - 16, color);
   
   // Always draw permanent status bar at top
   drawPermanentStatusBar();
@@ -1560,36 +3278,38 @@ void showStatus(String message, uint16_t color) {
   
   // Show additional info for specific status messages
   if (message == "HUB LOST" || message == "Connecting..." || message == "UNASSIGNED" || message == "NO WIFI") {
-    M5.Lcd.setTextSize(1);
-    M5.Lcd.setTextColor(WHITE);
+    gDraw->setTextSize(1);
+    gDraw->setTextColor(WHITE);
     
     // For WiFi-related issues, show network info if available
     if ((message == "HUB LOST" || message == "Connecting..." || message == "UNASSIGNED") && WiFi.status() == WL_CONNECTED) {
       String ipText = "IP: " + WiFi.localIP().toString();
-      int yBase = M5.Lcd.height()/2 + 28; // Position below main text
+      int yBase = gDraw->height()/2 + 28; // Position below main text
       int textWidth = ipText.length() * 6;
-      int x = (M5.Lcd.width() - textWidth) / 2;
+      int x = (gDraw->width() - textWidth) / 2;
       if (x < 4) x = 4;
-      M5.Lcd.setCursor(x, yBase);
-      M5.Lcd.print(ipText);
+      gDraw->setCursor(x, yBase);
+      gDraw->print(ipText);
     }
     
     // For "NO WIFI", show helpful hint
     if (message == "NO WIFI") {
       String hintText = "Hold A for Config";
-      int yBase = M5.Lcd.height()/2 + 28;
+      int yBase = gDraw->height()/2 + 28;
       int textWidth = hintText.length() * 6;
-      int x = (M5.Lcd.width() - textWidth) / 2;
+      int x = (gDraw->width() - textWidth) / 2;
       if (x < 4) x = 4;
-      M5.Lcd.setCursor(x, yBase);
-      M5.Lcd.print(hintText);
+      gDraw->setCursor(x, yBase);
+      gDraw->print(hintText);
     }
   }
+  flushFrame();
 }
 
 void showTallyState(String state, uint16_t color) {
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
   // Clear screen below permanent status bar
-  M5.Lcd.fillRect(0, 16, M5.Lcd.width(), M5.Lcd.height() - 16, color);
+  gDraw->fillRect(0, 16, gDraw->width(), gDraw->height() - 16, color);
   
   // Always draw permanent status bar at top
   drawPermanentStatusBar();
@@ -1598,9 +3318,9 @@ void showTallyState(String state, uint16_t color) {
   if (isRecording || isStreaming) {
     uint16_t bandColor = (isRecording ? RED : 0x07E0);
     if (isRecording && isStreaming) bandColor = 0xF81F;
-    M5.Lcd.fillRect(0, 119, 240, 16, bandColor);
-    M5.Lcd.setTextSize(1);
-    M5.Lcd.setTextColor(WHITE);
+    gDraw->fillRect(0, 119, 240, 16, bandColor);
+    gDraw->setTextSize(1);
+    gDraw->setTextColor(WHITE);
     
     String bannerText;
     if (isRecording && isStreaming) bannerText = "REC & STREAM";
@@ -1609,10 +3329,10 @@ void showTallyState(String state, uint16_t color) {
     
     // Center the banner text
     int textWidth = bannerText.length() * 6;
-    int x = (M5.Lcd.width() - textWidth) / 2;
+    int x = (gDraw->width() - textWidth) / 2;
     if (x < 4) x = 4;
-    M5.Lcd.setCursor(x, 123);
-    M5.Lcd.print(bannerText);
+    gDraw->setCursor(x, 123);
+    gDraw->print(bannerText);
   }
   
   // Enhance tally state display with better formatting
@@ -1630,21 +3350,22 @@ void showTallyState(String state, uint16_t color) {
   }
   
   // Calculate main text position considering status bar and bottom banner
-  int screenW = M5.Lcd.width();
-  int screenH = M5.Lcd.height();
+  int screenW = gDraw->width();
+  int screenH = gDraw->height();
   int usableTop = 16; // Status bar height
   int usableBottom = (isRecording || isStreaming) ? 16 : 0;
   int usableH = screenH - usableTop - usableBottom;
 
   // Main centered state text (in area below status bar)
   drawCenteredStatus(displayState, color, WHITE);
+  flushFrame();
 }
 
 // Draw large centered status text choosing optimal text size for readability.
 void drawCenteredStatus(const String &text, uint16_t bgColor, uint16_t textColor) {
   // Reserve top 16px for battery/Wi-Fi region (they occupy y ~ 0..15)
-  int screenW = M5.Lcd.width();
-  int screenH = M5.Lcd.height();
+  int screenW = gDraw->width();
+  int screenH = gDraw->height();
   int usableTop = 16;
   int usableH = screenH - usableTop - 20; // leave some room for bottom banner if present
   if (usableH < 10) usableH = screenH; // fallback
@@ -1688,17 +3409,17 @@ void drawCenteredStatus(const String &text, uint16_t bgColor, uint16_t textColor
       int y = usableTop + (usableH - textHeight) / 2;
       if (y < usableTop) y = usableTop;
       
-      M5.Lcd.setTextSize(sz);
-      M5.Lcd.setTextColor(textColor);
-      M5.Lcd.setCursor(x, y);
-      M5.Lcd.print(text);
+      gDraw->setTextSize(sz);
+      gDraw->setTextColor(textColor);
+      gDraw->setCursor(x, y);
+      gDraw->print(text);
       return;
     }
   }
   
   // Fallback for extremely long text - word wrap with size 1
-  M5.Lcd.setTextSize(1);
-  M5.Lcd.setTextColor(textColor);
+  gDraw->setTextSize(1);
+  gDraw->setTextColor(textColor);
   
   // Simple word wrapping for very long messages
   String remaining = text;
@@ -1730,21 +3451,22 @@ void drawCenteredStatus(const String &text, uint16_t bgColor, uint16_t textColor
     int x = (screenW - lineWidth) / 2;
     if (x < 2) x = 2;
     
-    M5.Lcd.setCursor(x, currentY);
-    M5.Lcd.print(line);
+    gDraw->setCursor(x, currentY);
+    gDraw->print(line);
     currentY += lineHeight;
   }
 }
 
 void drawInfoOverlay() {
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
   // Clear screen below permanent status bar
-  M5.Lcd.fillRect(0, 16, M5.Lcd.width(), M5.Lcd.height() - 16, BLACK);
+  gDraw->fillRect(0, 16, gDraw->width(), gDraw->height() - 16, BLACK);
   
   // Always draw permanent status bar at top
   drawPermanentStatusBar();
   
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setTextSize(2);
+  gDraw->setTextColor(WHITE);
+  gDraw->setTextSize(2);
 
   int y = 26; // Start below status bar
   // Source name
@@ -1752,20 +3474,21 @@ void drawInfoOverlay() {
   if (customDisplayName.length() > 0) displaySource = customDisplayName;
   else if (assignedSourceName.length() > 0) displaySource = assignedSourceName;
   else if (currentSource.length() > 0) displaySource = currentSource;
-  else if (assignedSource.length() > 0) displaySource = cleanSourceName(assignedSource);
+  else if (assignedDisplayName.length() > 0) displaySource = assignedDisplayName;
   else displaySource = "No Source";
   if (displaySource.length() > 12) displaySource = displaySource.substring(0,11) + "...";
-  M5.Lcd.setCursor(8, y); M5.Lcd.print(displaySource); y += 26;
-  M5.Lcd.setTextSize(1);
-  M5.Lcd.setCursor(8, y); M5.Lcd.printf("IP: %s", WiFi.localIP().toString().c_str()); y += 12;
-  M5.Lcd.setCursor(8, y); M5.Lcd.printf("ID: %s", device_id.c_str()); y += 12;
-  M5.Lcd.setCursor(8, y); M5.Lcd.printf("Hub: %s:%d", hub_ip.c_str(), hub_port); y += 12;
+  gDraw->setCursor(8, y); gDraw->print(displaySource); y += 26;
+  gDraw->setTextSize(1);
+  gDraw->setCursor(8, y); gDraw->printf("IP: %s", WiFi.localIP().toString().c_str()); y += 12;
+  gDraw->setCursor(8, y); gDraw->printf("ID: %s", device_id.c_str()); y += 12;
+  gDraw->setCursor(8, y); gDraw->printf("Hub: %s:%d", hub_ip.c_str(), hub_port); y += 12;
   // Network selection instruction
-  M5.Lcd.setCursor(8, M5.Lcd.height() - 26);
-  M5.Lcd.print("A+B: Network selection");
+  gDraw->setCursor(8, gDraw->height() - 26);
+  gDraw->print("A+B: Network selection");
   // Instructions
-  M5.Lcd.setCursor(8, M5.Lcd.height() - 14);
-  M5.Lcd.print("Release A to hide");
+  gDraw->setCursor(8, gDraw->height() - 14);
+  gDraw->print("Release A to hide");
+  flushFrame();
 }
 
 void showDeviceInfo() {
@@ -1869,7 +3592,8 @@ void drawBatteryIndicator(const BatteryInfo &info) {
   }
   
   // Unified design for both devices (dynamic width from driver so board mismatch won't hide icons)
-  const int screenW = M5.Lcd.width();
+  const int screenW = gDraw->width();
+  frameDirty(0, 0, screenW, 16); // everything below stays inside the status bar
   const int y = 2;
   const int battW = 24; // body width
   const int battH = 12; // body height
@@ -1880,12 +3604,12 @@ void drawBatteryIndicator(const BatteryInfo &info) {
 
   // Percent text will be to the left of Wi-Fi group; handled outside battery box for compactness
   // Draw outline
-  M5.Lcd.drawRect(battX, y, battW, battH, WHITE);
-  M5.Lcd.fillRect(battX + battW, y + (battH/3), tipW, battH/3, WHITE);
+  gDraw->drawRect(battX, y, battW, battH, WHITE);
+  gDraw->fillRect(battX + battW, y + (battH/3), tipW, battH/3, WHITE);
   // Inner fill area
   int innerW = battW - 4, innerH = battH - 4, px = battX + 2, py = y + 2;
   int levelW = (innerW * info.percent)/100; if (levelW < 0) levelW = 0; if (levelW > innerW) levelW = innerW;
-  M5.Lcd.fillRect(px, py, innerW, innerH, BLACK);
+  gDraw->fillRect(px, py, innerW, innerH, BLACK);
   uint16_t fillColor = (info.percent < 15) ? RED : (info.percent < 30 ? 0xFD20 : (info.percent < 60 ? 0xFFE0 : 0x07E0));
   bool doBlink = (!info.charging && info.percent < 15);
   static unsigned long lastBlink = 0; static bool blinkOn = true;
@@ -1896,7 +3620,7 @@ void drawBatteryIndicator(const BatteryInfo &info) {
     blinkOn = true; // ensure visible when not blinking condition
   }
   if (blinkOn) {
-    M5.Lcd.fillRect(px, py, levelW, innerH, fillColor);
+    gDraw->fillRect(px, py, levelW, innerH, fillColor);
   }
 
   // Charging / plugged icon centered inside (bolt animates)
@@ -1904,26 +3628,26 @@ void drawBatteryIndicator(const BatteryInfo &info) {
     unsigned long now = millis(); if (now - gBatAnimLast > 260) { gBatAnimLast = now; gBatAnimPhase = (gBatAnimPhase + 1) % 4; }
     if (gBatAnimPhase < 3) {
       int cx = battX + battW/2 - 3; int cy = y + 2; // 6x8 area
-      M5.Lcd.fillTriangle(cx, cy, cx+4, cy+4, cx+2, cy+4, WHITE);
-      M5.Lcd.fillTriangle(cx+2, cy+4, cx+6, cy+8, cx+4, cy+8, WHITE);
+      gDraw->fillTriangle(cx, cy, cx+4, cy+4, cx+2, cy+4, WHITE);
+      gDraw->fillTriangle(cx+2, cy+4, cx+6, cy+8, cx+4, cy+8, WHITE);
     }
   } else if (info.usb) {
     int pxIcon = battX + battW/2 - 3, pyIcon = y + 2;
-    M5.Lcd.drawRect(pxIcon, pyIcon, 6, 8, WHITE);
-    M5.Lcd.drawFastVLine(pxIcon+1, pyIcon-2, 4, WHITE);
-    M5.Lcd.drawFastVLine(pxIcon+4, pyIcon-2, 4, WHITE);
+    gDraw->drawRect(pxIcon, pyIcon, 6, 8, WHITE);
+    gDraw->drawFastVLine(pxIcon+1, pyIcon-2, 4, WHITE);
+    gDraw->drawFastVLine(pxIcon+4, pyIcon-2, 4, WHITE);
   }
 
   // Percent text left of battery (if enabled)
   #ifndef BATT_HIDE_PERCENT
     if (uiCfg.showBattPercent) {
-      M5.Lcd.setTextColor(WHITE);
+      gDraw->setTextColor(WHITE);
       bool small = uiCfg.smallBattPercent;
       #ifdef BATT_SMALL_PERCENT
         small = true; // compile-time override
       #endif
       int oldBoundary = gBattPctLeftX;
-      M5.Lcd.setTextSize(1);
+      gDraw->setTextSize(1);
       int pctX;
       int clearW;
       int textY;
@@ -1944,14 +3668,14 @@ void drawBatteryIndicator(const BatteryInfo &info) {
       if (clearRight > battX) clearRight = battX;
       int clearWidth = clearRight - clearLeft;
       if (clearWidth > 0) {
-        M5.Lcd.fillRect(clearLeft, y, clearWidth, battH, BLACK);
+        gDraw->fillRect(clearLeft, y, clearWidth, battH, BLACK);
       }
       gBattPctLeftX = pctX;
-      M5.Lcd.setCursor(pctX, textY);
+      gDraw->setCursor(pctX, textY);
       if (small) {
-        M5.Lcd.printf("%d%%", info.percent);
+        gDraw->printf("%d%%", info.percent);
       } else {
-        M5.Lcd.printf("%3d%%", info.percent);
+        gDraw->printf("%3d%%", info.percent);
       }
       // If boundary changed, request Wi-Fi redraw (immediate) to realign icon spacing
       if (oldBoundary != gBattPctLeftX) {
@@ -1979,11 +3703,12 @@ static int wifiLevelFromRSSI(int32_t rssi) {
 
 // Draw permanent status bar (black background, 16px high) at top of screen
 void drawPermanentStatusBar() {
-  const int screenW = M5.Lcd.width();
+  const int screenW = gDraw->width();
   const int barHeight = 16;
+  frameDirty(0, 0, screenW, barHeight);
   
   // Clear and draw status bar background
-  M5.Lcd.fillRect(0, 0, screenW, barHeight, BLACK);
+  gDraw->fillRect(0, 0, screenW, barHeight, BLACK);
   
   // Draw battery and Wi-Fi indicators within the status bar
   BatteryInfo b = readBattery();
@@ -2051,10 +3776,10 @@ void drawPermanentStatusBar() {
   }
   
   // Draw status text (left-aligned, white text)
-  M5.Lcd.setTextSize(1);
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setCursor(2, 4);
-  M5.Lcd.print(displayText);
+  gDraw->setTextSize(1);
+  gDraw->setTextColor(WHITE);
+  gDraw->setCursor(2, 4);
+  gDraw->print(displayText);
 }
 
 void drawWiFiIndicator() {
@@ -2066,8 +3791,9 @@ void drawWiFiIndicator() {
   static float levelSmooth = -1.0f; // EMA of level for flicker reduction
   bool connected = (WiFi.status() == WL_CONNECTED);
 
-  const int screenW = M5.Lcd.width();
+  const int screenW = gDraw->width();
   const int y = 2; // Within status bar (0-16px)
+  frameDirty(0, 0, screenW, 16);
   
   // Battery sits at right edge; compute its X used inside drawBatteryIndicator.
   const int battW = 24; const int tipW = 3; const int battX = screenW - (battW + tipW + 2);
@@ -2115,7 +3841,7 @@ void drawWiFiIndicator() {
     int bx = barsLeft + i*(barW + barGap);
     int by = bottom - h;
     // Outline
-    M5.Lcd.drawRect(bx, by, barW, h, barOutline);
+    gDraw->drawRect(bx, by, barW, h, barOutline);
     // Fill if enabled per level
     bool enabled = (level >= (i+1));
     if (enabled) {
@@ -2124,7 +3850,7 @@ void drawWiFiIndicator() {
       if (fw <= 0) { fw = barW; fx = bx; }
       int fy = by + 1; int fh = max(0, h - 2);
       if (fh <= 0) { fh = h; fy = by; }
-      M5.Lcd.fillRect(fx, fy, fw, fh, barActive);
+      gDraw->fillRect(fx, fy, fw, fh, barActive);
     }
   }
 
@@ -2138,8 +3864,8 @@ void drawWiFiIndicator() {
     int x0 = baseX + 1, y0 = y + 2;
     int x1 = wifiRight - 2, y1 = y + 12;
     for (int i=0;i<2;i++) {
-      M5.Lcd.drawLine(x0, y0+i, x1, y1+i, xc);
-      M5.Lcd.drawLine(x0, y1-i, x1, y0-i, xc);
+      gDraw->drawLine(x0, y0+i, x1, y1+i, xc);
+      gDraw->drawLine(x0, y1-i, x1, y0-i, xc);
     }
   }
 }
@@ -2149,6 +3875,9 @@ void loadConfiguration() {
   wifi_password = preferences.getString("wifi_password", "");
   hub_ip = preferences.getString("hub_ip", ""); // Empty default - use auto-discovery
   hub_port = preferences.getInt("hub_port", 7411);
+  standbyHub.ip = preferences.getString("hub2_ip", "");
+  standbyHub.port = preferences.getInt("hub2_port", 7411);
+  publishStandbyHub();
   
   // Generate unique device ID if not set
   String defaultDeviceId = preferences.getString("device_id", "");
@@ -2189,6 +3918,8 @@ void saveConfiguration() {
   preferences.putString("wifi_password", wifi_password);
   preferences.putString("hub_ip", hub_ip);
   preferences.putInt("hub_port", hub_port);
+  preferences.putString("hub2_ip", standbyHub.ip);
+  preferences.putInt("hub2_port", standbyHub.port);
   preferences.putString("device_id", device_id);
   preferences.putString("device_name", device_name);
   preferences.putBool("auto_disc", auto_discovery_enabled);
@@ -2207,6 +3938,7 @@ void loadAssignment() {
   assignedSourceName = preferences.getString("assigned_source_name", "");
   customDisplayName = preferences.getString("custom_display_name", "");
   isAssigned = preferences.getBool("is_assigned", false);
+  internAssignedSource();
   
   Serial.println("Assignment loaded:");
   if (isAssigned && assignedSource.length() > 0) {
@@ -2242,28 +3974,6 @@ void saveAssignment() {
   }
 }
 
-bool connectToSavedWiFi() {
-  if (wifi_ssid.length() == 0) return false;
-  
-  Serial.printf("Connecting to saved WiFi: %s\n", wifi_ssid.c_str());
-  WiFi.begin(wifi_ssid.c_str(), wifi_password.c_str());
-  
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nConnected to saved WiFi");
-    return true;
-  } else {
-    Serial.println("\nFailed to connect to saved WiFi");
-    return false;
-  }
-}
-
 // WiFi Memory System Functions
 void loadSavedNetworks() {
   networkCount = preferences.getInt("wifi_count", 0);
@@ -2277,6 +3987,11 @@ void loadSavedNetworks() {
     savedNetworks[i].ssid = preferences.getString(ssidKey.c_str(), "");
     savedNetworks[i].password = preferences.getString(passKey.c_str(), "");
     savedNetworks[i].isActive = preferences.getBool(activeKey.c_str(), true);
+    savedNetworks[i].fastJoin = {};
+    String fastKey = "wifi_fj_" + String(i);
+    if (preferences.getBytesLength(fastKey.c_str()) == sizeof(WiFiFastJoin)) {
+      preferences.getBytes(fastKey.c_str(), &savedNetworks[i].fastJoin, sizeof(WiFiFastJoin));
+    }
   }
   
   Serial.printf("Loaded %d saved WiFi networks\n", networkCount);
@@ -2293,6 +4008,7 @@ void saveSavedNetworks() {
     preferences.putString(ssidKey.c_str(), savedNetworks[i].ssid);
     preferences.putString(passKey.c_str(), savedNetworks[i].password);
     preferences.putBool(activeKey.c_str(), savedNetworks[i].isActive);
+    preferences.putBytes(("wifi_fj_" + String(i)).c_str(), &savedNetworks[i].fastJoin, sizeof(WiFiFastJoin));
   }
   
   Serial.printf("Saved %d WiFi networks to memory\n", networkCount);
@@ -2316,6 +4032,10 @@ void addNetworkToMemory(String ssid, String password) {
     savedNetworks[networkCount].ssid = ssid;
     savedNetworks[networkCount].password = password;
     savedNetworks[networkCount].isActive = true;
+    savedNetworks[networkCount].fastJoin = {};
+    savedNetworks[networkCount].joinAttempts = 0;
+    savedNetworks[networkCount].joinSuccesses = 0;
+    savedNetworks[networkCount].joinMsAvg = 0;
     networkCount++;
     Serial.printf("Added new network to memory: %s\n", ssid.c_str());
   } else {
@@ -2326,6 +4046,10 @@ void addNetworkToMemory(String ssid, String password) {
     savedNetworks[MAX_WIFI_NETWORKS - 1].ssid = ssid;
     savedNetworks[MAX_WIFI_NETWORKS - 1].password = password;
     savedNetworks[MAX_WIFI_NETWORKS - 1].isActive = true;
+    savedNetworks[MAX_WIFI_NETWORKS - 1].fastJoin = {};
+    savedNetworks[MAX_WIFI_NETWORKS - 1].joinAttempts = 0;
+    savedNetworks[MAX_WIFI_NETWORKS - 1].joinSuccesses = 0;
+    savedNetworks[MAX_WIFI_NETWORKS - 1].joinMsAvg = 0;
     Serial.printf("Replaced oldest network with: %s\n", ssid.c_str());
   }
   
@@ -2349,6 +4073,7 @@ bool removeNetworkFromMemory(int index) {
   savedNetworks[networkCount - 1].ssid = "";
   savedNetworks[networkCount - 1].password = "";
   savedNetworks[networkCount - 1].isActive = false;
+  savedNetworks[networkCount - 1].fastJoin = {};
   
   networkCount--;
   saveSavedNetworks();
@@ -2364,6 +4089,7 @@ void clearAllSavedNetworks() {
     savedNetworks[i].ssid = "";
     savedNetworks[i].password = "";
     savedNetworks[i].isActive = false;
+    savedNetworks[i].fastJoin = {};
   }
   
   networkCount = 0;
@@ -2372,62 +4098,6 @@ void clearAllSavedNetworks() {
   Serial.println("All saved networks cleared");
 }
 
-bool connectToKnownNetworks() {
-  Serial.println("Trying to connect to known networks...");
-  
-  // First, scan for available networks
-  int n = WiFi.scanNetworks();
-  if (n == 0) {
-    Serial.println("No networks found");
-    return false;
-  }
-  
-  // Try each saved network that is available
-  for (int i = 0; i < networkCount; i++) {
-    if (!savedNetworks[i].isActive) continue;
-    
-    // Check if this saved network is available
-    for (int j = 0; j < n; j++) {
-      if (WiFi.SSID(j) == savedNetworks[i].ssid) {
-        Serial.printf("Found known network: %s\n", savedNetworks[i].ssid.c_str());
-        if (tryConnectToNetwork(savedNetworks[i].ssid, savedNetworks[i].password)) {
-          WiFi.scanDelete(); // Clean up scan results
-          return true;
-        }
-        break;
-      }
-    }
-  }
-  
-  WiFi.scanDelete(); // Clean up scan results
-  Serial.println("Could not connect to any known networks");
-  return false;
-}
-
-bool tryConnectToNetwork(String ssid, String password) {
-  Serial.printf("Attempting to connect to: %s\n", ssid.c_str());
-  
-  WiFi.begin(ssid.c_str(), password.c_str());
-  
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("\nSuccessfully connected to: %s\n", ssid.c_str());
-    // Update current WiFi variables for compatibility
-    wifi_ssid = ssid;
-    wifi_password = password;
-    return true;
-  } else {
-    Serial.printf("\nFailed to connect to: %s\n", ssid.c_str());
-    return false;
-  }
-}
-
 void startConfigMode() {
   configMode = true;
   configModeTimeout = millis();
@@ -2496,7 +4166,8 @@ void handleConfigMode() {
 // Generate and display actual scannable QR Code for WiFi credentials
 void displayWiFiQRCode() {
   Serial.println("Displaying WiFi QR Code");
-  M5.Lcd.fillScreen(BLACK);
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
+  gDraw->fillScreen(BLACK);
   
   // QR code data for WiFi: WIFI:T:WPA;S:SSID;P:PASSWORD;;
   String qrData = "WIFI:T:WPA;S:" + AP_SSID + ";P:" + String(AP_PASSWORD) + ";;";
@@ -2510,14 +4181,14 @@ void displayWiFiQRCode() {
   Serial.printf("QR Code size: %d\n", qrcode.size);
   
   // Calculate QR code display parameters for full screen
-  int maxScale = min(M5.Lcd.width() / qrcode.size, M5.Lcd.height() / qrcode.size);
+  int maxScale = min(gDraw->width() / qrcode.size, gDraw->height() / qrcode.size);
   int scale = max(1, maxScale); // Ensure at least scale of 1
   int qrDisplaySize = qrcode.size * scale;
-  int startX = (M5.Lcd.width() - qrDisplaySize) / 2;
-  int startY = (M5.Lcd.height() - qrDisplaySize) / 2;
+  int startX = (gDraw->width() - qrDisplaySize) / 2;
+  int startY = (gDraw->height() - qrDisplaySize) / 2;
   
   Serial.printf("Display: %dx%d, Scale: %d, Start: (%d,%d)\n", 
-                M5.Lcd.width(), M5.Lcd.height(), scale, startX, startY);
+                gDraw->width(), gDraw->height(), scale, startX, startY);
   
   // Draw QR code with inverted colors (white on black for better contrast)
   for (uint8_t y = 0; y < qrcode.size; y++) {
@@ -2526,71 +4197,74 @@ void displayWiFiQRCode() {
       uint16_t color = qrcode_getModule(&qrcode, x, y) ? WHITE : BLACK;
       
       if (scale == 1) {
-        M5.Lcd.drawPixel(startX + x, startY + y, color);
+        gDraw->drawPixel(startX + x, startY + y, color);
       } else {
         // Draw scaled modules
-        M5.Lcd.fillRect(startX + x * scale, startY + y * scale, scale, scale, color);
+        gDraw->fillRect(startX + x * scale, startY + y * scale, scale, scale, color);
       }
     }
   }
   
+  flushFrame();
   Serial.println("QR Code displayed");
 }
 
 void displayWiFiInfo() {
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
   // Clear screen below permanent status bar
-  M5.Lcd.fillRect(0, 16, M5.Lcd.width(), M5.Lcd.height() - 16, BLUE);
+  gDraw->fillRect(0, 16, gDraw->width(), gDraw->height() - 16, BLUE);
   
   // Always draw permanent status bar at top - show config mode status
-  M5.Lcd.fillRect(0, 0, M5.Lcd.width(), 16, BLACK);
-  M5.Lcd.setTextSize(1);
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setCursor(2, 3);
-  M5.Lcd.print("Config Mode");
+  gDraw->fillRect(0, 0, gDraw->width(), 16, BLACK);
+  gDraw->setTextSize(1);
+  gDraw->setTextColor(WHITE);
+  gDraw->setCursor(2, 3);
+  gDraw->print("Config Mode");
   
   // Draw battery and Wi-Fi in status bar
   BatteryInfo b = readBattery();
   drawBatteryIndicator(b);
   drawWiFiIndicator();
   
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setTextSize(1);
+  gDraw->setTextColor(WHITE);
+  gDraw->setTextSize(1);
   int y = 20; // Start below status bar
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("=== WiFi Setup ===");
+  gDraw->setCursor(5, y);
+  gDraw->printf("=== WiFi Setup ===");
   y += 15;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("1. Scan QR code OR");
+  gDraw->setCursor(5, y);
+  gDraw->printf("1. Scan QR code OR");
   y += 12;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("2. Connect to WiFi:");
+  gDraw->setCursor(5, y);
+  gDraw->printf("2. Connect to WiFi:");
   y += 12;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("   %s", AP_SSID.c_str());
+  gDraw->setCursor(5, y);
+  gDraw->printf("   %s", AP_SSID.c_str());
   y += 12;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("   Pass: %s", AP_PASSWORD);
+  gDraw->setCursor(5, y);
+  gDraw->printf("   Pass: %s", AP_PASSWORD);
   y += 16;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("3. Open browser:");
+  gDraw->setCursor(5, y);
+  gDraw->printf("3. Open browser:");
   y += 12;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("   192.168.4.1");
+  gDraw->setCursor(5, y);
+  gDraw->printf("   192.168.4.1");
   y += 16;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("A:QR Code B:Exit");
+  gDraw->setCursor(5, y);
+  gDraw->printf("A:QR Code B:Exit");
   y += 12;
   
-  M5.Lcd.setCursor(5, y);
-  M5.Lcd.printf("Timeout: 5 minutes");
+  gDraw->setCursor(5, y);
+  gDraw->printf("Timeout: 5 minutes");
+  flushFrame();
 }
 
 void setupWebServer() {
@@ -2767,7 +4441,11 @@ void handleRoot() {
   html += "<div class='form-group'><label class='form-label'>Hub Server IP (leave empty for auto-discovery)</label>";
   html += "<input type='text' name='hub_ip' class='form-input' placeholder='Auto-discover or enter IP like 192.168.1.100' value='" + hub_ip + "'></div>";
   html += "<div class='form-group'><label class='form-label'>Hub Server Port</label>";
-  html += "<input type='number' name='hub_port' class='form-input' placeholder='7411' value='" + String(hub_port) + "' min='1' max='65535'></div></div></div>";
+  html += "<input type='number' name='hub_port' class='form-input' placeholder='7411' value='" + String(hub_port) + "' min='1' max='65535'></div>";
+  html += "<div class='form-group'><label class='form-label'>Standby Hub IP (optional)</label>";
+  html += "<input type='text' name='hub2_ip' class='form-input' placeholder='Second hub for failover, e.g. 192.168.1.101' value='" + standbyHub.ip + "'></div>";
+  html += "<div class='form-group'><label class='form-label'>Standby Hub Port</label>";
+  html += "<input type='number' name='hub2_port' class='form-input' placeholder='7411' value='" + String(standbyHub.port) + "' min='1' max='65535'></div></div></div>";
   html += "<div class='form-group'><label class='form-label'>Device ID</label>";
   html += "<input type='text' name='device_id' class='form-input' placeholder='m5-tally-a1b2c3' value='" + device_id + "' required></div>";
   html += "<div class='form-group'><label class='form-label'>Display Name</label>";
@@ -2814,6 +4492,13 @@ void handleSave() {
   wifi_password = server.arg("password");
   hub_ip = server.arg("hub_ip");
   hub_port = server.arg("hub_port").toInt();
+  if (server.arg("hub2_ip") != standbyHub.ip || server.arg("hub2_port").toInt() != standbyHub.port) {
+    standbyHub.ip = server.arg("hub2_ip");
+    standbyHub.port = server.hasArg("hub2_port") && server.arg("hub2_port").toInt() > 0 ? server.arg("hub2_port").toInt() : 7411;
+    standbyHub.registered = false;
+    standbyHub.nextTxAt = millis();
+    publishStandbyHub();
+  }
   device_id = server.arg("device_id");
   device_name = server.arg("device_name");
   
@@ -2907,28 +4592,12 @@ void handleSwitchNetwork() {
   // Send success response before attempting connection
   server.send(200, "text/plain", "success");
   
-  // Disconnect current connection
-  WiFi.disconnect();
-  delay(100);
-  
-  // Connect to selected network
-  WiFi.begin(ssid.c_str(), password.c_str());
-  
   // Update current WiFi settings for future reference
   wifi_ssid = ssid;
   wifi_password = password;
   
-  // Wait for connection with timeout
-  unsigned long connectStart = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - connectStart < 10000) {
-    delay(100);
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("Successfully switched to network: %s\n", ssid.c_str());
-  } else {
-    Serial.printf("Failed to switch to network: %s\n", ssid.c_str());
-  }
+  // Switch in the background; the connection manager re-registers once the new network is up
+  connJoinNetwork(ssid, password);
 }
 
 void handleDeleteNetwork() {
@@ -3118,6 +4787,18 @@ void handleSources() {
   server.send(200, "text/html", html);
 }
 
+static String hubFeaturesText(uint32_t features) {
+  if (features == 0) return "not negotiated";
+  String text;
+  if (features & TALLY_CAP_SNAPSHOT) text += "snapshot ";
+  if (features & TALLY_CAP_BINARY) text += "binary ";
+  if (features & TALLY_CAP_JSON_TALLY) text += "json ";
+  if (features & TALLY_CAP_MULTICAST) text += "multicast ";
+  if (features & TALLY_CAP_SEQ) text += "seq";
+  text.trim();
+  return text;
+}
+
 void handleStatus() {
   String html = "<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'>";
   html += "<meta name='viewport' content='width=device-width, initial-scale=1.0\">";
@@ -3182,6 +4863,70 @@ void handleStatus() {
   html += "<span class='status-value'>" + WiFi.localIP().toString() + "</span></div>";
   html += "<div class='status-item'><span class='status-label'>Hub Server</span>";
   html += "<span class='status-value'>" + hub_ip + ":" + String(hub_port) + "</span></div></div></div>";
+  html += "<div class='card'><div class='card-header'><div class='card-icon'>📥</div>";
+  html += "<h3>Network Receive</h3></div><div class='status-grid'>";
+  html += "<div class='status-item'><span class='status-label'>Packets Received</span>";
+  html += "<span class='status-value'>" + String(gNetStats.received) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Dropped (queue full)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.dropped) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Parse Errors (oversize)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.parseErrors) + " (" + String(gNetStats.oversize) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Socket / Send Errors</span>";
+  html += "<span class='status-value'>" + String(gNetStats.socketErrors) + " / " + String(gNetStats.sendErrors.load()) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Queue Depth (max)</span>";
+  html += "<span class='status-value'>" + String(netQueueDepth()) + " (" + String(gNetStats.queueHighWater) + "/" + String(NET_EVENT_QUEUE_LEN) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Loop Wakeups (avg / s)</span>";
+  html += "<span class='status-value'>" + String(millis() ? (float)gLoopPasses * 1000.0f / millis() : 0.0f, 1) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Connection</span>";
+  html += "<span class='status-value'>" + String(CONN_STATE_NAMES[connState]) + " (" + String((millis() - connStateSince) / 1000) + " s)</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Last WiFi Join (assoc / IP)</span>";
+  html += "<span class='status-value'>" + String(lastJoin.directed ? "directed" : "scanned") + ", " + String(lastJoin.assocMs) + " / "
+        + String(lastJoin.ipMs) + " ms" + (lastJoin.cachedLease ? " (cached lease)" : "") + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Roaming (RSSI avg, scans / handovers)</span>";
+  html += "<span class='status-value'>" + String(gRoamRssiAvg) + " dBm, " + String(roamScans) + " / " + String(roamHandovers) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Standby Hub (epoch, failovers)</span>";
+  html += "<span class='status-value'>" + (standbyHub.ip.length() ? standbyHub.ip + ":" + String(standbyHub.port) + (standbyAlive() ? " up" : " down")
+        + " (" + String(standbyHub.epoch) + ", " + String(hubFailovers) + "), active epoch " + String(hubEpoch) : String("none")) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Hub Cache (last discovery)</span>";
+  html += "<span class='status-value'>" + (hubConfirmedAt ? String(hubCacheFresh() ? "confirmed " : "stale, ") + String((millis() - hubConfirmedAt) / 1000) + " s ago" : String("unconfirmed"))
+        + " (" + String(lastDiscoveryHubs) + " hubs)</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Negotiated Features (dropped)</span>";
+  html += "<span class='status-value'>" + hubFeaturesText(gHubFeatures.load()) + " (" + String(gNetStats.unnegotiated) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Hub Session (resumes)</span>";
+  html += "<span class='status-value'>" + String(hubSession.length() ? "held" : "none") + " (" + String(sessionResumes) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Boot to Registered</span>";
+  html += "<span class='status-value'>" + (bootToRegisteredMs ? String(bootToRegisteredMs) + " ms" : String("-")) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Heartbeat (sent, piggybacked)</span>";
+  html += "<span class='status-value'>every " + String(heartbeatIntervalMs / 1000) + " s (" + String(heartbeatsSent) + ", " + String(heartbeatsPiggybacked) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Tally Acks Sent</span>";
+  html += "<span class='status-value'>" + String(tallyAcksSent.load()) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Tally Sync (last, completed)</span>";
+  html += "<span class='status-value'>" + (syncPending ? String("pending") : lastSyncMs ? String(lastSyncMs) + " ms" : String("-"))
+        + " (" + String(syncsCompleted) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Hub RTT (RTO, probe timeouts)</span>";
+  html += "<span class='status-value'>" + (gHubRtt.valid ? String(gHubRtt.srtt) + " ± " + String(gHubRtt.rttvar) + " ms" : String("-"))
+        + " (" + String(tallyRto(gHubRtt)) + " ms, " + String(gNetStats.probeTimeouts) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Worst Apply Latency</span>";
+  html += "<span class='status-value'>" + String(gNetStats.maxApplyLatencyMs) + " ms</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Binary / JSON Frames</span>";
+  html += "<span class='status-value'>" + String(gNetStats.binaryFrames) + " / " + String(gNetStats.jsonFrames) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Avg Decode (bin / JSON)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.binaryFrames ? (unsigned long)(gNetStats.binaryDecodeUs / gNetStats.binaryFrames) : 0UL) + " / "
+        + String(gNetStats.jsonFrames ? (unsigned long)(gNetStats.jsonDecodeUs / gNetStats.jsonFrames) : 0UL) + " µs</span></div>";
+  html += "<div class='status-item'><span class='status-label'>JSON Heap Allocs (arena peak)</span>";
+  html += "<span class='status-value'>" + String(gNetJsonArena.heapAllocs()) + " (" + String((unsigned long)gNetJsonArena.highWater()) + "/" + String(NET_JSON_ARENA_SIZE) + " B)</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Pre-scan Rejects (cycles: reject / full parse)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.earlyRejects) + " (" + String(gNetStats.earlyRejects ? (unsigned long)(gNetStats.earlyRejectCycles / gNetStats.earlyRejects) : 0UL) + " / "
+        + String(gNetStats.jsonFrames ? (unsigned long)(gNetStats.jsonDecodeCycles / gNetStats.jsonFrames) : 0UL) + ")</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Tally Frames (applied / deduplicated)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.tallyApplied) + " / " + String(gNetStats.deduplicated) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Seq Stale / Dup / Gaps (resyncs)</span>";
+  html += "<span class='status-value'>" + String(gNetStats.seqStale) + " / " + String(gNetStats.seqDuplicates) + " / " + String(gNetStats.seqGaps)
+        + " (" + String(gNetStats.seqResyncs) + ")</span></div>";
+  uint32_t mcastGroup = gMcastGroup.load();
+  html += "<div class='status-item'><span class='status-label'>Multicast (frames / fallbacks)</span>";
+  html += "<span class='status-value'>" + (mcastGroup ? IPAddress(mcastGroup).toString() : String(multicastSuspended ? "Unicast (fallback)" : "Unicast"))
+        + " (" + String(gNetStats.mcastFrames) + " / " + String(gNetStats.mcastFallbacks) + ")</span></div></div></div>";
   html += "<div class='card'><div class='card-header'><div class='card-icon'>🎯</div>";
   html += "<h3>Tally Status</h3></div><div class='status-grid'>";
   html += "<div class='status-item'><span class='status-label'>Assigned Source</span>";
@@ -3197,7 +4942,13 @@ void handleStatus() {
   html += "<div class='status-item'><span class='status-label'>Streaming</span>";
   html += "<span class='status-value " + String(isStreaming ? "status-streaming" : "") + "'>" + String(isStreaming ? "STREAM" : "OFF") + "</span></div>";
   html += "<div class='status-item'><span class='status-label'>Last Update</span>";
-  html += "<span class='status-value'>" + (lastTallyUpdate > 0 ? String((millis() - lastTallyUpdate) / 1000) + "s ago" : "Never") + "</span></div></div></div>";
+  html += "<span class='status-value'>" + (lastTallyUpdate > 0 ? String((millis() - lastTallyUpdate) / 1000) + "s ago" : "Never") + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Display Push (last change / full frame)</span>";
+  html += "<span class='status-value'>" + (gDraw == &gFrame ? String(gFrameStats.lastChangeBytes) + " / " + String((unsigned long)gFrame.width() * gFrame.height() * 2) + " B"
+        : String("direct")) + "</span></div>";
+  html += "<div class='status-item'><span class='status-label'>Display Flushes (windows, total)</span>";
+  html += "<span class='status-value'>" + String(gFrameStats.flushes) + " (" + String(gFrameStats.windows) + ", "
+        + String((unsigned long)(gFrameStats.bytesPushed / 1024)) + " KB)</span></div></div></div>";
   
   // Navigation Card
   html += "<div class='card'><div class='card-header'><div class='card-icon'>🏠</div>";
@@ -3225,10 +4976,14 @@ void handleAssign() {
   sourceId.trim();
   sourceName.trim();
   
+  // Any snapshot slot we hold was handed out for the previous assignment
+  gAssignedSlotKey.store(NET_NO_SLOT_KEY);
+
   if (sourceId.length() == 0) {
     assignedSource = "";
     customDisplayName = ""; // Clear custom display name on unassignment
     isAssigned = false;
+    internAssignedSource();
     currentSource = "";
     isProgram = false;
     isPreview = false;
@@ -3267,7 +5022,9 @@ void handleAssign() {
     server.send(200, "text/html", html);
   } else {
     assignedSource = sourceId;
+    assignedSourceName = ""; // the hub's name belonged to the previous source; it comes back with the hub's assignment
     isAssigned = true;
+    internAssignedSource();
     
     // Save custom display name if provided via web portal
     if (sourceName.length() > 0) {
@@ -3286,6 +5043,8 @@ void handleAssign() {
     saveAssignment();
     
     Serial.printf("Device assigned to source via web interface: %s\n", sourceId.c_str());
+    // Re-register so the hub syncs the assignment and hands out its snapshot slot
+    registerWithHub();
     
     String html = "<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'>";
     html += "<meta name='viewport' content='width=device-width, initial-scale=1.0\">";
@@ -3412,15 +5171,119 @@ String cleanSourceName(String sourceName) {
 // ---------------------------------------------------------------
 // Auto-Discovery Implementation (firmware -> hub)
 // ---------------------------------------------------------------
-// Strategy: send a small UDP JSON packet {type:"discover"} to the subnet broadcast
-// on the default hub port (7411) and also to the last-known hub_ip if set. The hub replies
-// with {type:"discover_reply", hubIp, udpPort, apiPort}. We then persist hub_ip/port.
-// Called on initial Wi-Fi connect or during reconnection attempts when not registered.
+// Strategy: send a small UDP JSON packet {type:"discover", t} to the subnet broadcast
+// on the default hub port (7411) and also to the last-known hub_ip if set. Every hub replies
+// with {type:"discover_reply", hubIp, udpPort, apiPort, t}. Replies collect for a short window,
+// then the best hub (same subnet first, then lowest RTT) is persisted in hub_ip/port.
+// The last probe of a round also starts an asynchronous mDNS query; its answers join the window.
+// Called on initial Wi-Fi connect, to revalidate the cached hub, and during reconnection attempts.
 
-static unsigned long gLastDiscoveryAttempt = 0;
-static uint8_t gDiscoveryAttempts = 0;
-const unsigned long DISCOVERY_INTERVAL_MS = 4000; // backoff window between probes
-const uint8_t DISCOVERY_MAX_ATTEMPTS = 6; // stop after ~24s initial scan (will retry on later recon cycles)
+bool hubCacheFresh() {
+  return hubConfirmedAt != 0 && millis() - hubConfirmedAt < HUB_CACHE_TTL_MS;
+}
+
+static void openDiscoveryWindow() {
+  if (!gDiscoveryWindowOpen) gHubCandidateCount = 0;
+  gDiscoveryWindowOpen = true;
+  gDiscoveryWindowEnd = millis() + DISCOVERY_WINDOW_MS;
+}
+
+void addHubCandidate(uint32_t ip, uint16_t port, uint32_t rttMs) {
+  if (ip == 0 || port == 0) return;
+  if (!gDiscoveryWindowOpen) openDiscoveryWindow(); // a late reply starts a short window of its own
+  for (uint8_t i = 0; i < gHubCandidateCount; i++) {
+    if (gHubCandidates[i].ip == ip && gHubCandidates[i].port == port) {
+      if (rttMs < gHubCandidates[i].rttMs) gHubCandidates[i].rttMs = rttMs;
+      return;
+    }
+  }
+  if (gHubCandidateCount == DISCOVERY_MAX_CANDIDATES) return;
+  bool sameSubnet = ((ip ^ (uint32_t)WiFi.localIP()) & (uint32_t)WiFi.subnetMask()) == 0;
+  gHubCandidates[gHubCandidateCount++] = { ip, port, rttMs, sameSubnet };
+}
+
+static bool hubCandidateBetter(const HubCandidate &a, const HubCandidate &b) {
+  if (a.sameSubnet != b.sameSubnet) return a.sameSubnet;
+  return a.rttMs < b.rttMs;
+}
+
+// End of a round: keep the current hub if it answered (or is serving us), otherwise move to the best one
+static void closeDiscoveryWindow() {
+  gDiscoveryWindowOpen = false;
+  lastDiscoveryHubs = gHubCandidateCount;
+  if (gHubCandidateCount == 0) return;
+  IPAddress current;
+  bool haveCurrent = current.fromString(hub_ip);
+  bool currentAnswered = false;
+  const HubCandidate *best = &gHubCandidates[0];
+  for (uint8_t i = 0; i < gHubCandidateCount; i++) {
+    const HubCandidate &c = gHubCandidates[i];
+    Serial.printf("Discovery: hub %s:%u, RTT %s ms, %s subnet\n", IPAddress(c.ip).toString().c_str(), c.port,
+                  c.rttMs == DISCOVERY_NO_RTT ? "-" : String(c.rttMs).c_str(), c.sameSubnet ? "same" : "other");
+    if (haveCurrent && c.ip == (uint32_t)current && c.port == hub_port) currentAnswered = true;
+    if (hubCandidateBetter(c, *best)) best = &c;
+  }
+  if (currentAnswered || (isRegisteredWithHub && !hubLinkLost)) {
+    // Never churn away from a hub that works: a lower RTT elsewhere is not worth a re-registration
+    if (currentAnswered) hubConfirmedAt = millis();
+    return;
+  }
+
+  String newIp = IPAddress(best->ip).toString();
+  Serial.printf("Discovery: updating hub to %s:%u\n", newIp.c_str(), best->port);
+  hub_ip = newIp;
+  hub_port = best->port;
+  saveConfiguration();
+  hubConfirmedAt = millis();
+  hubSession = ""; // sessions belong to the old hub
+  restartUDP(); // ensure we listen on correct companion port (hub_port+1 still fine)
+  // Immediately try registration with new hub details
+  if (connState == CONN_DISCOVERING) {
+    connStartRegistering();
+  } else {
+    registerWithHub();
+  }
+}
+
+static void startMdnsQuery() {
+  if (gMdnsSearch != nullptr) return;
+  Serial.println("UDP discovery exhausted, querying mDNS for _tallyhub._udp.local");
+  gMdnsSearch = mdns_query_async_new(nullptr, "_tallyhub", "_udp", MDNS_TYPE_PTR, MDNS_QUERY_TIMEOUT_MS, DISCOVERY_MAX_CANDIDATES);
+  if (gMdnsSearch == nullptr) {
+    Serial.println("mDNS: query could not be started");
+    return;
+  }
+  openDiscoveryWindow();
+}
+
+// Once per loop() pass: collect mDNS answers without blocking and close the window when it is due
+void discoveryStep() {
+  if (gMdnsSearch != nullptr) {
+    mdns_result_t *results = nullptr;
+    if (!mdns_query_async_get_results(gMdnsSearch, 0, &results)) {
+      loopWakeIn(50);
+      return;
+    }
+    int found = 0;
+    for (mdns_result_t *r = results; r != nullptr; r = r->next) {
+      for (mdns_ip_addr_t *a = r->addr; a != nullptr; a = a->next) {
+        if (a->addr.type != ESP_IPADDR_TYPE_V4) continue;
+        addHubCandidate(a->addr.u_addr.ip4.addr, r->port, DISCOVERY_NO_RTT);
+        found++;
+      }
+    }
+    Serial.printf("mDNS: %d tallyhub service address(es)\n", found);
+    if (results != nullptr) mdns_query_results_free(results);
+    mdns_query_async_delete(gMdnsSearch);
+    gMdnsSearch = nullptr;
+  }
+  if (!gDiscoveryWindowOpen) return;
+  if ((long)(millis() - gDiscoveryWindowEnd) >= 0) {
+    closeDiscoveryWindow();
+  } else {
+    loopWakeAt(gDiscoveryWindowEnd);
+  }
+}
 
 bool performDiscoveryExchange() {
   if (WiFi.status() != WL_CONNECTED) return false;
@@ -3429,57 +5292,40 @@ bool performDiscoveryExchange() {
   doc["type"] = "discover";
   doc["deviceId"] = device_id;
   doc["fw"] = FIRMWARE_VERSION;
+  doc["t"] = (uint32_t)millis(); // echoed in discover_reply for the RTT ranking
   String payload; serializeJson(doc, payload);
   bool ok = false;
+  gDiscoveryProbeAt = millis();
+  openDiscoveryWindow();
   // Send to broadcast
-  udp.beginPacket(bcast, hub_port); udp.print(payload); ok = udp.endPacket()==1 || ok;
+  ok = udpSendTo(bcast, hub_port, (const uint8_t*)payload.c_str(), payload.length()) || ok;
   // Also send to last known hub (in case subnet broadcast blocked but we have stale IP)
-  if (hub_ip.length()>0) { udp.beginPacket(hub_ip.c_str(), hub_port); udp.print(payload); ok = udp.endPacket()==1 || ok; }
+  if (hub_ip.length()>0) { ok = sendToHub(payload) || ok; }
   Serial.printf("Discovery probe sent (broadcast=%s, hub=%s)\n", bcast.toString().c_str(), hub_ip.c_str());
   return ok;
 }
 
-void attemptHubDiscovery(bool force) {
-  if (!auto_discovery_enabled) return;
+// Returns false when no probe went out (disabled, budget spent or too soon)
+bool attemptHubDiscovery(bool force) {
+  if (!auto_discovery_enabled) return false;
   unsigned long now = millis();
   if (!force) {
-    if (gDiscoveryAttempts >= DISCOVERY_MAX_ATTEMPTS) return; // limit per Wi-Fi session
-    if (now - gLastDiscoveryAttempt < DISCOVERY_INTERVAL_MS) return; // wait interval
+    if (gDiscoveryAttempts >= DISCOVERY_MAX_ATTEMPTS) return false; // limit per Wi-Fi session
+    if (now - gLastDiscoveryAttempt < DISCOVERY_INTERVAL_MS) return false; // wait interval
   }
   gLastDiscoveryAttempt = now;
   gDiscoveryAttempts++;
-  bool sent = performDiscoveryExchange();
-  // After final scheduled UDP attempt, try mDNS if hub still not found
-  if (gDiscoveryAttempts == DISCOVERY_MAX_ATTEMPTS) {
-    if (hub_ip.length() == 0) {
-      Serial.println("UDP discovery exhausted, trying mDNS query for _tallyhub._udp.local");
-      if (attemptMdnsLookup()) {
-        saveConfiguration();
-        restartUDP();
-        registerWithHub();
-      }
-    }
+  performDiscoveryExchange();
+  // After final scheduled UDP attempt, also ask mDNS if we still have no working hub (answers arrive in discoveryStep)
+  if (gDiscoveryAttempts == DISCOVERY_MAX_ATTEMPTS && (hub_ip.length() == 0 || !isRegisteredWithHub)) {
+    startMdnsQuery();
   }
+  return true;
 }
 
-bool attemptMdnsLookup() {
-  int n = MDNS.queryService("tallyhub","udp");
-  if (n <= 0) {
-    Serial.println("mDNS: no tallyhub services found");
-    return false;
-  }
-  // Pick first result; future: prefer same subnet or highest priority
-  String foundHost = MDNS.hostname(0);
-  IPAddress addr = MDNS.IP(0);
-  uint16_t port = MDNS.port(0);
-  if (addr.toString() == hub_ip && port == hub_port) {
-    Serial.println("mDNS: hub already set, ignoring");
-    return true;
-  }
-  hub_ip = addr.toString();
-  hub_port = port; // UDP port published is our hub UDP port
-  Serial.printf("mDNS: discovered hub at %s:%d (host=%s)\n", hub_ip.c_str(), hub_port, foundHost.c_str());
-  return true;
+void resetHubDiscovery() {
+  gDiscoveryAttempts = 0;
+  gLastDiscoveryAttempt = millis() - DISCOVERY_INTERVAL_MS; // first probe may go out straight away
 }
 
 // Network Selection Functions
@@ -3544,27 +5390,10 @@ void connectToSelectedNetwork() {
   
   Serial.printf("Connecting to selected network: %s (index %d)\n", ssid.c_str(), selectedNetworkIndex);
   
-  // Disconnect current connection
-  WiFi.disconnect();
-  delay(100);
-  
-  // Connect to selected network
-  WiFi.begin(ssid.c_str(), password.c_str());
+  // Drop the current network and join the selected one in the background; the connection manager
+  // re-registers once it associates, or goes back to the saved networks if it does not
+  connJoinNetwork(ssid, password);
   showStatus("Connecting...", BLUE);
-  
-  // Wait for connection with timeout
-  unsigned long connectStart = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - connectStart < 10000) {
-    delay(100);
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("Connected to %s\n", ssid.c_str());
-    showStatus("Connected!", GREEN);
-  } else {
-    Serial.printf("Failed to connect to %s\n", ssid.c_str());
-    showStatus("Connect Failed", RED);
-  }
 }
 
 void showNetworkSelectionUI() {
@@ -3572,35 +5401,37 @@ void showNetworkSelectionUI() {
   
   String ssid = preferences.getString(("ssid" + String(selectedNetworkIndex)).c_str(), "");
   
-  M5.Lcd.fillScreen(0x4208); // Dark blue background
-  M5.Lcd.setTextColor(WHITE);
-  M5.Lcd.setTextSize(1);
+  frameDirty(0, 0, gDraw->width(), gDraw->height());
+  gDraw->fillScreen(0x4208); // Dark blue background
+  gDraw->setTextColor(WHITE);
+  gDraw->setTextSize(1);
   
   // Title
-  M5.Lcd.setCursor(10, 10);
-  M5.Lcd.print("SELECT NETWORK");
+  gDraw->setCursor(10, 10);
+  gDraw->print("SELECT NETWORK");
   
   // Network index indicator
-  M5.Lcd.setCursor(10, 25);
-  M5.Lcd.printf("Network %d of 5", selectedNetworkIndex + 1);
+  gDraw->setCursor(10, 25);
+  gDraw->printf("Network %d of 5", selectedNetworkIndex + 1);
   
   // Current network name (truncated if too long)
-  M5.Lcd.setCursor(10, 45);
-  M5.Lcd.setTextSize(2);
+  gDraw->setCursor(10, 45);
+  gDraw->setTextSize(2);
   String displaySSID = ssid;
   if (displaySSID.length() > 10) {
     displaySSID = displaySSID.substring(0, 10) + "...";
   }
-  M5.Lcd.print(displaySSID);
+  gDraw->print(displaySSID);
   
   // Instructions
-  M5.Lcd.setTextSize(1);
-  M5.Lcd.setCursor(10, 70);
-  M5.Lcd.print("A+B: Activate mode");
-  M5.Lcd.setCursor(10, 80);
-  M5.Lcd.print("B: Next, B(2x): Connect");
-  M5.Lcd.setCursor(10, 90);
-  M5.Lcd.print("A: Cancel");
+  gDraw->setTextSize(1);
+  gDraw->setCursor(10, 70);
+  gDraw->print("A+B: Activate mode");
+  gDraw->setCursor(10, 80);
+  gDraw->print("B: Next, B(2x): Connect");
+  gDraw->setCursor(10, 90);
+  gDraw->print("A: Cancel");
+  flushFrame();
 }
 
 void exitNetworkSelectionMode() {
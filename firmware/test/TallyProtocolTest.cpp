@@ -0,0 +1,445 @@
+// Host-side checks and timings for TallyProtocol.h, which is Arduino-free so it builds with any C++11
+// compiler. The golden frames were produced by encodeTallyFrame()/encodeSnapshotFrame() in
+// src/core/TallyProtocol.ts, so a layout change on either side fails here.
+//
+//   make -C firmware/test          # run the checks
+//   make -C firmware/test bench    # time the hot paths of the net task
+//
+// The bench also times ArduinoJson baselines when the library is on the include path (ARDUINOJSON_DIR;
+// the Makefile picks up the copy PlatformIO fetched into .pio/libdeps).
+
+#include "TallyProtocol.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef TALLY_TEST_ARDUINOJSON
+#include <ArduinoJson.h>
+#include <cstdlib>
+#include "NetJsonArena.h"
+#endif
+
+static int gFailures = 0;
+static int gChecks = 0;
+
+#define CHECK(cond)                                                         \
+  do {                                                                      \
+    gChecks++;                                                              \
+    if (!(cond)) {                                                          \
+      gFailures++;                                                          \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    }                                                                       \
+  } while (0)
+
+// encodeTallyFrame({ seq: 7, sourceHash: fnv1a64('obs-scene-Cam 1'), program, recording, name: 'Cam 1' })
+static const uint8_t kHubTally[] = {
+  0xa7, 0x11, 0x05, 0x05, 0x07, 0x00, 0x00, 0x00, 0xf1, 0xf8, 0x8c, 0x8b, 0x1b, 0x84, 0x8c, 0x0f,
+  0x43, 0x61, 0x6d, 0x20, 0x31
+};
+
+// encodeSnapshotFrame({ seq: 0x01020304, tableEpoch: 3, programSlot: 2, name: 'Wide', multicast: true }) over
+// nine slots: 1 preview, 2 program + recording, 8 streaming
+static const uint8_t kHubSnapshot[] = {
+  0xa7, 0x12, 0x01, 0x04, 0x04, 0x03, 0x02, 0x01, 0x03, 0x00, 0x09, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x02, 0x00, 0x04, 0x00, 0x00, 0x01, 0x57, 0x69, 0x64, 0x65
+};
+
+static void putU16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// The hub's encoders, for frames the golden vectors do not cover
+static std::vector<uint8_t> encodeTally(uint32_t seq, uint8_t flags, const char *id, const char *name) {
+  size_t nameLen = strlen(name);
+  std::vector<uint8_t> buf(TALLY_FRAME_HEADER_LEN + nameLen);
+  buf[0] = TALLY_FRAME_MAGIC;
+  buf[1] = TALLY_FRAME_VERSION << 4 | TALLY_KIND_TALLY;
+  buf[2] = flags;
+  buf[3] = (uint8_t)nameLen;
+  putU32(&buf[4], seq);
+  uint64_t hash = tallyHashSource(id);
+  putU32(&buf[8], (uint32_t)hash);
+  putU32(&buf[12], (uint32_t)(hash >> 32));
+  memcpy(&buf[16], name, nameLen);
+  return buf;
+}
+
+// onSlots are set in the program plane; the other planes stay clear
+static std::vector<uint8_t> encodeSnapshot(uint32_t seq, uint16_t slotCount, uint16_t programSlot,
+                                           const std::vector<uint8_t> &onSlots, const char *name) {
+  size_t planeBytes = tallyBitmapBytes(slotCount);
+  size_t nameLen = strlen(name);
+  std::vector<uint8_t> buf(TALLY_FRAME_HEADER_LEN + planeBytes * TALLY_PLANE_COUNT + nameLen);
+  buf[0] = TALLY_FRAME_MAGIC;
+  buf[1] = TALLY_FRAME_VERSION << 4 | TALLY_KIND_SNAPSHOT;
+  buf[3] = (uint8_t)nameLen;
+  putU32(&buf[4], seq);
+  putU16(&buf[10], slotCount);
+  putU16(&buf[12], programSlot);
+  for (uint8_t slot : onSlots) buf[TALLY_FRAME_HEADER_LEN + (slot >> 3)] |= 1 << (slot & 7);
+  memcpy(&buf[TALLY_FRAME_HEADER_LEN + planeBytes * TALLY_PLANE_COUNT], name, nameLen);
+  return buf;
+}
+
+static void testHash() {
+  CHECK(tallyHashSource("") == 0xcbf29ce484222325ULL);
+  CHECK(tallyHashSource("a") == 0xaf63dc4c8601ec8cULL);
+  CHECK(tallyHashSource("obs-scene-Cam 1") == 0x0f8c841b8b8cf8f1ULL); // fnv1a64() on the hub
+}
+
+static void testDecodeTally() {
+  TallyFrame f = {};
+  CHECK(tallyIsBinaryFrame(kHubTally, sizeof(kHubTally)));
+  CHECK(tallyDecodeFrame(kHubTally, sizeof(kHubTally), f));
+  CHECK(f.kind == TALLY_KIND_TALLY);
+  CHECK(f.seq == 7);
+  CHECK(f.flags == (TALLY_FLAG_PROGRAM | TALLY_FLAG_RECORDING));
+  CHECK(f.sourceHash == tallyHashSource("obs-scene-Cam 1"));
+  CHECK(f.nameLen == 5 && memcmp(f.name, "Cam 1", 5) == 0);
+  CHECK(!tallyFrameIsMulticast(kHubTally, sizeof(kHubTally)));
+
+  std::vector<uint8_t> own = encodeTally(7, TALLY_FLAG_PROGRAM | TALLY_FLAG_RECORDING, "obs-scene-Cam 1", "Cam 1");
+  CHECK(own.size() == sizeof(kHubTally) && memcmp(own.data(), kHubTally, own.size()) == 0);
+
+  // Every truncation is rejected, as are foreign magic, version, kind and an oversize name
+  for (size_t len = 0; len < sizeof(kHubTally); len++) CHECK(!tallyDecodeFrame(kHubTally, len, f));
+  uint8_t bad[sizeof(kHubTally)];
+  memcpy(bad, kHubTally, sizeof(bad));
+  bad[0] = '{';
+  CHECK(!tallyIsBinaryFrame(bad, sizeof(bad)) && !tallyDecodeFrame(bad, sizeof(bad), f));
+  memcpy(bad, kHubTally, sizeof(bad));
+  bad[1] = (TALLY_FRAME_VERSION + 1) << 4 | TALLY_KIND_TALLY;
+  CHECK(!tallyDecodeFrame(bad, sizeof(bad), f));
+  memcpy(bad, kHubTally, sizeof(bad));
+  bad[1] = TALLY_FRAME_VERSION << 4 | 3;
+  CHECK(!tallyDecodeFrame(bad, sizeof(bad), f));
+  memcpy(bad, kHubTally, sizeof(bad));
+  bad[3] = TALLY_FRAME_MAX_NAME + 1;
+  CHECK(!tallyDecodeFrame(bad, sizeof(bad), f));
+}
+
+static void testDecodeSnapshot() {
+  TallyFrame f = {};
+  CHECK(tallyDecodeFrame(kHubSnapshot, sizeof(kHubSnapshot), f));
+  CHECK(f.kind == TALLY_KIND_SNAPSHOT);
+  CHECK(f.seq == 0x01020304);
+  CHECK(f.tableEpoch == 3 && f.slotCount == 9 && f.programSlot == 2);
+  CHECK(f.nameLen == 4 && memcmp(f.name, "Wide", 4) == 0);
+  CHECK(tallyFrameIsMulticast(kHubSnapshot, sizeof(kHubSnapshot)));
+
+  CHECK(tallySnapshotBit(f, TALLY_PLANE_PROGRAM, 2));
+  CHECK(tallySnapshotBit(f, TALLY_PLANE_RECORDING, 2));
+  CHECK(!tallySnapshotBit(f, TALLY_PLANE_PREVIEW, 2));
+  CHECK(tallySnapshotBit(f, TALLY_PLANE_PREVIEW, 1));
+  CHECK(tallySnapshotBit(f, TALLY_PLANE_STREAMING, 8)); // second bitmap byte
+  int on = 0;
+  for (int plane = 0; plane < TALLY_PLANE_COUNT; plane++) {
+    for (uint16_t slot = 0; slot < 16; slot++) on += tallySnapshotBit(f, (TallySnapshotPlane)plane, slot);
+  }
+  CHECK(on == 4); // slots past the count read as off
+  for (size_t len = 0; len < sizeof(kHubSnapshot); len++) CHECK(!tallyDecodeFrame(kHubSnapshot, len, f));
+
+  // The largest table still fits one datagram with a full name
+  std::vector<uint8_t> onSlots;
+  for (int slot = 0; slot < 256; slot += 51) onSlots.push_back((uint8_t)slot);
+  std::vector<uint8_t> big = encodeSnapshot(9, TALLY_SNAPSHOT_MAX_SLOTS, 51, onSlots, "Program");
+  CHECK(big.size() + TALLY_FRAME_MAX_NAME <= TALLY_MAX_DATAGRAM);
+  CHECK(tallyDecodeFrame(big.data(), big.size(), f));
+  CHECK(f.slotCount == TALLY_SNAPSHOT_MAX_SLOTS && tallySnapshotBit(f, TALLY_PLANE_PROGRAM, 51));
+  CHECK(!tallySnapshotBit(f, TALLY_PLANE_PROGRAM, 52));
+  putU16(&big[10], TALLY_SNAPSHOT_MAX_SLOTS + 1);
+  CHECK(!tallyDecodeFrame(big.data(), big.size(), f));
+}
+
+static void testNegotiated() {
+  CHECK(tallyFrameNegotiated(kHubTally, sizeof(kHubTally), 0));
+  CHECK(tallyFrameNegotiated(kHubTally, sizeof(kHubTally), TALLY_CAP_BINARY));
+  CHECK(!tallyFrameNegotiated(kHubTally, sizeof(kHubTally), TALLY_CAP_JSON_TALLY));
+  CHECK(tallyFrameNegotiated(kHubSnapshot, sizeof(kHubSnapshot), TALLY_CAP_BINARY | TALLY_CAP_SNAPSHOT));
+  CHECK(!tallyFrameNegotiated(kHubSnapshot, sizeof(kHubSnapshot), TALLY_CAP_BINARY));
+}
+
+static void testCheckSeq() {
+  uint32_t gap;
+  CHECK(tallyCheckSeq(0, 5, gap) == TALLY_SEQ_APPLY && gap == 0);   // nothing applied yet
+  CHECK(tallyCheckSeq(5, 0, gap) == TALLY_SEQ_APPLY);                // unsequenced hub
+  CHECK(tallyCheckSeq(5, 6, gap) == TALLY_SEQ_APPLY && gap == 0);
+  CHECK(tallyCheckSeq(5, 9, gap) == TALLY_SEQ_APPLY && gap == 3);
+  CHECK(tallyCheckSeq(5, 5, gap) == TALLY_SEQ_DUPLICATE);
+  CHECK(tallyCheckSeq(5, 4, gap) == TALLY_SEQ_STALE);
+  CHECK(tallyCheckSeq(2000, 2000 - TALLY_SEQ_RESYNC_WINDOW, gap) == TALLY_SEQ_STALE);
+  CHECK(tallyCheckSeq(2000, 2000 - TALLY_SEQ_RESYNC_WINDOW - 1, gap) == TALLY_SEQ_RESYNC); // hub restarted
+  CHECK(tallyCheckSeq(0xfffffffeu, 1, gap) == TALLY_SEQ_APPLY && gap == 2); // wraps past 0
+  CHECK(tallyCheckSeq(1, 0xfffffffeu, gap) == TALLY_SEQ_STALE);
+}
+
+static void testDedup() {
+  TallyDedupCache cache = {};
+  uint64_t key = tallyHashSource("obs-scene-Cam 1");
+  uint32_t hash = tallyPayloadHash(kHubTally, sizeof(kHubTally));
+  CHECK(hash == tallyPayloadHash(kHubTally, sizeof(kHubTally)));
+  CHECK(!tallyDedupHit(cache, key, hash, sizeof(kHubTally)));
+  tallyDedupStore(cache, key, hash, sizeof(kHubTally));
+  CHECK(tallyDedupHit(cache, key, hash, sizeof(kHubTally)));
+
+  uint8_t changed[sizeof(kHubTally)];
+  memcpy(changed, kHubTally, sizeof(changed));
+  changed[2] ^= TALLY_FLAG_PREVIEW;
+  CHECK(!tallyDedupHit(cache, key, tallyPayloadHash(changed, sizeof(changed)), sizeof(changed)));
+  CHECK(!tallyDedupHit(cache, TALLY_DEDUP_SNAPSHOT_KEY, hash, sizeof(kHubTally)));
+
+  // A snapshot's unicast and multicast copies differ in one flag and must not evict each other
+  uint8_t unicast[sizeof(kHubSnapshot)];
+  memcpy(unicast, kHubSnapshot, sizeof(unicast));
+  unicast[2] &= (uint8_t)~TALLY_SNAPSHOT_FLAG_MULTICAST;
+  uint64_t groupKey = tallyDedupSnapshotKey(kHubSnapshot[2]);
+  uint64_t unicastKey = tallyDedupSnapshotKey(unicast[2]);
+  CHECK(groupKey != unicastKey && tallyDedupSlot(groupKey) != tallyDedupSlot(unicastKey));
+  uint32_t groupHash = tallyPayloadHash(kHubSnapshot, sizeof(kHubSnapshot));
+  uint32_t unicastHash = tallyPayloadHash(unicast, sizeof(unicast));
+  tallyDedupStore(cache, groupKey, groupHash, sizeof(kHubSnapshot));
+  tallyDedupStore(cache, unicastKey, unicastHash, sizeof(unicast));
+  CHECK(tallyDedupHit(cache, groupKey, groupHash, sizeof(kHubSnapshot)));
+  CHECK(tallyDedupHit(cache, unicastKey, unicastHash, sizeof(unicast)));
+  // Every tail length of the xxHash32 loop reaches the hash
+  for (size_t len = 1; len < sizeof(kHubSnapshot); len++) {
+    CHECK(tallyPayloadHash(kHubSnapshot, len) != tallyPayloadHash(kHubSnapshot, len - 1));
+  }
+}
+
+static void testJsonScan() {
+  const char *tally = "{\"type\":\"tally\",\"data\":{\"id\":\"obs-scene-Cam 1\",\"name\":\"Cam 1\",\"preview\":false,"
+                      "\"program\":true,\"seq\":12},\"epoch\":1792051200}";
+  TallyJsonScan scan;
+  CHECK(tallyScanJson(tally, strlen(tally), scan));
+  CHECK(hubMessageType(scan.type, scan.typeLen) == HUB_MSG_TALLY);
+  CHECK(scan.id != nullptr && scan.idLen == 15 && memcmp(scan.id, "obs-scene-Cam 1", 15) == 0);
+  CHECK(scan.hasProgram && scan.program);
+
+  const char *escaped = "{\"type\": \"tally\", \"data\": {\"id\": \"cam\\\"1\", \"program\": false}}";
+  CHECK(tallyScanJson(escaped, strlen(escaped), scan));
+  CHECK(scan.id == nullptr && scan.hasProgram && !scan.program);
+
+  const char *ack = "{\"type\":\"heartbeat_ack\",\"t\":123456,\"epoch\":0}";
+  CHECK(tallyScanJson(ack, strlen(ack), scan));
+  CHECK(hubMessageType(scan.type, scan.typeLen) == HUB_MSG_HEARTBEAT_ACK && scan.id == nullptr);
+  CHECK(!tallyScanJson("{\"data\":{}}", 11, scan));
+
+  // Keys are matched per level: nested and quoted "type"/"id" ahead of the real ones are skipped
+  const char *nested = "{\"meta\":{\"type\":\"heartbeat_ack\",\"id\":\"x\"},\"note\":\"\\\"type\\\":\\\"x\",\"list\":[{\"id\":1},\"]\"],"
+                       "\"type\":\"tally\",\"data\":{\"src\":{\"id\":\"obs-scene-Cam 2\",\"program\":true},"
+                       "\"id\":\"obs-scene-Cam 1\", \"program\" : false}}";
+  CHECK(tallyScanJson(nested, strlen(nested), scan));
+  CHECK(hubMessageType(scan.type, scan.typeLen) == HUB_MSG_TALLY);
+  CHECK(scan.id != nullptr && scan.idLen == 15 && memcmp(scan.id, "obs-scene-Cam 1", 15) == 0);
+  CHECK(scan.hasProgram && !scan.program);
+  const char *onlyNested = "{\"type\":\"tally\",\"data\":{\"src\":{\"id\":\"obs-scene-Cam 2\"}}}";
+  CHECK(tallyScanJson(onlyNested, strlen(onlyNested), scan) && scan.id == nullptr && !scan.hasProgram);
+  const char *typeInData = "{\"data\":{\"type\":\"tally\"}}";
+  CHECK(!tallyScanJson(typeInData, strlen(typeInData), scan));
+  const char *cut = "{\"type\":\"tally\",\"data\":{\"id\":\"obs-sc";
+  CHECK(tallyScanJson(cut, strlen(cut), scan) && scan.id == nullptr);
+
+  CHECK(hubMessageType("registered") == HUB_MSG_REGISTERED);
+  CHECK(hubMessageType("sync_done") == HUB_MSG_SYNC_DONE);
+  CHECK(hubMessageType("tallyx") == HUB_MSG_UNKNOWN);
+  CHECK(hubMessageType("tally", 4) == HUB_MSG_UNKNOWN);
+  CHECK(hubMessageType(nullptr) == HUB_MSG_UNKNOWN);
+}
+
+static void testBackoffAndRtt() {
+  const uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x01, 0x02, 0x03 };
+  uint32_t rng = tallyBackoffSeed(mac);
+  for (uint32_t attempt = 0; attempt < 20; attempt++) {
+    uint32_t e = attempt >= 16 ? TALLY_BACKOFF_CAP_MS : TALLY_BACKOFF_BASE_MS << attempt;
+    if (e > TALLY_BACKOFF_CAP_MS) e = TALLY_BACKOFF_CAP_MS;
+    uint32_t wait = tallyBackoffMs(attempt, rng);
+    CHECK(wait >= e / 2 && wait <= e);
+  }
+
+  TallyRtt rtt = {};
+  CHECK(tallyRto(rtt) == TALLY_RTO_INITIAL_MS);
+  tallyRttSample(rtt, 40);
+  CHECK(rtt.srtt == 40 && rtt.rttvar == 20 && tallyRto(rtt) == TALLY_RTO_MIN_MS);
+  for (int i = 0; i < 50; i++) tallyRttSample(rtt, 5000);
+  CHECK(tallyRto(rtt) == TALLY_RTO_MAX_MS);
+}
+
+// ---- Timing loop ----
+
+template <typename F> static double bench(const char *name, int iterations, F &&body) {
+  volatile uint32_t sink = 0;
+  for (int i = 0; i < iterations / 10; i++) sink = sink + body(i); // warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) sink = sink + body(i);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-28s %9.1f ns/op\n", name, ns / iterations);
+  (void)sink;
+  return ns / iterations;
+}
+
+#ifdef TALLY_TEST_ARDUINOJSON
+// Heap behind a plain JsonDocument, counting every request ArduinoJson makes of it
+struct CountingAllocator : ArduinoJson::Allocator {
+  uint64_t allocs = 0;
+  void *allocate(size_t size) override { allocs++; return malloc(size); }
+  void deallocate(void *p) override { free(p); }
+  void *reallocate(void *p, size_t size) override { allocs++; return realloc(p, size); }
+};
+
+// Same fields as tallyFields() in main.cpp, plus the "type" every handler filter keeps
+static void tallyFilter(JsonDocument &f) {
+  f["type"] = true;
+  JsonObject data = f["data"].to<JsonObject>();
+  data["id"] = true;
+  data["name"] = true;
+  data["program"] = true;
+  data["preview"] = true;
+  data["recording"] = true;
+  data["streaming"] = true;
+  data["seq"] = true;
+}
+
+static void compare(const char *what, double fast, double baseline) {
+  std::printf("  %-26s %9.1f vs %.1f ns/op (%.1fx)\n", what, fast, baseline, baseline / fast);
+}
+#endif
+
+static void runBench() {
+  const int n = 2000000;
+  std::vector<uint8_t> onSlots;
+  for (int slot = 0; slot < 256; slot += 7) onSlots.push_back((uint8_t)slot);
+  std::vector<uint8_t> big = encodeSnapshot(9, TALLY_SNAPSHOT_MAX_SLOTS, 7, onSlots, "Program");
+  const char *json = "{\"type\":\"tally\",\"data\":{\"id\":\"obs-scene-Cam 1\",\"name\":\"Cam 1\",\"preview\":false,"
+                     "\"program\":true,\"recording\":false,\"streaming\":false,\"seq\":12},\"epoch\":1792051200}";
+  size_t jsonLen = strlen(json);
+  // Read through volatile pointers so the compiler cannot hoist work on constant inputs out of the loop
+  const uint8_t *volatile tally = kHubTally;
+  const uint8_t *volatile snapshot = big.data();
+  const char *volatile id = "obs-scene-Cam 1";
+  const char *volatile text = json;
+
+  double binaryNs = bench("tallyDecodeFrame tally", n, [&](int) {
+    TallyFrame f = {};
+    return (uint32_t)tallyDecodeFrame(tally, sizeof(kHubTally), f) + f.seq;
+  });
+  bench("tallyDecodeFrame snapshot512", n, [&](int i) {
+    TallyFrame f = {};
+    tallyDecodeFrame(snapshot, big.size(), f);
+    return (uint32_t)tallySnapshotBit(f, TALLY_PLANE_PROGRAM, (uint16_t)(i & 511));
+  });
+  bench("tallyCheckSeq", n, [&](int i) {
+    uint32_t gap;
+    return (uint32_t)tallyCheckSeq((uint32_t)i, (uint32_t)i + (i & 3), gap) + gap;
+  });
+  bench("tallyPayloadHash tally", n, [&](int) { return tallyPayloadHash(tally, sizeof(kHubTally)); });
+  bench("tallyPayloadHash snapshot512", n, [&](int) { return tallyPayloadHash(snapshot, big.size()); });
+  bench("tallyHashSource", n, [&](int) { return (uint32_t)tallyHashSource(id); });
+  bench("tallyScanJson tally", n, [&](int) {
+    TallyJsonScan scan;
+    return (uint32_t)tallyScanJson(text, jsonLen, scan) + (uint32_t)scan.idLen;
+  });
+  bench("hubMessageType", n, [&](int i) { return (uint32_t)hubMessageType((i & 1) ? "heartbeat_ack" : "tally"); });
+
+#ifdef TALLY_TEST_ARDUINOJSON
+  // The JSON path binary frames replace: a JsonDocument per datagram, then the fields the tally handler reads
+  double jsonNs = bench("deserializeJson tally", n / 10, [&](int) -> uint32_t {
+    JsonDocument doc;
+    const char *in = text;
+    if (deserializeJson(doc, in, jsonLen)) return 0u;
+    JsonObjectConst data = doc["data"];
+    const char *sourceId = data["id"] | "";
+    return (uint32_t)strlen(sourceId) + (uint32_t)(data["program"] | false) + (data["seq"] | 0u);
+  });
+  std::printf("\n");
+  compare("binary vs JSON tally", binaryNs, jsonNs);
+
+  // Heap allocations per tally message: a JsonDocument per datagram (before the dispatcher) vs the
+  // net task's filtered parse into NetJsonArena, which only touches the heap when the arena overflows
+  const int messages = 10000;
+  CountingAllocator heap;
+  for (int i = 0; i < messages; i++) {
+    JsonDocument doc(&heap);
+    deserializeJson(doc, json, jsonLen);
+  }
+  static NetJsonArena arena;
+  JsonDocument filter;
+  tallyFilter(filter);
+  {
+    JsonDocument doc(&arena);
+    for (int i = 0; i < messages; i++) {
+      doc.clear();
+      arena.reset();
+      deserializeJson(doc, json, jsonLen, DeserializationOption::Filter(filter));
+    }
+  }
+  std::printf("\nheap allocations per tally message\n");
+  std::printf("  %-26s %9.2f\n", "JsonDocument", (double)heap.allocs / messages);
+  std::printf("  %-26s %9.2f (arena high water %u of %u B)\n", "NetJsonArena + filter",
+              (double)arena.heapAllocs() / messages, (unsigned)arena.highWater(), (unsigned)NET_JSON_ARENA_SIZE);
+#else
+  (void)binaryNs;
+  std::printf("\n(ArduinoJson not found: set ARDUINOJSON_DIR for the deserializeJson baselines)\n");
+#endif
+
+  // Rejecting another source's tally (not in program, so the M5 does not want it either): the raw
+  // pre-scan plus hash compare the net task runs first, vs parsing the datagram and then comparing the id
+  const char *other = "{\"type\":\"tally\",\"data\":{\"id\":\"obs-scene-Cam 2\",\"name\":\"Cam 2\",\"preview\":true,"
+                      "\"program\":false,\"recording\":false,\"streaming\":false,\"seq\":13},\"epoch\":1792051200}";
+  size_t otherLen = strlen(other);
+  const char *volatile otherText = other;
+  const uint64_t assigned = tallyHashSource("obs-scene-Cam 1");
+  std::printf("\n");
+  double scanRejectNs = bench("reject: tallyScanJson", n, [&](int) -> uint32_t {
+    TallyJsonScan scan;
+    if (!tallyScanJson(otherText, otherLen, scan) || scan.id == nullptr) return 0;
+    return scan.program || tallyHashSource(scan.id, scan.idLen) == assigned;
+  });
+#ifdef TALLY_TEST_ARDUINOJSON
+  double parseRejectNs = bench("reject: deserializeJson", n / 10, [&](int) -> uint32_t {
+    JsonDocument doc;
+    const char *in = otherText;
+    if (deserializeJson(doc, in, otherLen)) return 0;
+    JsonObjectConst data = doc["data"];
+    return (data["program"] | false) || tallyHashSource(data["id"] | "") == assigned;
+  });
+  JsonDocument arenaDoc(&arena);
+  double filteredRejectNs = bench("reject: filtered arena parse", n / 10, [&](int) -> uint32_t {
+    arenaDoc.clear();
+    arena.reset();
+    const char *in = otherText;
+    if (deserializeJson(arenaDoc, in, otherLen, DeserializationOption::Filter(filter))) return 0;
+    JsonObjectConst data = arenaDoc["data"];
+    return (data["program"] | false) || tallyHashSource(data["id"] | "") == assigned;
+  });
+  std::printf("\n");
+  compare("reject vs full parse", scanRejectNs, parseRejectNs);
+  compare("reject vs filtered parse", scanRejectNs, filteredRejectNs);
+#else
+  (void)scanRejectNs;
+#endif
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    runBench();
+    return 0;
+  }
+  testHash();
+  testDecodeTally();
+  testDecodeSnapshot();
+  testNegotiated();
+  testCheckSeq();
+  testDedup();
+  testJsonScan();
+  testBackoffAndRtt();
+  std::printf("%d checks, %d failed\n", gChecks, gFailures);
+  return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+#!/usr/bin/env node
+/**
+ * Simulate a fleet of tally lights re-registering after a hub restart, with the old fixed retry
+ * schedule and with the jittered backoff the firmware uses now (tallyBackoffMs() and the
+ * register_required retryAfter handling in firmware/<board>/src/TallyProtocol.h, mirrored below).
+ * Prints how register datagrams arrive at the hub for each.
+ *
+ * Two scenarios:
+ *   outage   the hub is gone for SIM_OUTAGE_MS; every device notices within SIM_DETECT_SPREAD_MS and retries
+ *   restart  the hub restarts quickly and answers the fleet's next heartbeats with register_required
+ *
+ * Devices powered on together heartbeat in phase, so both start nearly synchronized. The hub side is
+ * modelled as a receive path that takes SIM_HUB_CAPACITY datagrams per 100 ms and drops the rest.
+ *
+ *   node scripts/simulate-register-storm.js
+ *   SIM_DEVICES=500 SIM_OUTAGE_MS=45000 node scripts/simulate-register-storm.js
+ */
+
+const DEVICES = parseInt(process.env.SIM_DEVICES || '200', 10);
+const OUTAGE_MS = parseInt(process.env.SIM_OUTAGE_MS || '20000', 10);
+const DETECT_SPREAD_MS = parseInt(process.env.SIM_DETECT_SPREAD_MS || '1000', 10);
+const HUB_CAPACITY = parseInt(process.env.SIM_HUB_CAPACITY || '10', 10); // per 100 ms
+const REGISTER_RATE = parseInt(process.env.REGISTER_RATE || '20', 10);   // hub's retryAfter pacing
+const HORIZON_MS = 300000;
+
+// Firmware constants
+const REGISTER_TIMEOUT_MS = 3000;
+const HEARTBEAT_INTERVAL_MS = 30000;
+const RTO_MS = 1000;                 // TALLY_RTO_INITIAL_MS
+const LIVENESS_MAX_MISSES = 3;
+const OLD_QUICK_INTERVAL_MS = 15000; // MIN_RECONNECTION_INTERVAL
+const OLD_QUICK_ATTEMPTS = 5;        // MAX_HUB_RECONNECT_ATTEMPTS
+const OLD_SLOW_RETRY_MS = 25000;     // CONN_SLOW_RETRY_MS
+const BACKOFF_BASE_MS = 1000;        // TALLY_BACKOFF_BASE_MS
+const BACKOFF_CAP_MS = 60000;        // TALLY_BACKOFF_CAP_MS
+const RETRY_AFTER_MAX_MS = 120000;   // TALLY_RETRY_AFTER_MAX_MS
+
+// ---- Mirror of TallyProtocol.h ----
+function backoffSeed(mac) {
+  let h = 2166136261;
+  for (const b of mac) h = Math.imul(h ^ b, 16777619) >>> 0;
+  return h !== 0 ? h : 1;
+}
+
+function backoffNext(dev) {
+  let x = dev.rng;
+  x = (x ^ (x << 13)) >>> 0;
+  x = (x ^ (x >>> 17)) >>> 0;
+  x = (x ^ (x << 5)) >>> 0;
+  return (dev.rng = x);
+}
+
+function backoffMs(attempt, dev) {
+  const e = attempt >= 16 ? BACKOFF_CAP_MS : Math.min(BACKOFF_CAP_MS, BACKOFF_BASE_MS * 2 ** attempt);
+  const half = Math.floor(e / 2);
+  return half + (backoffNext(dev) % (half + 1));
+}
+
+// Deterministic pseudo-random numbers for the scenario itself (not the devices)
+let scenarioRng = 0x9e3779b9;
+function scenarioRandom() {
+  scenarioRng = (Math.imul(scenarioRng, 1664525) + 1013904223) >>> 0;
+  return scenarioRng / 0x100000000;
+}
+
+function makeFleet() {
+  const fleet = [];
+  for (let i = 0; i < DEVICES; i++) {
+    // Espressif OUI plus a sequential tail, like a batch of boards from one order
+    const mac = [0x24, 0x0a, 0xc4, (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff];
+    fleet.push({ rng: backoffSeed(mac), detectAt: Math.floor(scenarioRandom() * DETECT_SPREAD_MS) });
+  }
+  return fleet;
+}
+
+/**
+ * Run one policy. Each device is a small state machine: nextAt is when it next sends something and
+ * kind says what. Returns every register datagram's arrival time and whether the hub took it.
+ */
+function run(scenario, policy) {
+  scenarioRng = 0x9e3779b9;
+  const fleet = makeFleet();
+  const hubUpAt = scenario === 'outage' ? OUTAGE_MS : 2000;
+  const buckets = new Map(); // 100 ms bucket -> datagrams taken
+  const arrivals = [];
+  let registerSlotAt = 0;
+  const slotMs = Math.round(1000 / Math.max(1, REGISTER_RATE));
+
+  for (const dev of fleet) {
+    dev.attempts = 0;
+    dev.misses = 0;
+    dev.registeredAt = null;
+    if (scenario === 'outage') {
+      // Liveness has just declared the hub lost
+      dev.kind = 'register';
+      dev.nextAt = policy === 'old' ? dev.detectAt : dev.detectAt + backoffMs(0, dev);
+    } else {
+      // Next heartbeat after the hub came back
+      dev.kind = 'heartbeat';
+      dev.nextAt = hubUpAt + dev.detectAt;
+    }
+  }
+
+  const accept = t => {
+    if (t < hubUpAt) return false;
+    const bucket = Math.floor(t / 100);
+    const used = buckets.get(bucket) || 0;
+    if (used >= HUB_CAPACITY) return false;
+    buckets.set(bucket, used + 1);
+    return true;
+  };
+
+  for (;;) {
+    let dev = null;
+    for (const d of fleet) if (d.registeredAt === null && (dev === null || d.nextAt < dev.nextAt)) dev = d;
+    if (dev === null || dev.nextAt > HORIZON_MS) break;
+    const t = dev.nextAt;
+    const taken = accept(t);
+
+    if (dev.kind === 'heartbeat') {
+      if (!taken) {
+        // Unacked heartbeat: liveness retries after the RTO and declares the hub lost after three
+        if (++dev.misses < LIVENESS_MAX_MISSES) {
+          dev.nextAt = t + RTO_MS;
+        } else {
+          dev.kind = 'register';
+          dev.nextAt = t + RTO_MS + (policy === 'old' ? 0 : backoffMs(0, dev));
+        }
+        continue;
+      }
+      // register_required comes back
+      dev.kind = 'register';
+      if (policy === 'old') {
+        dev.nextAt = t;
+      } else {
+        const now = t;
+        const slot = Math.max(now, registerSlotAt);
+        registerSlotAt = slot + slotMs;
+        const retryAfter = Math.min(slot - now + slotMs, RETRY_AFTER_MAX_MS);
+        dev.nextAt = t + retryAfter + (backoffNext(dev) % (Math.floor(retryAfter / 4) + 1));
+      }
+      continue;
+    }
+
+    arrivals.push({ t, taken });
+    if (taken) {
+      dev.registeredAt = t;
+      continue;
+    }
+    dev.attempts++;
+    if (policy === 'old') {
+      if (scenario === 'restart') {
+        dev.kind = 'heartbeat'; // the old firmware stayed "registered" and waited for the next heartbeat
+        dev.misses = 0;
+        dev.nextAt = t + HEARTBEAT_INTERVAL_MS;
+      } else {
+        dev.nextAt = t + (dev.attempts < OLD_QUICK_ATTEMPTS ? OLD_QUICK_INTERVAL_MS : REGISTER_TIMEOUT_MS + OLD_SLOW_RETRY_MS);
+      }
+    } else {
+      dev.nextAt = t + REGISTER_TIMEOUT_MS + backoffMs(dev.attempts, dev);
+    }
+  }
+  return { hubUpAt, arrivals, fleet };
+}
+
+function percentile(sorted, p) {
+  if (sorted.length === 0) return NaN;
+  return sorted[Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1)];
+}
+
+function report(scenario, policy) {
+  const { hubUpAt, arrivals, fleet } = run(scenario, policy);
+  const done = fleet.filter(d => d.registeredAt !== null).map(d => d.registeredAt - hubUpAt).sort((a, b) => a - b);
+  const dropped = arrivals.filter(a => !a.taken).length;
+  const per100 = new Map();
+  for (const a of arrivals) {
+    if (a.t < hubUpAt) continue;
+    const b = Math.floor(a.t / 100);
+    per100.set(b, (per100.get(b) || 0) + 1);
+  }
+  const peak = Math.max(0, ...per100.values());
+
+  console.log(`\n${scenario} / ${policy === 'old' ? 'fixed schedule (before)' : 'jittered backoff (after)'}`);
+  console.log(`  register datagrams ${arrivals.length}, lost while the hub was down or dropped at the hub ${dropped}`);
+  console.log(`  peak ${peak} per 100 ms (hub takes ${HUB_CAPACITY})`);
+  console.log(`  registered ${done.length}/${fleet.length}; after the hub came back: p50 ${percentile(done, 50)} ms, ` +
+    `p95 ${percentile(done, 95)} ms, last ${percentile(done, 100)} ms`);
+
+  // Arrivals per second after the hub is back, one # per two datagrams; '!' marks seconds over the hub's capacity
+  const perSec = [];
+  for (const a of arrivals) {
+    if (a.t >= hubUpAt) {
+      const s = Math.floor((a.t - hubUpAt) / 1000);
+      perSec[s] = (perSec[s] || 0) + 1;
+    }
+  }
+  let gap = false;
+  for (let s = 0; s < perSec.length; s++) {
+    const n = perSec[s] || 0;
+    if (n === 0) {
+      if (!gap) console.log('     ...');
+      gap = true;
+      continue;
+    }
+    gap = false;
+    console.log(`  ${String(s).padStart(3)}s ${String(n).padStart(4)} ${'#'.repeat(Math.ceil(n / 2))}${n > HUB_CAPACITY * 10 ? ' !' : ''}`);
+  }
+}
+
+console.log(`${DEVICES} devices, outage ${OUTAGE_MS} ms, detection spread ${DETECT_SPREAD_MS} ms, ` +
+  `hub capacity ${HUB_CAPACITY}/100 ms, REGISTER_RATE ${REGISTER_RATE}/s`);
+for (const scenario of ['outage', 'restart']) {
+  report(scenario, 'old');
+  report(scenario, 'new');
+}
@@ -527,7 +527,7 @@ export class TallyHub extends EventEmitter {
   }
 
   // Return the latest global OBS recording/streaming status if any OBS mixer is configured
-  private getObsGlobalStatus(): { recording: boolean; streaming: boolean } | null {
+  public getObsGlobalStatus(): { recording: boolean; streaming: boolean } | null {
     // Only use OBS status if there is an active OBS connection
     const obs = Array.from(this.mixerConnections.values()).find(m => m.type === 'obs' && m.connected);
     if (!obs) return null;
@@ -973,10 +973,7 @@ export class TallyHub extends EventEmitter {
         data: tallyState
       });
     } else if ((device.type === 'm5stick' || device.type === 'ESP32') && this.udpServer) {
-      this.udpServer.sendToDevice(deviceId, {
-        type: 'tally',
-        data: tallyState
-      });
+      this.udpServer.sendToM5Device(deviceId, tallyState); // carries the per-source seq
     } else if (!this.webSocketManager || !this.udpServer) {
       console.log(`⚠️  Managers not ready yet, skipping tally update for ${device.name}`);
     }
@@ -996,10 +993,7 @@ export class TallyHub extends EventEmitter {
           data: tallyState
         });
       } else if ((device.type === 'm5stick' || device.type === 'ESP32') && this.udpServer) {
-        this.udpServer.sendToDevice(deviceId, {
-          type: 'tally',
-          data: tallyState
-        });
+        this.udpServer.sendToM5Device(deviceId, tallyState); // negotiated encoding and per-source seq, or one snapshot
       }
     });
   }
@@ -0,0 +1,215 @@
+/**
+ * Compact binary tally frames shared with the device firmware
+ * (mirrored by firmware/<board>/src/TallyProtocol.h - keep both in sync).
+ *
+ * Every frame starts with the same 16-byte little-endian header:
+ *   0   u8   magic 0xA7 (JSON datagrams always start with '{', so the two never collide)
+ *   1   u8   version << 4 | kind
+ *   2   u8   flags (kind specific)
+ *   3   u8   name length in bytes (<= TALLY_FRAME_MAX_NAME)
+ *   4   u32  sequence number
+ *   8   ...  kind specific
+ *
+ * Kind 1, single source tally:
+ *   2   flags: bit0 program, bit1 preview, bit2 recording, bit3 streaming
+ *   8   u64  FNV-1a 64 hash of the source id (UTF-8)
+ *   16  ...  source name bytes, not NUL terminated
+ *
+ * Kind 2, whole-switcher snapshot (one datagram for every source):
+ *   2   flags: bit0 sent to the multicast group (see TALLY_SNAPSHOT_FLAG_MULTICAST)
+ *   8   u16  slot table epoch (slot numbers are only meaningful within one epoch)
+ *   10  u16  slot count N
+ *   12  u16  slot currently in program (TALLY_NO_SLOT if none)
+ *   14  u16  reserved
+ *   16  ...  four bitmaps of ceil(N / 8) bytes: program, preview, recording, streaming
+ *            (slot s is bit s & 7 of byte s >> 3)
+ *   ..  ...  live program source name bytes
+ *
+ * Sequence numbers are state versions, per source in kind 1 and one stream per hub in
+ * kind 2: they only advance when the state they describe changes, never wrap to 0
+ * (0 means "unsequenced"), and the same state is always resent with the same number,
+ * so devices drop duplicates and late reordered datagrams.
+ *
+ * Devices advertise what they understand with `caps` (TALLY_CAP_*) in their register
+ * message and get back `features` in `registered`: the subset the hub will use, with
+ * the cheapest tally encoding the device takes. Devices that predate `caps` send
+ * `proto: <level>` (PROTO_BINARY_TALLY, PROTO_SNAPSHOT); everything else keeps
+ * receiving the JSON `{type:'tally', data:{...}}` form.
+ */
+
+export const TALLY_FRAME_MAGIC = 0xa7;
+export const TALLY_FRAME_VERSION = 1;
+export const TALLY_FRAME_HEADER_LEN = 16;
+export const TALLY_FRAME_MAX_NAME = 95;
+export const TALLY_SNAPSHOT_MAX_SLOTS = 512;
+export const TALLY_NO_SLOT = 0xffff;
+/** Largest datagram devices accept (TALLY_MAX_DATAGRAM): one unfragmented UDP payload on a 1500-byte MTU */
+export const TALLY_MAX_DATAGRAM = 1472;
+
+export const TallyFrameKind = {
+  Tally: 1,
+  Snapshot: 2
+} as const;
+
+/** Protocol levels a device can advertise with `proto` at registration */
+export const PROTO_BINARY_TALLY = 1;
+export const PROTO_SNAPSHOT = 2;
+
+/** Capability bits for `caps` (register) and `features` (registered), TALLY_CAP_* in firmware */
+export const TALLY_CAP_JSON_TALLY = 1 << 0;
+export const TALLY_CAP_BINARY = 1 << 1;
+export const TALLY_CAP_SNAPSHOT = 1 << 2;
+export const TALLY_CAP_MULTICAST = 1 << 3;
+export const TALLY_CAP_SEQ = 1 << 4;
+/** Device acks applied tally transitions with `tally_ack`; the hub retransmits unacked ones */
+export const TALLY_CAP_TALLY_ACK = 1 << 5;
+/** Device asks for the current state with `sync` after registering; the hub replays it and ends with `sync_done` */
+export const TALLY_CAP_SYNC = 1 << 6;
+
+export const TALLY_FLAG_PROGRAM = 1 << 0;
+export const TALLY_FLAG_PREVIEW = 1 << 1;
+export const TALLY_FLAG_RECORDING = 1 << 2;
+export const TALLY_FLAG_STREAMING = 1 << 3;
+
+/** Snapshot flag: the frame went to the multicast group. Devices use these frames as proof multicast works. */
+export const TALLY_SNAPSHOT_FLAG_MULTICAST = 1 << 0;
+
+export interface TallyBits {
+  program: boolean;
+  preview: boolean;
+  recording: boolean;
+  streaming: boolean;
+}
+
+export interface SnapshotFrame {
+  seq: number;
+  tableEpoch: number;
+  programSlot: number;
+  slots: TallyBits[]; // index = slot number
+  name: string;       // live program source name
+  multicast?: boolean; // sets TALLY_SNAPSHOT_FLAG_MULTICAST
+}
+
+export interface TallyFrame {
+  seq: number;
+  sourceHash: bigint;
+  program: boolean;
+  preview: boolean;
+  recording: boolean;
+  streaming: boolean;
+  name: string;
+}
+
+const FNV64_OFFSET = 0xcbf29ce484222325n;
+const FNV64_PRIME = 0x100000001b3n;
+const U64_MASK = 0xffffffffffffffffn;
+
+/** FNV-1a 64 over the UTF-8 bytes of `value` (matches tallyHashSource() in firmware). */
+export function fnv1a64(value: string): bigint {
+  let hash = FNV64_OFFSET;
+  for (const byte of Buffer.from(value, 'utf8')) {
+    hash ^= BigInt(byte);
+    hash = (hash * FNV64_PRIME) & U64_MASK;
+  }
+  return hash;
+}
+
+/** Truncate UTF-8 bytes to `max` without splitting a multi-byte sequence. */
+function truncateUtf8(bytes: Buffer, max: number): Buffer {
+  if (bytes.length <= max) return bytes;
+  let end = max;
+  while (end > 0 && (bytes[end] & 0xc0) === 0x80) end--;
+  return bytes.subarray(0, end);
+}
+
+export function isBinaryFrame(buf: Buffer): boolean {
+  return buf.length > 0 && buf[0] === TALLY_FRAME_MAGIC;
+}
+
+export function encodeTallyFrame(frame: TallyFrame): Buffer {
+  const name = truncateUtf8(Buffer.from(frame.name, 'utf8'), TALLY_FRAME_MAX_NAME);
+  const buf = Buffer.alloc(TALLY_FRAME_HEADER_LEN + name.length);
+  let flags = 0;
+  if (frame.program) flags |= TALLY_FLAG_PROGRAM;
+  if (frame.preview) flags |= TALLY_FLAG_PREVIEW;
+  if (frame.recording) flags |= TALLY_FLAG_RECORDING;
+  if (frame.streaming) flags |= TALLY_FLAG_STREAMING;
+  buf[0] = TALLY_FRAME_MAGIC;
+  buf[1] = (TALLY_FRAME_VERSION << 4) | TallyFrameKind.Tally;
+  buf[2] = flags;
+  buf[3] = name.length;
+  buf.writeUInt32LE(frame.seq >>> 0, 4);
+  buf.writeBigUInt64LE(frame.sourceHash & U64_MASK, 8);
+  name.copy(buf, TALLY_FRAME_HEADER_LEN);
+  return buf;
+}
+
+/** Decode a tally frame; returns null for wrong magic/version/kind or a truncated buffer. */
+export function decodeTallyFrame(buf: Buffer): TallyFrame | null {
+  if (buf.length < TALLY_FRAME_HEADER_LEN || buf[0] !== TALLY_FRAME_MAGIC) return null;
+  if ((buf[1] >> 4) !== TALLY_FRAME_VERSION || (buf[1] & 0x0f) !== TallyFrameKind.Tally) return null;
+  const nameLen = buf[3];
+  if (nameLen > TALLY_FRAME_MAX_NAME || buf.length < TALLY_FRAME_HEADER_LEN + nameLen) return null;
+  const flags = buf[2];
+  return {
+    seq: buf.readUInt32LE(4),
+    sourceHash: buf.readBigUInt64LE(8),
+    program: (flags & TALLY_FLAG_PROGRAM) !== 0,
+    preview: (flags & TALLY_FLAG_PREVIEW) !== 0,
+    recording: (flags & TALLY_FLAG_RECORDING) !== 0,
+    streaming: (flags & TALLY_FLAG_STREAMING) !== 0,
+    name: buf.toString('utf8', TALLY_FRAME_HEADER_LEN, TALLY_FRAME_HEADER_LEN + nameLen)
+  };
+}
+
+export function encodeSnapshotFrame(frame: SnapshotFrame): Buffer {
+  const slotCount = Math.min(frame.slots.length, TALLY_SNAPSHOT_MAX_SLOTS);
+  const planeBytes = (slotCount + 7) >> 3;
+  const name = truncateUtf8(Buffer.from(frame.name, 'utf8'), TALLY_FRAME_MAX_NAME);
+  const buf = Buffer.alloc(TALLY_FRAME_HEADER_LEN + planeBytes * 4 + name.length);
+  buf[0] = TALLY_FRAME_MAGIC;
+  buf[1] = (TALLY_FRAME_VERSION << 4) | TallyFrameKind.Snapshot;
+  buf[2] = frame.multicast ? TALLY_SNAPSHOT_FLAG_MULTICAST : 0;
+  buf[3] = name.length;
+  buf.writeUInt32LE(frame.seq >>> 0, 4);
+  buf.writeUInt16LE(frame.tableEpoch & 0xffff, 8);
+  buf.writeUInt16LE(slotCount, 10);
+  buf.writeUInt16LE(frame.programSlot & 0xffff, 12);
+  const base = TALLY_FRAME_HEADER_LEN;
+  for (let slot = 0; slot < slotCount; slot++) {
+    const bits = frame.slots[slot];
+    const byte = slot >> 3;
+    const mask = 1 << (slot & 7);
+    if (bits.program) buf[base + byte] |= mask;
+    if (bits.preview) buf[base + planeBytes + byte] |= mask;
+    if (bits.recording) buf[base + planeBytes * 2 + byte] |= mask;
+    if (bits.streaming) buf[base + planeBytes * 3 + byte] |= mask;
+  }
+  name.copy(buf, base + planeBytes * 4);
+  return buf;
+}
+
+/** Decode a snapshot frame; returns null for wrong magic/version/kind or a truncated buffer. */
+export function decodeSnapshotFrame(buf: Buffer): SnapshotFrame | null {
+  if (buf.length < TALLY_FRAME_HEADER_LEN || buf[0] !== TALLY_FRAME_MAGIC) return null;
+  if ((buf[1] >> 4) !== TALLY_FRAME_VERSION || (buf[1] & 0x0f) !== TallyFrameKind.Snapshot) return null;
+  const nameLen = buf[3];
+  const slotCount = buf.readUInt16LE(10);
+  const planeBytes = (slotCount + 7) >> 3;
+  const nameStart = TALLY_FRAME_HEADER_LEN + planeBytes * 4;
+  if (slotCount > TALLY_SNAPSHOT_MAX_SLOTS || nameLen > TALLY_FRAME_MAX_NAME || buf.length < nameStart + nameLen) return null;
+  const bit = (plane: number, slot: number) =>
+    (buf[TALLY_FRAME_HEADER_LEN + plane * planeBytes + (slot >> 3)] & (1 << (slot & 7))) !== 0;
+  const slots: TallyBits[] = [];
+  for (let slot = 0; slot < slotCount; slot++) {
+    slots.push({ program: bit(0, slot), preview: bit(1, slot), recording: bit(2, slot), streaming: bit(3, slot) });
+  }
+  return {
+    seq: buf.readUInt32LE(4),
+    tableEpoch: buf.readUInt16LE(8),
+    programSlot: buf.readUInt16LE(12),
+    slots,
+    name: buf.toString('utf8', nameStart, nameStart + nameLen),
+    multicast: (buf[2] & TALLY_SNAPSHOT_FLAG_MULTICAST) !== 0
+  };
+}
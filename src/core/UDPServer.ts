@@ -1,8 +1,28 @@
 import { createSocket, Socket } from 'dgram';
+import { randomBytes } from 'crypto';
 import os from 'os';
 import bonjour from 'bonjour';
 import { TallyHub } from './TallyHub';
 import { TallyDevice, TallyState } from '../types';
+import {
+  PROTO_BINARY_TALLY,
+  PROTO_SNAPSHOT,
+  TALLY_CAP_BINARY,
+  TALLY_CAP_JSON_TALLY,
+  TALLY_CAP_MULTICAST,
+  TALLY_CAP_SEQ,
+  TALLY_CAP_SNAPSHOT,
+  TALLY_CAP_TALLY_ACK,
+  TALLY_CAP_SYNC,
+  TALLY_MAX_DATAGRAM,
+  TALLY_NO_SLOT,
+  TALLY_SNAPSHOT_MAX_SLOTS,
+  TALLY_SNAPSHOT_FLAG_MULTICAST,
+  TallyBits,
+  encodeSnapshotFrame,
+  encodeTallyFrame,
+  fnv1a64
+} from './TallyProtocol';
 
 interface M5Device {
   id: string;
@@ -10,8 +30,50 @@ interface M5Device {
   port: number;
   lastSeen: Date;
   device: TallyDevice;
+  protocol: number; // protocol level advertised at registration (0 = JSON only, see TallyProtocol.ts)
+  multicast: boolean; // receives snapshots through the multicast group instead of unicast
+  session: string; // resume token handed out in `registered`, new on every full registration
+  features: number; // TALLY_CAP_* set negotiated at registration (0 = device sent no `caps`)
+  maxDatagram: number; // largest datagram the device accepts
+  display?: { width: number; height: number }; // screen size in pixels, when advertised
+  snapshotTally?: string; // epoch:slot:bits of its source in the last snapshot it was sent (acked devices)
+  passive: boolean; // registered with `standby: true`: only registered/heartbeat_ack until it resumes here
 }
 
+/** An on-air change a device has not acknowledged yet (see trackTallyAck) */
+interface PendingTallyAck {
+  seq: number;
+  snapshot: boolean; // acked with `snap` (snapshot seq) rather than `seq` (per-source version)
+  frame: Buffer;     // exactly what was sent, resent as is
+  attempt: number;
+  timer: NodeJS.Timeout;
+}
+
+/** What a register message settles: see negotiate() */
+interface Negotiation {
+  protocol: number;
+  multicast: boolean;
+  features: number;
+  maxDatagram: number;
+  display?: { width: number; height: number };
+}
+
+/** Everything this hub can send; a device's `caps` are masked by it */
+const HUB_CAPS = TALLY_CAP_JSON_TALLY | TALLY_CAP_BINARY | TALLY_CAP_SNAPSHOT | TALLY_CAP_MULTICAST | TALLY_CAP_SEQ |
+  TALLY_CAP_TALLY_ACK | TALLY_CAP_SYNC;
+
+/** Gaps between retransmissions of an unacknowledged tally transition; after the last one the hub gives up */
+const TALLY_RETRANSMIT_MS = [30, 60, 120, 240];
+
+/** Multicast snapshots are re-sent this often so devices can tell the group still reaches them */
+const MULTICAST_REFRESH_MS = 2000;
+
+/** A device silent for less than this may `resume` its session instead of registering again */
+const SESSION_GRACE_MS = 120000;
+
+/** Devices clamp register_required's retryAfter to this (TALLY_RETRY_AFTER_MAX_MS in firmware) */
+const REGISTER_RETRY_AFTER_MAX_MS = 120000;
+
 interface TrackedAdminMessage {
   id: string;
   text: string;
@@ -32,10 +94,30 @@ export class UDPServer {
   private readonly maxAdminMessages = 50;
   private mdns: ReturnType<typeof bonjour> | null = null;
   private mdnsService: any = null;
+  private tallySeq: Map<string, { seq: number; state: number }> = new Map(); // per-source state version
+  private sourceHashes: Map<string, bigint> = new Map(); // memoized fnv1a64(sourceId)
+  private sourceSlots: Map<string, number> = new Map(); // append-only sourceId -> snapshot slot
+  private slotSources: string[] = [];                   // slot -> sourceId
+  private slotEpoch = Math.floor(Math.random() * 0x10000);
+  private snapshotSeq = 0;
+  private snapshotPending = false;
+  private lastSnapshotFrame: Buffer | null = null; // unicast form of the last snapshot sent, replayed by sync
+  private multicastGroup: string | null;
+  private multicastRefreshInterval: NodeJS.Timeout | null = null;
+  private registerSlotMs: number;   // one re-registration per slot (REGISTER_RATE per second)
+  private registerSlotAt = 0;       // next free re-registration slot, Date.now() ms
+  private leaderEpoch: number;      // start time in seconds, or 0 with HUB_STANDBY (see sendToAddress)
+  private pendingTallyAcks: Map<string, PendingTallyAck> = new Map(); // deviceId -> unacked transition
+  private tallyRetransmits = 0;
+  private tallyAckTimeouts = 0;
 
   constructor(tallyHub: TallyHub) {
     this.tallyHub = tallyHub;
     this.port = parseInt(process.env.UDP_PORT || '7411');
+    this.multicastGroup = this.resolveMulticastGroup();
+    // A restarted hub gets a higher epoch than the one that took over meanwhile, so devices fail back to it
+    this.leaderEpoch = process.env.HUB_STANDBY ? 0 : Math.floor(Date.now() / 1000);
+    this.registerSlotMs = Math.round(1000 / Math.max(1, parseInt(process.env.REGISTER_RATE || '20') || 20));
     this.setupEventHandlers();
   }
 
@@ -59,11 +141,32 @@ export class UDPServer {
     return cleaned;
   }
 
+  /** MULTICAST_GROUP (default 239.255.74.11) unless DISABLE_MULTICAST is set; must be an IPv4 multicast address. */
+  private resolveMulticastGroup(): string | null {
+    if (process.env.DISABLE_MULTICAST) return null;
+    const group = process.env.MULTICAST_GROUP || '239.255.74.11';
+    const octets = group.split('.').map(Number);
+    const valid = octets.length === 4 && octets.every(o => Number.isInteger(o) && o >= 0 && o <= 255) &&
+      octets[0] >= 224 && octets[0] <= 239;
+    if (!valid) {
+      console.warn(`MULTICAST_GROUP ${group} is not an IPv4 multicast address - using unicast only`);
+      return null;
+    }
+    return group;
+  }
+
   private setupEventHandlers(): void {
     this.tallyHub.on('tally:update', (tallyState: TallyState) => {
+      this.slotFor(tallyState.id);
+      this.scheduleSnapshot();
       this.broadcastTallyUpdate(tallyState);
     });
 
+    // OBS recording/streaming changes are overlaid on every source, so refresh the snapshot too
+    this.tallyHub.on('status:update', () => {
+      this.scheduleSnapshot();
+    });
+
     this.tallyHub.on('device:notify', ({ device, tallyState }: { device: TallyDevice, tallyState: TallyState }) => {
       if (device.type === 'm5stick' || device.type === 'ESP32') {
         this.sendToM5Device(device.id, tallyState);
@@ -114,6 +217,7 @@ export class UDPServer {
     }
     // broadcast to all
     for (const m5Device of this.m5Devices.values()) {
+      if (m5Device.passive) continue;
       this.sendToAddress(m5Device.address, m5Device.port, payload);
     }
   }
@@ -148,6 +252,16 @@ export class UDPServer {
         } else {
           console.log('📣 mDNS disabled via DISABLE_MDNS env var');
         }
+        if (this.multicastGroup) {
+          try {
+            this.socket!.setMulticastTTL(1); // tally never needs to leave the local segment
+            this.socket!.setMulticastLoopback(false);
+            console.log(`📡 Multicast snapshots to ${this.multicastGroup} for devices that opt in`);
+          } catch (e) {
+            console.warn('Multicast setup failed, using unicast only:', e);
+            this.multicastGroup = null;
+          }
+        }
         resolve();
       });
 
@@ -172,6 +286,8 @@ export class UDPServer {
           console.log(`📊 M5 devices: ${activeDevices} active`);
         }
       }, 60000); // Clean up every minute
+
+      this.multicastRefreshInterval = setInterval(() => this.flushSnapshot(true), MULTICAST_REFRESH_MS);
     });
   }
 
@@ -184,12 +300,16 @@ export class UDPServer {
         case 'discover':
           // Lightweight auto-discovery request from firmware devices.
           // Reply unicast with hub network coordinates so device can persist them.
-          this.handleDiscovery(rinfo);
+          this.handleDiscovery(message, rinfo);
           break;
         case 'register':
           this.handleDeviceRegistration(message, rinfo);
           break;
 
+        case 'resume':
+          this.handleResume(message, rinfo);
+          break;
+
         case 'heartbeat':
           this.handleHeartbeat(message, rinfo);
           break;
@@ -197,9 +317,19 @@ export class UDPServer {
         case 'status':
           this.handleStatusUpdate(message, rinfo);
           break;
+        case 'ping':
+          // Older firmware's periodic socket test
+          this.noteDeviceTraffic(message, rinfo);
+          break;
         case 'admin_message_ack':
           this.handleAdminMessageAck(message, rinfo);
           break;
+        case 'tally_ack':
+          this.handleTallyAck(message, rinfo);
+          break;
+        case 'sync':
+          this.handleSync(message, rinfo);
+          break;
 
         default:
           console.warn(`Unknown UDP message type: ${message.type} from ${deviceKey}`);
@@ -224,13 +354,15 @@ export class UDPServer {
     return '0.0.0.0';
   }
 
-  private handleDiscovery(rinfo: any): void {
+  /** Devices collect every reply for a short window and rank hubs by the round trip of the echoed `t` */
+  private handleDiscovery(message: any, rinfo: any): void {
     const payload = {
       type: 'discover_reply',
       hubIp: this.getLocalIPv4(),
       udpPort: this.port,
       apiPort: parseInt(process.env.PORT || '3000'),
-      timestamp: new Date()
+      timestamp: new Date(),
+      ...(typeof message.t === 'number' ? { t: message.t } : {})
     };
     this.sendToAddress(rinfo.address, rinfo.port, payload);
   }
@@ -238,6 +370,9 @@ export class UDPServer {
   /** Graceful shutdown allowing tests / electron app to stop networking & mDNS */
   public async stop(): Promise<void> {
     if (this.cleanupInterval) clearInterval(this.cleanupInterval);
+    if (this.multicastRefreshInterval) clearInterval(this.multicastRefreshInterval);
+    for (const pending of this.pendingTallyAcks.values()) clearTimeout(pending.timer);
+    this.pendingTallyAcks.clear();
     if (this.mdnsService) {
       try { this.mdnsService.stop(() => {}); } catch {}
       this.mdnsService = null;
@@ -266,6 +401,9 @@ export class UDPServer {
     // Extract assignment information from registration message
     const deviceHasAssignment = message.isAssigned === true && message.assignedSource;
     const deviceAssignedSource = message.assignedSource || undefined;
+    const { protocol, multicast, features, maxDatagram, display } = this.negotiate(message);
+    // A device's standby hub: it fails over to us with a resume, and until then wants no tally
+    const passive = message.standby === true;
 
     // Check if this device is already registered (either by key or by device ID)
     const existingByKey = this.m5Devices.get(deviceKey);
@@ -277,6 +415,13 @@ export class UDPServer {
       existingByKey.device.lastSeen = new Date();
       existingByKey.device.connected = true;
       existingByKey.device.type = deviceType as 'ESP32' | 'm5stick';
+      existingByKey.protocol = protocol;
+      existingByKey.multicast = multicast;
+      existingByKey.features = features;
+      existingByKey.maxDatagram = maxDatagram;
+      existingByKey.display = display;
+      existingByKey.passive = passive;
+      existingByKey.session = randomBytes(8).toString('hex');
       
       // Update device ID if it has changed (device was reconfigured)
       if (existingByKey.id !== deviceId) {
@@ -323,7 +468,14 @@ export class UDPServer {
         address: rinfo.address,
         port: rinfo.port,
         lastSeen: new Date(),
-        device
+        device,
+        protocol,
+        multicast,
+        session: randomBytes(8).toString('hex'),
+        features,
+        maxDatagram,
+        display,
+        passive
       };
 
       this.m5Devices.set(deviceKey, m5Device);
@@ -347,7 +499,14 @@ export class UDPServer {
         address: rinfo.address,
         port: rinfo.port,
         lastSeen: new Date(),
-        device
+        device,
+        protocol,
+        multicast,
+        session: randomBytes(8).toString('hex'),
+        features,
+        maxDatagram,
+        display,
+        passive
       };
 
       this.m5Devices.set(deviceKey, m5Device);
@@ -355,17 +514,118 @@ export class UDPServer {
       this.handleAssignmentSync(deviceId, deviceHasAssignment, deviceAssignedSource);
       console.log(`📡 Device registered: ${deviceName} (${deviceType.toUpperCase()}) (${rinfo.address}:${rinfo.port})`);
     }
+    if (passive) this.dropPendingTallyAck(deviceId); // it has made another hub its active one
+    if (features) {
+      console.log(`📡 ${deviceId} negotiated features 0x${features.toString(16)}, max datagram ${maxDatagram}` +
+        (display ? `, display ${display.width}x${display.height}` : ''));
+    }
+
+    this.sendRegistered(this.m5Devices.get(deviceKey)!, deviceAssignedSource, false);
+
+    // Devices that negotiated TALLY_CAP_SYNC ask for the current tally state themselves (handleSync);
+    // snapshot devices also get the snapshot scheduled by sendRegistered()
+  }
+
+  /**
+   * Settle what a registering device gets. With `caps` the hub picks the cheapest tally encoding both
+   * sides support (snapshots, then binary frames, then JSON) and reports it as `features`; older devices
+   * only state a `proto` level. Devices offer multicast with `mcast: true` and withdraw it (mcast: false)
+   * when the group stops reaching them.
+   */
+  private negotiate(message: any): Negotiation {
+    const maxDatagram = typeof message.maxDatagram === 'number' && message.maxDatagram >= 256
+      ? Math.min(message.maxDatagram, TALLY_MAX_DATAGRAM) : TALLY_MAX_DATAGRAM;
+    const display = typeof message.display?.w === 'number' && typeof message.display?.h === 'number'
+      ? { width: message.display.w, height: message.display.h } : undefined;
+
+    if (typeof message.caps !== 'number') {
+      const protocol = typeof message.proto === 'number' ? message.proto : 0;
+      const multicast = this.multicastGroup !== null && protocol >= PROTO_SNAPSHOT && message.mcast === true;
+      return { protocol, multicast, features: 0, maxDatagram, display };
+    }
+
+    const offered = message.caps & HUB_CAPS;
+    let features = offered & (TALLY_CAP_SEQ | TALLY_CAP_TALLY_ACK | TALLY_CAP_SYNC);
+    let protocol = 0;
+    if ((offered & TALLY_CAP_SNAPSHOT) && (offered & TALLY_CAP_BINARY)) {
+      features |= TALLY_CAP_SNAPSHOT | TALLY_CAP_BINARY;
+      protocol = PROTO_SNAPSHOT;
+    } else if (offered & TALLY_CAP_BINARY) {
+      features |= TALLY_CAP_BINARY;
+      protocol = PROTO_BINARY_TALLY;
+    } else {
+      features |= TALLY_CAP_JSON_TALLY;
+    }
+    const multicast = this.multicastGroup !== null && protocol >= PROTO_SNAPSHOT &&
+      (offered & TALLY_CAP_MULTICAST) !== 0 && message.mcast === true;
+    if (multicast) features |= TALLY_CAP_MULTICAST;
+    return { protocol, multicast, features, maxDatagram, display };
+  }
+
+  /**
+   * Session resume: a device that was registered less than SESSION_GRACE_MS ago presents the token from
+   * its `registered` reply instead of a full register. Its entry (name, type, protocol) is still here, so
+   * the hub only moves it to the sender's address and confirms. No assignment message is sent unless the
+   * assignment changed while the device was away.
+   */
+  private handleResume(message: any, rinfo: any): void {
+    const deviceKey = `${rinfo.address}:${rinfo.port}`;
+    const entry = Array.from(this.m5Devices.entries()).find(([_, device]) => device.id === message.deviceId);
+    const m5Device = entry?.[1];
+    if (!entry || !m5Device || typeof message.session !== 'string' || m5Device.session !== message.session ||
+        Date.now() - m5Device.lastSeen.getTime() > SESSION_GRACE_MS) {
+      const retryAfter = this.nextRegisterSlot();
+      console.log(`📡 Resume refused for ${message.deviceId} (${deviceKey}), requesting registration in ${retryAfter}ms`);
+      this.sendToAddress(rinfo.address, rinfo.port, {
+        type: 'register_required',
+        message: 'Session expired, please register',
+        retryAfter,
+        timestamp: new Date()
+      });
+      return;
+    }
+
+    if (entry[0] !== deviceKey) {
+      console.log(`📡 Device moved: ${m5Device.id} from ${entry[0]} to ${deviceKey}`);
+      this.m5Devices.delete(entry[0]);
+      this.m5Devices.set(deviceKey, m5Device);
+      m5Device.address = rinfo.address;
+      m5Device.port = rinfo.port;
+      m5Device.device.ipAddress = rinfo.address;
+    }
+    m5Device.lastSeen = new Date();
+    m5Device.device.lastSeen = new Date();
+    m5Device.device.connected = true;
+    m5Device.passive = false; // failing over to us ends a standby registration
+    m5Device.multicast = this.multicastGroup !== null && m5Device.protocol >= PROTO_SNAPSHOT && message.mcast === true;
+    if (m5Device.features !== 0) {
+      m5Device.features = m5Device.multicast ? m5Device.features | TALLY_CAP_MULTICAST : m5Device.features & ~TALLY_CAP_MULTICAST;
+    }
+    this.tallyHub.updateDeviceLastSeen(m5Device.id);
+
+    const deviceAssignedSource = message.assignedSource || undefined;
+    this.handleAssignmentSync(m5Device.id, !!deviceAssignedSource, deviceAssignedSource);
+    this.sendRegistered(m5Device, deviceAssignedSource, true);
+    console.log(`📡 Session resumed: ${m5Device.device.name} (${deviceKey})`);
+  }
 
-    // Send registration confirmation
-    this.sendToAddress(rinfo.address, rinfo.port, {
+  /**
+   * Confirm a registration or resume. When the device's stored assignment already matches the hub,
+   * handleAssignmentSync() sends nothing, so the snapshot slot for it rides along here instead.
+   */
+  private sendRegistered(m5Device: M5Device, deviceAssignedSource: string | undefined, resumed: boolean): void {
+    const assignment = this.tallyHub.getDeviceAssignments().find(a => a.deviceId === m5Device.id);
+    const inSync = m5Device.protocol >= PROTO_SNAPSHOT && assignment && assignment.sourceId === deviceAssignedSource;
+    this.sendToAddress(m5Device.address, m5Device.port, {
       type: 'registered',
-      deviceId,
-      timestamp: new Date()
+      deviceId: m5Device.id,
+      timestamp: new Date(),
+      ...(resumed ? { resumed: true } : { session: m5Device.session, sessionTtl: SESSION_GRACE_MS }),
+      ...(m5Device.features ? { features: m5Device.features } : {}),
+      ...(inSync ? this.slotInfo(assignment.sourceId) : {}),
+      ...(m5Device.multicast ? { mcastGroup: this.multicastGroup } : {})
     });
-
-    // Note: M5 devices now only work in assigned mode
-    // They will only receive tally updates for their assigned source
-    // No need to send all tally states on registration
+    if (m5Device.protocol >= PROTO_SNAPSHOT && !m5Device.passive) this.scheduleSnapshot();
   }
 
   private handleHeartbeat(message: any, rinfo: any): void {
@@ -376,28 +636,57 @@ export class UDPServer {
       m5Device.lastSeen = new Date();
       this.tallyHub.updateDeviceLastSeen(m5Device.id);
 
-      // Send heartbeat response
+      // Send heartbeat response; echoing the device's `t` lets it measure round-trip time
       this.sendToAddress(rinfo.address, rinfo.port, {
         type: 'heartbeat_ack',
-        timestamp: new Date()
+        timestamp: new Date(),
+        ...(typeof message.t === 'number' ? { t: message.t } : {})
       });
     } else {
-      // Unknown device sending heartbeat - prompt it to register
-      console.log(`📡 Unknown device heartbeat from ${rinfo.address}:${rinfo.port}, requesting registration`);
+      // Unknown device sending heartbeat - prompt it to register, in its own slot
+      const retryAfter = this.nextRegisterSlot();
+      console.log(`📡 Unknown device heartbeat from ${rinfo.address}:${rinfo.port}, requesting registration in ${retryAfter}ms`);
       this.sendToAddress(rinfo.address, rinfo.port, {
         type: 'register_required',
         message: 'Please register with the hub',
+        retryAfter,
         timestamp: new Date()
       });
     }
   }
 
+  /**
+   * Milliseconds until the next free re-registration slot. After a hub restart every device's next
+   * heartbeat earns a register_required; handing out consecutive slots turns that burst into a steady
+   * REGISTER_RATE per second (devices add up to a quarter of retryAfter as jitter).
+   */
+  private nextRegisterSlot(): number {
+    const now = Date.now();
+    const slot = Math.max(now, this.registerSlotAt);
+    this.registerSlotAt = slot + this.registerSlotMs;
+    return Math.min(slot - now + this.registerSlotMs, REGISTER_RETRY_AFTER_MAX_MS);
+  }
+
+  /**
+   * Any message from a registered device is proof of life. A message that carries `t` stands in for the
+   * device's heartbeat, and is answered with heartbeat_ack, so devices piggyback probes on acks they send
+   * anyway and skip the separate heartbeat.
+   */
+  private noteDeviceTraffic(message: any, rinfo: any): M5Device | undefined {
+    const m5Device = this.m5Devices.get(`${rinfo.address}:${rinfo.port}`);
+    if (!m5Device) return undefined;
+    m5Device.lastSeen = new Date();
+    this.tallyHub.updateDeviceLastSeen(m5Device.id);
+    if (typeof message.t === 'number') {
+      this.sendToAddress(rinfo.address, rinfo.port, { type: 'heartbeat_ack', timestamp: new Date(), t: message.t });
+    }
+    return m5Device;
+  }
+
   private handleStatusUpdate(message: any, rinfo: any): void {
-    const deviceKey = `${rinfo.address}:${rinfo.port}`;
-    const m5Device = this.m5Devices.get(deviceKey);
+    const m5Device = this.noteDeviceTraffic(message, rinfo);
 
     if (m5Device) {
-      m5Device.lastSeen = new Date();
       // Handle any status updates from the M5 device
       console.log(`Status update from ${m5Device.device.name}:`, message.data);
     }
@@ -405,7 +694,7 @@ export class UDPServer {
 
   private handleAdminMessageAck(message: any, rinfo: any): void {
     const deviceKey = `${rinfo.address}:${rinfo.port}`;
-    const m5Device = this.m5Devices.get(deviceKey);
+    const m5Device = this.noteDeviceTraffic(message, rinfo);
     const summary = (message && message.textSnippet) ? message.textSnippet : '';
     const msgId = message.id as string | undefined;
     if (m5Device) {
@@ -435,10 +724,24 @@ export class UDPServer {
     }));
   }
 
+  /** Every JSON message carries the leadership epoch; devices with a standby hub follow the live hub with the higher one. */
   private sendToAddress(address: string, port: number, message: any): void {
+    this.sendBuffer(address, port, this.encodeJson(message));
+  }
+
+  private encodeJson(message: any): Buffer {
+    return Buffer.from(JSON.stringify({ ...message, epoch: this.leaderEpoch }));
+  }
+
+  /** `limit` is the receiving device's negotiated maxDatagram where one device is addressed */
+  private sendBuffer(address: string, port: number, buffer: Buffer, limit = TALLY_MAX_DATAGRAM): void {
     if (!this.socket) return;
+    if (buffer.length > limit) {
+      // Devices reject these unparsed rather than act on a truncated message, so don't send them at all
+      console.warn(`⚠️ Not sending ${buffer.length}-byte message to ${address}:${port} (device limit ${limit} bytes)`);
+      return;
+    }
 
-    const buffer = Buffer.from(JSON.stringify(message));
     this.socket.send(buffer, port, address, (error) => {
       if (error) {
         console.error(`Error sending UDP message to ${address}:${port}:`, error);
@@ -446,20 +749,317 @@ export class UDPServer {
     });
   }
 
+  /**
+   * Per-source state version carried as `seq` by binary and JSON tally messages. It only moves when the
+   * bits sent for the source change, so re-sends of the same state (broadcast + assigned notify, several
+   * devices on one source) share a number and devices can drop older or duplicate updates.
+   */
+  private tallyVersion(tallyState: TallyState, program: boolean): number {
+    const state = (program ? 1 : 0) | (tallyState.preview ? 2 : 0) | (tallyState.recording ? 4 : 0) | (tallyState.streaming ? 8 : 0);
+    const entry = this.tallySeq.get(tallyState.id);
+    if (entry && entry.state === state) return entry.seq;
+    const seq = entry ? (entry.seq + 1) >>> 0 || 1 : 1; // 0 means "unsequenced" on the device
+    this.tallySeq.set(tallyState.id, { seq, state });
+    return seq;
+  }
+
+  /** Encode a tally state as a binary frame (see TallyProtocol.ts). */
+  private encodeTally(tallyState: TallyState, program: boolean): Buffer {
+    const seq = this.tallyVersion(tallyState, program);
+    let sourceHash = this.sourceHashes.get(tallyState.id);
+    if (sourceHash === undefined) {
+      sourceHash = fnv1a64(tallyState.id);
+      this.sourceHashes.set(tallyState.id, sourceHash);
+    }
+    return encodeTallyFrame({
+      seq,
+      sourceHash,
+      program,
+      preview: tallyState.preview,
+      recording: tallyState.recording || false,
+      streaming: tallyState.streaming || false,
+      name: this.cleanSourceName(tallyState.name)
+    });
+  }
+
+  private supportsBinaryTally(m5Device: M5Device): boolean {
+    return m5Device.protocol >= PROTO_BINARY_TALLY;
+  }
+
+  private supportsSnapshot(deviceId: string): boolean {
+    for (const m5Device of this.m5Devices.values()) {
+      if (m5Device.id === deviceId) return m5Device.protocol >= PROTO_SNAPSHOT && !m5Device.passive;
+    }
+    return false;
+  }
+
+  /**
+   * Snapshot slot for a source. Slots are append-only so a device only has to learn its slot
+   * once per assignment; when the table fills up it is cleared under a new epoch and every
+   * snapshot-capable device is re-sent its assignment (and with it the new slot).
+   */
+  private slotFor(sourceId: string): number {
+    const existing = this.sourceSlots.get(sourceId);
+    if (existing !== undefined) return existing;
+
+    if (this.slotSources.length >= TALLY_SNAPSHOT_MAX_SLOTS) {
+      this.sourceSlots.clear();
+      this.slotSources = [];
+      this.slotEpoch = (this.slotEpoch + 1) & 0xffff;
+      console.log(`📡 Snapshot slot table full - starting epoch ${this.slotEpoch}`);
+      const slot = this.allocateSlot(sourceId);
+      this.resendSnapshotAssignments();
+      return slot;
+    }
+    return this.allocateSlot(sourceId);
+  }
+
+  private allocateSlot(sourceId: string): number {
+    const slot = this.slotSources.length;
+    this.slotSources.push(sourceId);
+    this.sourceSlots.set(sourceId, slot);
+    return slot;
+  }
+
+  private slotInfo(sourceId: string): { slot: number; slotEpoch: number } {
+    const slot = this.slotFor(sourceId);
+    return { slot, slotEpoch: this.slotEpoch };
+  }
+
+  private resendSnapshotAssignments(): void {
+    for (const assignment of this.tallyHub.getDeviceAssignments()) {
+      if (this.supportsSnapshot(assignment.deviceId)) {
+        this.sendAssignmentToDevice(assignment.deviceId, assignment.sourceId, assignment.sourceName || `Source ${assignment.sourceId}`);
+      }
+    }
+  }
+
+  /** Coalesce every tally change of one event-loop turn (a cut touches several sources) into one snapshot. */
+  private scheduleSnapshot(): void {
+    if (this.snapshotPending) return;
+    this.snapshotPending = true;
+    setImmediate(() => {
+      this.snapshotPending = false;
+      this.flushSnapshot();
+    });
+  }
+
+  /**
+   * Send the current snapshot: unicast to snapshot devices that are not on multicast, and once per
+   * listening port to the multicast group (the firmwares bind different local ports). refreshOnly
+   * is the periodic multicast resend that doubles as the devices' liveness signal.
+   */
+  private flushSnapshot(refreshOnly = false): void {
+    const unicastTargets: M5Device[] = [];
+    const groupPorts = new Set<number>();
+    const ackTargets: M5Device[] = [];
+    for (const m5Device of this.m5Devices.values()) {
+      if (m5Device.protocol < PROTO_SNAPSHOT || m5Device.passive) continue;
+      if (m5Device.multicast) groupPorts.add(m5Device.port);
+      else if (!refreshOnly) unicastTargets.push(m5Device);
+      if ((m5Device.multicast || !refreshOnly) && (m5Device.features & TALLY_CAP_TALLY_ACK)) ackTargets.push(m5Device);
+    }
+    if (unicastTargets.length === 0 && groupPorts.size === 0) return;
+
+    const tallies = new Map<string, TallyState>();
+    for (const tally of this.tallyHub.getTallies()) tallies.set(tally.id, tally);
+
+    const obsStatus = this.tallyHub.getObsGlobalStatus();
+    const off: TallyBits = { program: false, preview: false, recording: false, streaming: false };
+    const slots = this.slotSources.map((sourceId): TallyBits => {
+      const tally = tallies.get(sourceId);
+      if (!tally) return off;
+      return {
+        program: tally.program,
+        preview: tally.preview,
+        recording: !!(tally.recording || obsStatus?.recording),
+        streaming: !!(tally.streaming || obsStatus?.streaming)
+      };
+    });
+
+    // Same filter as broadcastTallyUpdate(): only program buses count as "the live source"
+    let programSlot = TALLY_NO_SLOT;
+    let liveName = '';
+    for (let slot = 0; slot < this.slotSources.length; slot++) {
+      const id = this.slotSources[slot];
+      if (!slots[slot].program || !this.isProgramBusSource(id)) continue;
+      programSlot = slot;
+      liveName = this.cleanSourceName(tallies.get(id)!.name);
+      break;
+    }
+
+    // The seq is a state version: flushes that find nothing changed (the multicast refresh, registrations,
+    // syncs) resend the last frame as is, so devices take them as duplicates
+    let frame = encodeSnapshotFrame({
+      seq: this.snapshotSeq,
+      tableEpoch: this.slotEpoch,
+      programSlot,
+      slots,
+      name: liveName
+    });
+    const last = this.lastSnapshotFrame;
+    if (last && last.length === frame.length && last.compare(frame, 0, 4, 0, 4) === 0 &&
+        last.compare(frame, 8, frame.length, 8, last.length) === 0) {
+      frame = last;
+    } else {
+      this.snapshotSeq = (this.snapshotSeq + 1) >>> 0 || 1; // 0 means "unsequenced" on the device
+      frame.writeUInt32LE(this.snapshotSeq, 4);
+      this.lastSnapshotFrame = frame;
+    }
+    for (const m5Device of unicastTargets) {
+      this.sendBuffer(m5Device.address, m5Device.port, frame, m5Device.maxDatagram);
+    }
+    if (groupPorts.size > 0) {
+      const groupFrame = Buffer.from(frame);
+      groupFrame[2] |= TALLY_SNAPSHOT_FLAG_MULTICAST;
+      for (const port of groupPorts) {
+        this.sendBuffer(this.multicastGroup!, port, groupFrame);
+      }
+    }
+
+    // Devices that ack get their own source's transitions retransmitted (as unicast) until they do
+    if (ackTargets.length === 0) return;
+    const assigned = new Map(this.tallyHub.getDeviceAssignments().map(a => [a.deviceId, a.sourceId]));
+    for (const m5Device of ackTargets) {
+      const sourceId = assigned.get(m5Device.id);
+      const slot = sourceId !== undefined ? this.sourceSlots.get(sourceId) : undefined;
+      if (slot === undefined || slot >= slots.length) continue;
+      const bits = slots[slot];
+      const state = `${this.slotEpoch}:${slot}:${+bits.program}${+bits.preview}${+bits.recording}${+bits.streaming}`;
+      if (state === m5Device.snapshotTally) continue;
+      m5Device.snapshotTally = state;
+      this.trackTallyAck(m5Device, this.snapshotSeq, true, frame);
+    }
+  }
+
+  /**
+   * Remember a tally transition sent to a device that acks them, and resend it after each TALLY_RETRANSMIT_MS
+   * gap until `tally_ack` covers it. A newer transition replaces the pending one, which it supersedes.
+   * Devices ack duplicates again, so a lost ack costs one more retransmit at most.
+   */
+  private trackTallyAck(m5Device: M5Device, seq: number, snapshot: boolean, frame: Buffer): void {
+    if (!(m5Device.features & TALLY_CAP_TALLY_ACK) || seq === 0) return;
+    const previous = this.pendingTallyAcks.get(m5Device.id);
+    if (previous) clearTimeout(previous.timer);
+    const pending = { seq, snapshot, frame, attempt: 0 } as PendingTallyAck;
+    const retransmit = () => {
+      if (this.pendingTallyAcks.get(m5Device.id) !== pending) return;
+      if (pending.attempt >= TALLY_RETRANSMIT_MS.length) {
+        this.pendingTallyAcks.delete(m5Device.id);
+        this.tallyAckTimeouts++;
+        console.warn(`⚠️ ${m5Device.id} did not ack tally ${snapshot ? 'snapshot' : 'seq'} ${seq} after ${pending.attempt} retransmits`);
+        return;
+      }
+      this.tallyRetransmits++;
+      this.sendBuffer(m5Device.address, m5Device.port, frame, m5Device.maxDatagram);
+      pending.timer = setTimeout(retransmit, TALLY_RETRANSMIT_MS[pending.attempt++]);
+    };
+    pending.timer = setTimeout(retransmit, TALLY_RETRANSMIT_MS[pending.attempt++]);
+    this.pendingTallyAcks.set(m5Device.id, pending);
+  }
+
+  private dropPendingTallyAck(deviceId: string): void {
+    const pending = this.pendingTallyAcks.get(deviceId);
+    if (!pending) return;
+    clearTimeout(pending.timer);
+    this.pendingTallyAcks.delete(deviceId);
+  }
+
+  /** `{type:'tally_ack', seq}` or `{type:'tally_ack', snap}`: the device shows that state version (or a newer one) */
+  private handleTallyAck(message: any, rinfo: any): void {
+    const m5Device = this.noteDeviceTraffic(message, rinfo);
+    if (!m5Device) return;
+    const pending = this.pendingTallyAcks.get(m5Device.id);
+    if (!pending) return;
+    const acked = pending.snapshot ? message.snap : message.seq;
+    // Versions only move forward (mod 2^32): anything at or past the pending one covers it
+    if (typeof acked === 'number' && ((acked - pending.seq) >>> 0) < 0x80000000) {
+      clearTimeout(pending.timer);
+      this.pendingTallyAcks.delete(m5Device.id);
+    }
+  }
+
+  /**
+   * `{type:'sync', scope:'assigned'|'all'}` from a device that has just registered or resumed: replay the
+   * current tally state in the encoding it negotiated, one datagram ("page") each, then `sync_done` with
+   * the page count. Snapshot devices get the current snapshot, which covers every source in one page.
+   * Otherwise the pages are the assigned source plus, for scope 'all', the program bus on air (what
+   * broadcastTallyUpdate() sends for live tracking). Every page carries its state version, so replaying
+   * state the device already shows is dropped there as a duplicate.
+   */
+  private handleSync(message: any, rinfo: any): void {
+    const m5Device = this.noteDeviceTraffic(message, rinfo);
+    if (!m5Device || m5Device.passive) return; // unknown: its next heartbeat is answered with register_required
+    let pages = 0;
+    if (m5Device.protocol >= PROTO_SNAPSHOT) {
+      // A change still waiting for setImmediate would make the replay stale: send it now instead
+      if (this.snapshotPending || !this.lastSnapshotFrame) this.flushSnapshot();
+      if (this.lastSnapshotFrame) {
+        this.sendBuffer(m5Device.address, m5Device.port, this.lastSnapshotFrame, m5Device.maxDatagram);
+        pages++;
+      }
+    } else {
+      const sourceId = this.tallyHub.getDeviceAssignments().find(a => a.deviceId === m5Device.id)?.sourceId;
+      for (const tallyState of this.tallyHub.getTallies()) {
+        const live = message.scope === 'all' && tallyState.program && this.isProgramBusSource(tallyState.id);
+        if (tallyState.id !== sourceId && !live) continue;
+        this.sendBuffer(m5Device.address, m5Device.port, this.encodeTallyFor(m5Device, tallyState));
+        pages++;
+      }
+    }
+    this.sendToAddress(m5Device.address, m5Device.port, {
+      type: 'sync_done',
+      pages,
+      ...(m5Device.protocol >= PROTO_SNAPSHOT ? { snap: this.snapshotSeq } : {})
+    });
+  }
+
+  /** One source's tally in the device's encoding: a binary frame, or the JSON form sendToM5Device() uses */
+  private encodeTallyFor(m5Device: M5Device, tallyState: TallyState): Buffer {
+    if (this.supportsBinaryTally(m5Device)) return this.encodeTally(tallyState, tallyState.program);
+    return this.encodeJson({
+      type: 'tally',
+      data: {
+        id: tallyState.id,
+        name: this.cleanSourceName(tallyState.name),
+        preview: tallyState.preview,
+        program: tallyState.program,
+        recording: tallyState.recording || false,
+        streaming: tallyState.streaming || false,
+        seq: this.tallyVersion(tallyState, tallyState.program)
+      }
+    });
+  }
+
+  /** Retransmission counters for the unacked-tally path */
+  public getTallyAckStats(): { pending: number; retransmits: number; timeouts: number } {
+    return { pending: this.pendingTallyAcks.size, retransmits: this.tallyRetransmits, timeouts: this.tallyAckTimeouts };
+  }
+
+  private isProgramBusSource(id: string): boolean {
+    return id.startsWith('obs-scene-') || id.startsWith('vmix-input-') || id.startsWith('atem-input-');
+  }
+
   public sendToDevice(deviceId: string, message: any): void {
     // Find the M5 device by deviceId
     for (const m5Device of this.m5Devices.values()) {
       if (m5Device.device.id === deviceId) {
-        this.sendToAddress(m5Device.address, m5Device.port, message);
+        if (!m5Device.passive) this.sendToAddress(m5Device.address, m5Device.port, message);
         return;
       }
     }
     console.log(`⚠️ M5 device ${deviceId} not found for sending message`);
   }
 
-  private sendToM5Device(deviceId: string, tallyState: TallyState): void {
+  /** Snapshot devices get their source's change with the next snapshot, which is also what they ack */
+  public sendToM5Device(deviceId: string, tallyState: TallyState): void {
     for (const m5Device of this.m5Devices.values()) {
       if (m5Device.id === deviceId) {
+        if (m5Device.passive) break;
+        if (m5Device.protocol >= PROTO_SNAPSHOT) {
+          this.scheduleSnapshot();
+          break;
+        }
         const message = {
           type: 'tally',
           data: {
@@ -468,12 +1068,15 @@ export class UDPServer {
             preview: tallyState.preview,
             program: tallyState.program,
             recording: tallyState.recording || false,  // Include recording status
-            streaming: tallyState.streaming || false   // Include streaming status
+            streaming: tallyState.streaming || false,  // Include streaming status
+            seq: this.tallyVersion(tallyState, tallyState.program)
           }
         };
         
         console.log(`📡 Sending to M5 device ${deviceId}: ${JSON.stringify(message.data)}`);
-        this.sendToAddress(m5Device.address, m5Device.port, message);
+        const frame = this.supportsBinaryTally(m5Device) ? this.encodeTally(tallyState, tallyState.program) : this.encodeJson(message);
+        this.sendBuffer(m5Device.address, m5Device.port, frame);
+        this.trackTallyAck(m5Device, message.data.seq, false, frame);
         break;
       }
     }
@@ -486,9 +1089,7 @@ export class UDPServer {
 
     // Only broadcast OBS scenes (not individual OBS sources) to avoid overlays/logos being treated as live.
     // Allow vMix inputs and ATEM inputs as they represent program buses.
-    const id = tallyState.id || '';
-    if (id.startsWith('obs-source-')) return; // skip OBS sources
-    if (!(id.startsWith('obs-scene-') || id.startsWith('vmix-input-') || id.startsWith('atem-input-'))) return;
+    if (!this.isProgramBusSource(tallyState.id || '')) return;
 
     const message = {
       type: 'tally',
@@ -498,12 +1099,20 @@ export class UDPServer {
         preview: tallyState.preview,
         program: true,
         recording: tallyState.recording || false,
-        streaming: tallyState.streaming || false
+        streaming: tallyState.streaming || false,
+        seq: this.tallyVersion(tallyState, true)
       }
     };
 
+    let frame: Buffer | null = null; // encoded once, shared by every binary-capable device
     for (const m5Device of this.m5Devices.values()) {
-      this.sendToAddress(m5Device.address, m5Device.port, message);
+      if (m5Device.protocol >= PROTO_SNAPSHOT || m5Device.passive) continue; // live source arrives with the snapshot
+      if (this.supportsBinaryTally(m5Device)) {
+        if (!frame) frame = this.encodeTally(tallyState, true);
+        this.sendBuffer(m5Device.address, m5Device.port, frame);
+      } else {
+        this.sendToAddress(m5Device.address, m5Device.port, message);
+      }
     }
   }
 
@@ -531,14 +1140,17 @@ export class UDPServer {
   public sendAssignmentToDevice(deviceId: string, sourceId: string, sourceName: string): void {
     for (const m5Device of this.m5Devices.values()) {
       if (m5Device.id === deviceId) {
+        if (m5Device.passive) return; // its resume here carries the assignment it shows
         this.sendToAddress(m5Device.address, m5Device.port, {
           type: 'assignment',
           data: {
             mode: 'assigned',
             sourceId: sourceId,
-            sourceName: this.cleanSourceName(sourceName) // Clean the source name for assignment too
+            sourceName: this.cleanSourceName(sourceName), // Clean the source name for assignment too
+            ...(m5Device.protocol >= PROTO_SNAPSHOT ? this.slotInfo(sourceId) : {})
           }
         });
+        if (m5Device.protocol >= PROTO_SNAPSHOT) this.scheduleSnapshot();
         console.log(`📡 Sent assignment notification to ${m5Device.device.name}: ${this.cleanSourceName(sourceName)}`);
         return;
       }
@@ -549,6 +1161,7 @@ export class UDPServer {
   public sendUnassignmentToDevice(deviceId: string): void {
     for (const m5Device of this.m5Devices.values()) {
       if (m5Device.id === deviceId) {
+        if (m5Device.passive) return;
         this.sendToAddress(m5Device.address, m5Device.port, {
           type: 'assignment',
           data: {
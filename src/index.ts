@@ -83,7 +83,8 @@ class TallyHubServer {
         timestamp: new Date(),
         tallies: this.tallyHub.getTallies(),
         devices: this.tallyHub.getDevices(),
-        mixers: this.tallyHub.getMixerConnections()
+        mixers: this.tallyHub.getMixerConnections(),
+        tallyAcks: this.udpServer.getTallyAckStats()
       });
     });
 